@@ -0,0 +1,31 @@
+#ifndef BOARD_JSON_H
+#define BOARD_JSON_H
+
+#include <Arduino.h>
+#include "ChessEngine.h"
+
+/**
+ * BoardJson.h
+ *
+ * JSON bodies of /api/status and /api/board, and the board deltas pushed
+ * over SSE. WebInterface builds them from its engine and versioned board;
+ * they live here so they build without the web server, which lets the
+ * native benchmark (test/test_engine_bench) time them on the host.
+ */
+
+// Two-character piece code used by the web client ("wp", "bk", ...), "" for no piece
+const char* pieceCodeText(uint8_t piece);
+
+// GET /api/status for the engine's position
+String buildStatusJSON(ChessEngine& engine);
+
+// {"epoch":E,"version":V,"full":true,"board":[["br","bn",...],...]} - board holds
+// engine piece codes, square 0 first
+String buildBoardJSON(const uint8_t board[64], uint32_t epoch, uint32_t version);
+
+// {"epoch":E,"version":V,"full":false,"changes":[[square,"wp"],[square,""],...]}
+// for the squares set in changed. Returns the length written.
+size_t buildBoardDeltaJSON(char* buffer, size_t size, const uint8_t board[64], uint32_t epoch,
+                           uint32_t version, uint64_t changed);
+
+#endif // BOARD_JSON_H
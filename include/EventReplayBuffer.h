@@ -0,0 +1,60 @@
+#ifndef EVENT_REPLAY_BUFFER_H
+#define EVENT_REPLAY_BUFFER_H
+
+#include <Arduino.h>
+
+/**
+ * EventReplayBuffer.h
+ *
+ * The last few SSE events sent to one session, numbered 1, 2, 3... so a
+ * browser whose EventSource reconnects (its Last-Event-ID header names the
+ * last event it saw) can be sent just the ones it missed.
+ *
+ * Messages are copied into one fixed byte ring; the oldest events are dropped
+ * to make room, by count or by bytes. IDs keep counting regardless, so a
+ * reader can tell from getFirstId() whether everything it missed is still
+ * here. Nothing allocates, so this also builds natively.
+ */
+
+#define SSE_REPLAY_EVENTS 24   // Events kept per session
+#define SSE_REPLAY_BYTES 5120  // Message bytes kept per session - fits the largest wrapped gameFull
+
+class EventReplayBuffer {
+public:
+    EventReplayBuffer() { clear(); }
+
+    // Forget everything and number from 1 again - for a new session
+    void clear();
+
+    // Copies the message and returns its ID. event must be a string literal.
+    // A message too large to keep clears the buffer, so it shows up as a gap.
+    uint32_t add(const char* event, const char* message);
+
+    uint32_t getLastId() const { return _nextId - 1; }
+    // Oldest ID still kept, getLastId() + 1 if none
+    uint32_t getFirstId() const { return _count ? _entries[_head].id : _nextId; }
+    int getCount() const { return _count; }
+
+    // Kept events oldest first, index 0 .. getCount() - 1
+    void get(int index, uint32_t& id, const char*& event, const char*& message) const;
+
+private:
+    struct Entry {
+        uint32_t id;
+        const char* event;
+        uint16_t offset;
+        uint16_t length;  // Without the NUL
+    };
+
+    Entry _entries[SSE_REPLAY_EVENTS];
+    char _data[SSE_REPLAY_BYTES];
+    int _head;            // Oldest entry
+    int _count;
+    uint16_t _writePos;   // Where the next message goes, wrapping to 0 when it does not fit
+    uint32_t _nextId;
+
+    bool overlapsKept(uint16_t offset, uint16_t size) const;
+    void dropOldest();
+};
+
+#endif // EVENT_REPLAY_BUFFER_H
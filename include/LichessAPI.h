@@ -2,15 +2,22 @@
 #define LICHESS_API_H
 
 #include <Arduino.h>
+#include <atomic>
 #include <HTTPClient.h>
 #include <WiFiClientSecure.h>
 #include <vector>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include "LichessConnectionPool.h"
+#include "MoveTrace.h"
 
 /**
  * LichessAPI.h
  *
  * Handles Lichess Board API integration for human vs AI chess gameplay
  * Uses non-bot Board API endpoints for regular Lichess accounts
+ * TLS connections are borrowed from a shared LichessConnectionPool, whose
+ * worker task runs the HTTPS calls - process() only submits and polls them
  *
  * Key Features:
  * - Create AI challenge games
@@ -21,14 +28,32 @@
 
 class LichessAPI {
 public:
+    // Command pipeline - see queueMove() and friends
+    enum CommandType { CMD_CREATE_GAME, CMD_MAKE_MOVE, CMD_RESIGN, CMD_DRAW };
+    enum CommandStatus { CMD_QUEUED, CMD_RUNNING, CMD_DONE, CMD_FAILED, CMD_CANCELLED };
+
+    struct CommandUpdate {
+        uint32_t id;
+        CommandType type;
+        CommandStatus status;
+        String detail;          // Move or game ID, or the error for a failed command
+    };
+
     LichessAPI();
     ~LichessAPI();
 
     // Initialize with API token
     bool begin(const char* apiToken);
 
-    // Test account connection
-    bool testAccount(String& username);
+    // Connections come from the pool shared by all sessions - required before any request
+    void setConnectionPool(LichessConnectionPool* pool) { _pool = pool; }
+
+    // Account check, polled from request handlers without waiting for the
+    // worker: the first call submits it and returns ACCOUNT_CHECK_PENDING,
+    // later calls return the result once (username set, or getLastError())
+    // and the call after that starts a fresh check
+    enum AccountCheck : uint8_t { ACCOUNT_CHECK_PENDING, ACCOUNT_CHECK_OK, ACCOUNT_CHECK_FAILED };
+    AccountCheck pollAccountCheck(String& username);
 
     // Create new AI game
     // Returns gameId on success, empty string on failure
@@ -41,14 +66,29 @@ public:
     // Resign current game
     bool resignGame(const String& gameId);
 
-    // Stream handling (non-blocking)
+    // Offer (or accept) a draw - accept = false declines the opponent's offer
+    bool offerDraw(const String& gameId, bool accept = true);
+
+    // Stream handling (non-blocking) - startStream() queues the connection;
+    // isStreaming() turns true once process() sees it open
     bool startStream(const String& gameId);
     void stopStream();
     bool isStreaming() const { return _streaming; }
+    bool isStreamOpening() const { return _streamRequest != nullptr; }
 
     // Process stream events (call regularly in loop)
-    // Returns true if new event available
-    bool processStreamEvents(String& eventJson);
+    // Returns true if a new event line is available; it points into the stream
+    // connection's buffer and stays valid until the next call
+    bool processStreamEvents(char*& eventJson, size_t& length);
+
+    // Stream watchdog - a game stream that misses LICHESS_MISSED_HEARTBEATS
+    // keepalives or is dropped by the server is reopened with backoff. The
+    // gameFull it starts with carries every move made meanwhile.
+    bool isStreamRecovering() const { return _streamRecovering; }
+    // True once after a recovered stream has opened
+    bool takeStreamRecovered();
+    unsigned long getStreamReconnectCount() const { return _streamReconnects; }
+    unsigned long getStreamSilence() const;  // ms since the open stream last delivered anything
 
     // Process async operations - call regularly from main loop
     void process();
@@ -71,9 +111,35 @@ public:
     bool hasToken() const { return _apiToken.length() > 0; }
     int getTokenLength() const { return _apiToken.length(); }
 
-    // Queue management
-    bool queueCreateGame(int level, int timeLimit, int increment, const String& color);
-    int getQueueSize() const { return _requestQueue.size(); }
+    // Command pipeline - commands run one at a time, in order, from process().
+    // Each returns the command's ID, or 0 if the queue is full. Queueing a
+    // command identical to the last one queued (or the running one, when none
+    // is queued) returns that one's ID, so a double click is sent once while a
+    // premove repeated later in the line is not dropped. A queued move waits
+    // until it is the player's turn (a premove). A resign cancels the moves and
+    // draw offers queued for its game, a new game those of every game. Safe to
+    // call from request handlers while loop() runs process().
+    uint32_t queueCreateGame(int level, int timeLimit, int increment, const String& color);
+    // receivedAt is when the browser's request arrived, for the move's trace (0: now)
+    uint32_t queueMove(const String& gameId, const String& uciMove, unsigned long receivedAt = 0);
+    uint32_t queueResign(const String& gameId);
+    uint32_t queueDrawOffer(const String& gameId, bool accept = true);
+    int getQueueSize() const;
+    bool hasQueuedMove() const;
+
+    // Turn on the Lichess board, from the game stream - gates queued moves
+    void setPlayerToMove(bool playerToMove) { _playerToMove = playerToMove; }
+    // The game ended or was reset: cancel the moves and draw offers queued for
+    // it (every game if gameId is empty) and stop holding moves for a reply
+    // that will never come. Safe to call from request handlers.
+    void endGame(const String& gameId, const char* reason);
+
+    // Next command status change (queued, running, done, failed, cancelled),
+    // oldest first. Returns false when there is none.
+    bool popCommandUpdate(CommandUpdate& update);
+
+    static const char* commandTypeName(CommandType type);
+    static const char* commandStatusName(CommandStatus status);
 
     // Emergency reset - clears all state and returns to IDLE
     void forceReset();
@@ -82,20 +148,57 @@ public:
     bool isConnectionHealthy();
     void resetConnection();
 
+    // Dual connection mode - moves go out on the pool's API connection while the
+    // game stream stays open. Used only while the heap can hold both; otherwise
+    // the stream is paused for the move as before.
+    void setDualConnection(bool enabled) { _dualConnectionEnabled = enabled; }
+    bool isDualConnectionEnabled() const { return _dualConnectionEnabled; }
+    bool canUseDualConnection() const;
+
+    // Move round-trip latency (makeMove() until the server accepts it), in ms
+    unsigned long getLastMoveLatency() const { return _lastMoveLatency; }
+    unsigned long getAverageMoveLatency() const { return _movesTimed ? _totalMoveLatency / _movesTimed : 0; }
+    unsigned long getMovesTimed() const { return _movesTimed; }
+    bool wasLastMoveDual() const { return _lastMoveDual; }
+
+    // TLS handshake metrics - requests sent on a kept-alive connection skip the handshake
+    unsigned long getHandshakeCount() const { return _handshakeCount; }
+    unsigned long getLastHandshakeTime() const { return _lastHandshakeTime; }
+    unsigned long getAverageHandshakeTime() const { return _handshakeCount ? _totalHandshakeTime / _handshakeCount : 0; }
+    unsigned long getReusedConnectionCount() const { return _reusedConnections; }
+
+    // Move tracing - each queued move is timed stage by stage (see MoveTrace.h)
+    // until it comes back on the game stream, and recorded here and in the
+    // device-wide metrics set with setMoveMetrics()
+    void setMoveMetrics(MoveMetrics* metrics) { _deviceMoveMetrics = metrics; }
+    const MoveMetrics& getMoveMetrics() const { return _moveMetrics; }
+    // The game stream has shown the position after this many plies - a traced
+    // move that landed on or before it has been echoed
+    void traceStreamPly(int ply);
+
 private:
     // Request queue structure
     struct QueuedRequest {
-        enum Type { CREATE_GAME, MAKE_MOVE, RESIGN_GAME };
-        Type type;
+        uint32_t id;
+        CommandType type;
         String gameId;
         String move;
         int level;
         int timeLimit;
         int increment;
         String color;
+        bool accept;            // Draw: offer/accept or decline
+        unsigned long receivedAt;  // Move: when the browser's request arrived
     };
 
+    // Request handlers queue commands while loop() runs them and drains the
+    // updates - these four are only touched under _commandLock
     std::vector<QueuedRequest> _requestQueue;
+    QueuedRequest _activeCommand;       // id 0 when no command is running
+    std::vector<CommandUpdate> _commandUpdates;
+    uint32_t _nextCommandId;
+    SemaphoreHandle_t _commandLock;
+    std::atomic<bool> _playerToMove;    // Set by loop(), lifted by endGame() from request handlers too
     // Async state machine states
     enum State {
         STATE_IDLE,
@@ -105,26 +208,40 @@ private:
         STATE_RESUMING_STREAM,          // Resuming stream after move
         STATE_RESIGNING_GAME,           // Resigning the game
         STATE_CREATING_GAME,            // Creating a new game
+        STATE_OFFERING_DRAW,            // Offering, accepting or declining a draw
         STATE_STARTING_STREAM,          // Starting stream for new game
         STATE_RETRYING_CONNECTION       // Waiting to retry failed connection
     };
 
-    // Single SSL client shared between operations (ESP32 doesn't have enough RAM for 2)
-    WiFiClientSecure _client;
-    HTTPClient _http;
-    HTTPClient _streamHttp;
+    // Shared connections - API calls take the pool's API connection for one
+    // request, the stream leases a stream connection while it is open
+    LichessConnectionPool* _pool;
+    LichessConnectionPool::StreamConnection* _stream;
+
+    // Requests in flight on the pool's worker
+    LichessConnectionPool::Request* _request;        // API call of the current operation
+    LichessConnectionPool::Request* _streamRequest;  // Stream being opened
 
     // Stream handling
     WiFiClient* _streamClient;
     bool _streaming;
-    String _streamBuffer;
+    String _streamGameId;
+    unsigned long _streamOpenedAt;
+
+    // Stream watchdog
+    bool _streamRecovering;         // Reopen the stream once _streamReconnectAt passes
+    bool _streamRecovered;
+    unsigned long _streamReconnectAt;
+    unsigned long _streamReconnectDelay;
+    unsigned long _streamReconnects;
 
     // Async state machine
     State _state;
     unsigned long _stateStartTime;
     String _pendingGameId;
     String _pendingMove;
-    bool _wasStreaming;
+    bool _wasStreaming;             // Stream was paused for the pending operation
+    bool _dualConnectionEnabled;
     int _retryAttempt;
     unsigned long _retryDelay;
 
@@ -137,6 +254,7 @@ private:
     int _pendingTimeLimit;
     int _pendingIncrement;
     String _pendingColor;
+    bool _pendingDrawAccept;
 
     // Configuration
     String _apiToken;
@@ -146,32 +264,78 @@ private:
     unsigned long _lastHeartbeatTime;
     unsigned long _heartbeatCount;
 
+    // Move latency tracking
+    unsigned long _moveStartTime;
+    unsigned long _lastMoveLatency;
+    unsigned long _totalMoveLatency;
+    unsigned long _movesTimed;
+    bool _lastMoveDual;
+
+    // Move tracing
+    MoveTrace _moveTrace;           // Queued move in flight, kept until its echo
+    MoveMetrics _moveMetrics;
+    MoveMetrics* _deviceMoveMetrics;
+    int _streamPly;                 // Plies in the last position seen on the stream, -1 if none
+
+    // TLS connection reuse tracking
+    unsigned long _handshakeCount;
+    unsigned long _lastHandshakeTime;
+    unsigned long _totalHandshakeTime;
+    unsigned long _reusedConnections;
+
     // Connection health tracking
     int _consecutiveFailures;
     unsigned long _lastSuccessfulRequest;
+    unsigned long _accountCheckStart;  // When the account check in _request was submitted
     static constexpr int MAX_CONSECUTIVE_FAILURES = 3;
 
+    // Command pipeline limits
+    static constexpr size_t MAX_QUEUED_COMMANDS = 8;
+    static constexpr size_t MAX_COMMAND_UPDATES = 16;
+
     // API endpoints
-    static constexpr const char* LICHESS_HOST = "lichess.org";
-    static constexpr const char* API_ACCOUNT = "https://lichess.org/api/account";
-    static constexpr const char* API_CHALLENGE_AI = "https://lichess.org/api/challenge/ai";
-    static constexpr const char* API_BOARD_GAME_STREAM = "https://lichess.org/api/board/game/stream/";
-    static constexpr const char* API_BOARD_GAME_MOVE = "https://lichess.org/api/board/game/";
+    static constexpr const char* LICHESS_HOST = LICHESS_SERVER_HOST;
+    static constexpr const char* API_ACCOUNT = LICHESS_BASE_URL "/api/account";
+    static constexpr const char* API_CHALLENGE_AI = LICHESS_BASE_URL "/api/challenge/ai";
+    static constexpr const char* API_BOARD_GAME_STREAM = LICHESS_BASE_URL "/api/board/game/stream/";
+    static constexpr const char* API_BOARD_GAME_MOVE = LICHESS_BASE_URL "/api/board/game/";
 
     // Timing constants (milliseconds)
     static constexpr unsigned long STREAM_STOP_DELAY = 50;
     static constexpr unsigned long SSL_CLEANUP_DELAY = 500;
     static constexpr unsigned long RETRY_INITIAL_DELAY = 1000;
     static constexpr unsigned long STREAM_RESUME_DELAY = 500;
+    static constexpr unsigned long STREAM_RECONNECT_INITIAL_DELAY = 500;
+    static constexpr unsigned long STREAM_RECONNECT_MAX_DELAY = 30000;
     static constexpr unsigned long OPERATION_TIMEOUT = 30000;  // 30 second timeout for operations
+    static constexpr unsigned long ACCOUNT_CHECK_TIMEOUT = 20000;
 
     // Helper methods
-    bool makeAPICall(const char* url, const char* method, const String& body, String& response, bool enableRetry = true);
+    void releaseStreamConnection();
+    bool submitAPICall(const String& url, const char* method, const String& body, bool enableRetry = true);
+    bool finishAPICall(String& response, bool& success);
+    void completeStreamOpen();
+    void cancelRequests();
+    void recordHandshake(const LichessConnectionPool::Request* request);
     void setError(const String& error);
+    void setCircuitError(unsigned long retryIn);
+    void recoverStream(const char* reason);
+    void processStreamRecovery();
     void runNetworkDiagnostics();
     bool parseNDJSON(String& line);
+    void lockCommands() const;
+    void unlockCommands() const;
+    // enqueueCommand() and cancelGameCommands() take _commandLock; findDuplicateCommand() and reportCommand() need it held
+    uint32_t enqueueCommand(QueuedRequest& command);
+    const QueuedRequest* findDuplicateCommand(const QueuedRequest& command) const;
+    void cancelGameCommands(const String& gameId, const char* reason);
     void processQueue();
+    void finishCommand(bool success);
+    void reportCommand(const QueuedRequest& command, CommandStatus status, const String& detail);
     bool checkOperationTimeout();
+    void beginMoveTrace(const QueuedRequest& command);
+    void completeMoveTrace();
+    void dropMoveTrace(bool accepted);
 };
 
 #endif // LICHESS_API_H
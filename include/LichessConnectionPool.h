@@ -0,0 +1,255 @@
+#ifndef LICHESS_CONNECTION_POOL_H
+#define LICHESS_CONNECTION_POOL_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <HTTPClient.h>
+#include <WiFiClientSecure.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+#include "NdjsonFramer.h"
+#include "LichessRateLimiter.h"
+
+/**
+ * LichessConnectionPool.h
+ *
+ * Fixed set of TLS connections to lichess.org shared by every session
+ * - One keep-alive API connection that sessions take turns making requests on
+ * - LICHESS_STREAM_CONNECTIONS game stream connections, leased one per streaming game
+ * - A worker task that runs every blocking HTTPS call (handshake, request,
+ *   response headers) so a slow Lichess call never stalls loop()
+ *
+ * The TLS clients are the bulk of what a session used to cost, so sessions
+ * now hold only a LichessAPI handle with their game state and borrow
+ * connections from here.
+ *
+ * Requests are submitted into fixed slots and polled for completion. The
+ * submitter must not touch a request between submit and isDone(); once done
+ * it reads the results and hands the slot back with finishRequest(). The
+ * worker stores DONE with release order after writing the results and
+ * isDone() loads it with acquire, so the results are visible once it is seen.
+ *
+ * Failed attempts are never waited out on the worker: a retry is scheduled
+ * with jittered backoff and the worker carries on with other requests. Each
+ * endpoint class has a circuit breaker - after repeated failures, or a 429
+ * from Lichess, requests of that class fail at once without touching the
+ * network until the breaker lets a single trial through.
+ *
+ * All sessions share one token, so every attempt also takes a token from
+ * LichessRateLimiter first. A request without one waits in the retry list,
+ * where moves go ahead of stream opens, challenges and account checks.
+ */
+
+#define LICHESS_STREAM_CONNECTIONS 4  // Concurrent game streams (each ~40KB heap while connected)
+#define LICHESS_REQUEST_SLOTS 16      // Requests queued or in flight across all sessions
+#define LICHESS_WORKER_STACK 12288    // mbedTLS handshake runs on the worker's stack
+#define LICHESS_WORKER_PRIORITY 1     // Same as loop() - neither starves the other
+#define LICHESS_RATE_BURST 8          // Requests sent back to back across all sessions
+#define LICHESS_RATE_INTERVAL 250     // ms per request once the burst is spent (240/min)
+#define LICHESS_HEARTBEAT_INTERVAL 7000  // Lichess writes a keepalive line to idle streams about this often
+#define LICHESS_MISSED_HEARTBEATS 3      // Silent intervals before a stream is treated as dead
+#define LICHESS_STREAM_STALL_TIMEOUT (LICHESS_HEARTBEAT_INTERVAL * LICHESS_MISSED_HEARTBEATS)
+
+// Server the Lichess classes talk to - build flags point them at
+// tools/lichess_stub_server.py instead (see env:lichess_stub)
+#ifndef LICHESS_SERVER_HOST
+#define LICHESS_SERVER_HOST "lichess.org"
+#endif
+#ifndef LICHESS_SERVER_PORT
+#define LICHESS_SERVER_PORT 443
+#endif
+#define LICHESS_STRINGIFY_(x) #x
+#define LICHESS_STRINGIFY(x) LICHESS_STRINGIFY_(x)
+#if LICHESS_SERVER_PORT == 443
+#define LICHESS_BASE_URL "https://" LICHESS_SERVER_HOST
+#else
+#define LICHESS_BASE_URL "https://" LICHESS_SERVER_HOST ":" LICHESS_STRINGIFY(LICHESS_SERVER_PORT)
+#endif
+
+class LichessConnectionPool {
+public:
+    // Endpoint classes with separate circuit breakers - a rate limited
+    // challenge endpoint should not stop moves in running games
+    enum Endpoint : uint8_t { ENDPOINT_ACCOUNT, ENDPOINT_CHALLENGE, ENDPOINT_BOARD, ENDPOINT_STREAM, ENDPOINT_COUNT };
+    enum BreakerState : uint8_t { BREAKER_CLOSED, BREAKER_OPEN, BREAKER_HALF_OPEN };
+
+    struct BreakerStatus {
+        BreakerState state;
+        uint8_t failures;            // Consecutive failed attempts
+        unsigned long retryIn;       // ms until a trial request is let through, 0 unless open
+        unsigned long trips;         // Times the breaker has opened
+        int lastFailureCode;         // HTTP status or HTTPClient error of the last failure
+    };
+
+    // httpCode of a request refused because its endpoint's breaker is open
+    static constexpr int HTTP_CIRCUIT_OPEN = -100;
+
+    struct StreamConnection {
+        WiFiClientSecure client;
+        HTTPClient http;
+        NdjsonFramer framer;  // Splits the stream into events in place
+        const void* owner;    // Leasing LichessAPI or event stream, nullptr if free - the pool
+                              // itself while the worker finishes an open its owner abandoned
+    };
+
+    // One HTTPS call run by the worker. Either an API request on the shared
+    // API connection, or opening a stream on a leased stream connection
+    // (headers read, body left for the owner to read).
+    struct Request {
+        enum Status : uint8_t { FREE, CLAIMED, QUEUED, RUNNING, DONE };
+
+        const void* owner;           // nullptr once abandoned
+        StreamConnection* stream;    // Stream to open, nullptr for an API request
+        String url;
+        String body;                 // Form body for POST
+        String token;
+        bool post;
+        bool retry;                  // Retry connection failures with backoff
+        Endpoint endpoint;
+        uint8_t attempts;
+        unsigned long retryAt;       // When the worker tries again after a failed or throttled attempt
+        unsigned long throttledSince; // First refused a rate limit token, 0 if never
+
+        // Results, valid once isDone()
+        int httpCode;                // HTTP status, or an HTTPClient error (< 0)
+        String response;             // Body of an API request (also on HTTP errors)
+        String error;                // Connection failure description
+        unsigned long retryAfter;    // ms to hold off after a 429, or left on an open breaker
+        bool reused;                 // Sent on a kept-alive connection
+        unsigned long handshakeTime; // Full TLS handshake in ms, 0 if reused
+        unsigned long queuedAt;
+        unsigned long startedAt;
+        unsigned long finishedAt;
+
+        std::atomic<uint8_t> status;  // A Status
+    };
+
+    LichessConnectionPool();
+
+    // Start the worker task - required before any request
+    bool begin();
+
+    // Queue a request - nullptr if every slot is taken (try again later)
+    Request* submitRequest(const void* owner, const String& url, bool post, const String& body,
+                           const String& token, bool retry);
+    Request* submitStreamOpen(const void* owner, StreamConnection* stream, const String& url, const String& token);
+    bool isDone(const Request* request) const {
+        return request->status.load(std::memory_order_acquire) == Request::DONE;
+    }
+    // Hand the slot back; returns true if the request had finished. A request
+    // still in flight is abandoned: the worker finishes it, closes the stream
+    // it was opening and frees the slot itself. The stream is the pool's from
+    // here, so it is not leased again - not even to its old owner - until then.
+    bool finishRequest(Request* request);
+    int getPendingRequestCount() const;
+
+    // Shared API connection - busy while the worker runs a request on it
+    bool isApiBusy() const { return _apiBusy; }
+    bool isApiConnected() const { return _apiConnected; }
+    // Closed by the worker before its next request
+    void closeApiConnection() { _closeApiRequested = true; }
+
+    // Stream connections - nullptr if all are leased or the heap cannot hold
+    // another TLS session, or if the owner's own connection still has an open
+    // in flight. Released connections are always closed. Safe from any task:
+    // the worker releases abandoned streams while loop() leases.
+    StreamConnection* acquireStream(const void* owner);
+    void releaseStream(StreamConnection* connection);
+    int getFreeStreamCount() const;
+
+    // Circuit breakers - read from any task. Callers check isCircuitOpen()
+    // before leasing a stream connection so an outage costs no TLS heap.
+    BreakerStatus getBreakerStatus(Endpoint endpoint) const;
+    bool isCircuitOpen(Endpoint endpoint) const { return getBreakerStatus(endpoint).retryIn > 0; }
+    static Endpoint classifyEndpoint(const String& url, bool stream);
+    static const char* endpointName(Endpoint endpoint);
+    static const char* breakerStateName(BreakerState state);
+
+    // Rate limiter state for an endpoint class - tokens left now and counters
+    struct RateStatus {
+        uint8_t tokens;
+        uint8_t globalTokens;
+        LichessRateLimiter::Counters counters;
+    };
+    RateStatus getRateStatus(Endpoint endpoint) const;
+
+    // Random delay in [delay / 2, delay] so sessions that failed together do not retry together
+    static unsigned long jitter(unsigned long delay);
+
+    // Whether another mbedTLS session fits: the 16KB input record buffer must
+    // fit in one block, plus output buffer and handshake state
+    bool hasHeapForConnection() const;
+
+private:
+    WiFiClientSecure _apiClient;
+    HTTPClient _apiHttp;
+    volatile bool _apiBusy;
+    volatile bool _apiConnected;
+    volatile bool _closeApiRequested;
+    unsigned long _lastApiUse;
+
+    StreamConnection _streams[LICHESS_STREAM_CONNECTIONS];
+
+    Request _requests[LICHESS_REQUEST_SLOTS];
+    QueueHandle_t _requestQueue;
+    TaskHandle_t _workerTask;
+    mutable portMUX_TYPE _requestMux;  // Also guards the breakers
+
+    struct CircuitBreaker {
+        BreakerState state;
+        uint8_t failures;
+        unsigned long openedAt;
+        unsigned long openTime;      // How long the current open period lasts
+        unsigned long trips;
+        int lastFailureCode;
+    };
+    CircuitBreaker _breakers[ENDPOINT_COUNT];
+    mutable LichessRateLimiter _limiter;  // Refills on read, guarded by _requestMux
+
+    // Requests waiting for a scheduled retry - worker task only
+    Request* _retrying[LICHESS_REQUEST_SLOTS];
+    int _retryCount;
+
+    Request* claimRequest(const void* owner);
+    bool isStreamOpening(const StreamConnection* connection) const;
+    bool queueRequest(Request* request);
+
+    // Worker task side
+    static void workerLoop(void* param);
+    void runRequest(Request* request);
+    bool runApiRequest(Request* request);
+    int sendApiRequest(Request* request);
+    void runStreamOpen(Request* request);
+    void runDueRetries();
+    TickType_t nextWorkerWait() const;
+    bool allowAttempt(Request* request);
+    bool takeRateToken(Request* request);
+    static uint8_t endpointPriority(Endpoint endpoint);
+    void recordOutcome(Request* request);
+    static unsigned long parseRetryAfter(const String& value);
+    bool connectClient(WiFiClientSecure& client, Request* request);
+    void closeIdleApiConnection();
+    void runNetworkDiagnostics();
+
+    // Kept-alive API connection is closed after this long unused, before the
+    // server drops it and the next request finds a dead socket
+    static constexpr unsigned long API_KEEPALIVE_IDLE = 30000;
+    static constexpr unsigned long WORKER_IDLE_POLL = 1000;
+    static constexpr unsigned long REQUEST_TIMEOUT = 15000;
+    static constexpr unsigned long STREAM_OPEN_TIMEOUT = 30000;
+    static constexpr unsigned long RETRY_INITIAL_DELAY = 1000;
+    static constexpr int MAX_ATTEMPTS = 3;
+    // Consecutive failed attempts that open a breaker, and how long it stays
+    // open - doubled each time the trial request fails too
+    static constexpr uint8_t BREAKER_THRESHOLD = 5;
+    static constexpr unsigned long BREAKER_OPEN_TIME = 10000;
+    static constexpr unsigned long BREAKER_MAX_OPEN_TIME = 300000;
+    // Lichess asks clients to wait a full minute after a 429 without Retry-After
+    static constexpr unsigned long RATE_LIMIT_PAUSE = 60000;
+    static constexpr uint32_t TLS_MIN_FREE_HEAP = 48000;
+    static constexpr uint32_t TLS_MIN_BLOCK = 18000;
+    static constexpr const char* LICHESS_HOST = LICHESS_SERVER_HOST;
+};
+
+#endif // LICHESS_CONNECTION_POOL_H
@@ -0,0 +1,58 @@
+#ifndef LICHESS_EVENT_STREAM_H
+#define LICHESS_EVENT_STREAM_H
+
+#include <Arduino.h>
+#include "LichessConnectionPool.h"
+
+/**
+ * LichessEventStream.h
+ *
+ * Account-level Lichess event stream (/api/stream/event)
+ * - One connection for every game on the account: gameStart, gameFinish, challenges
+ * - Leases a stream connection from the shared LichessConnectionPool while active;
+ *   the pool's worker opens it so loop() never waits on the handshake
+ * - Reconnects with backoff when the connection drops
+ *
+ * Moves are not on this stream, so games still open a per-game stream while
+ * they wait for the opponent - the event stream covers them the rest of the time.
+ */
+
+class LichessEventStream {
+public:
+    LichessEventStream();
+    ~LichessEventStream();
+
+    void begin(LichessConnectionPool* pool, const String& apiToken);
+
+    // Keep the stream open only while it has someone to route events to
+    void setActive(bool active);
+    bool isConnected() const { return _streamClient != nullptr; }
+
+    // Connects or reconnects as needed and returns the next complete JSON event,
+    // in place in the stream connection's buffer (valid until the next call).
+    // Call regularly from loop; returns false when no event is ready.
+    bool processEvents(char*& eventJson, size_t& length);
+
+private:
+    LichessConnectionPool* _pool;
+    LichessConnectionPool::StreamConnection* _stream;
+    LichessConnectionPool::Request* _connectRequest;  // Open in flight on the worker
+    WiFiClient* _streamClient;
+    String _apiToken;
+    bool _active;
+
+    unsigned long _nextConnectTime;
+    unsigned long _reconnectDelay;
+    unsigned long _connectedAt;
+
+    bool connect();
+    bool completeConnect();
+    void disconnect();
+    void scheduleReconnect();
+
+    static constexpr const char* API_STREAM_EVENT = LICHESS_BASE_URL "/api/stream/event";
+    static constexpr unsigned long RECONNECT_INITIAL_DELAY = 2000;
+    static constexpr unsigned long RECONNECT_MAX_DELAY = 60000;
+};
+
+#endif // LICHESS_EVENT_STREAM_H
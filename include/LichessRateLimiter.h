@@ -0,0 +1,71 @@
+#ifndef LICHESS_RATE_LIMITER_H
+#define LICHESS_RATE_LIMITER_H
+
+#include <Arduino.h>
+
+/**
+ * LichessRateLimiter.h
+ *
+ * Token buckets that pace requests made with the shared Lichess token, so
+ * several browsers together stay under Lichess's limits instead of getting
+ * the token throttled for everyone.
+ *
+ * Each budget (one per endpoint class) has its own bucket, and every request
+ * also takes a token from a global bucket. A budget's reserve is how many
+ * global tokens it must leave for others: low priority budgets (account
+ * checks) stop short of the last few, so moves still go out under load.
+ *
+ * Time is passed in by the caller and nothing allocates, so it also builds
+ * natively. Not thread safe - the connection pool calls it from its worker
+ * and guards the reads from other tasks.
+ */
+
+#define LICHESS_RATE_MAX_BUDGETS 4
+
+class LichessRateLimiter {
+public:
+    struct Counters {
+        unsigned long granted;      // Tokens handed out
+        unsigned long throttled;    // Requests that had to wait for a token
+        unsigned long totalDelay;   // ms throttled requests waited in all
+        unsigned long maxDelay;     // Longest wait of one request
+    };
+
+    LichessRateLimiter();
+
+    // Burst is the bucket size; one token comes back every interval ms
+    void setGlobalBudget(uint8_t burst, unsigned long interval, unsigned long now);
+    void setBudget(int budget, uint8_t burst, unsigned long interval, uint8_t reserve, unsigned long now);
+
+    // Take a token for a request on this budget. Returns 0 if it may go now,
+    // otherwise the ms until it is worth asking again.
+    unsigned long acquire(int budget, unsigned long now);
+
+    // A request that was refused earlier has now been granted after waiting -
+    // counted here rather than in acquire() so asking again is not a new throttle
+    void recordDelay(int budget, unsigned long delay);
+
+    uint8_t getTokens(int budget, unsigned long now);
+    uint8_t getGlobalTokens(unsigned long now);
+    const Counters& getCounters(int budget) const { return _counters[budget]; }
+
+private:
+    struct Bucket {
+        uint8_t tokens;
+        uint8_t burst;
+        unsigned long interval;
+        unsigned long lastRefill;
+    };
+
+    Bucket _global;
+    Bucket _buckets[LICHESS_RATE_MAX_BUDGETS];
+    uint8_t _reserve[LICHESS_RATE_MAX_BUDGETS];
+    Counters _counters[LICHESS_RATE_MAX_BUDGETS];
+
+    static void configure(Bucket& bucket, uint8_t burst, unsigned long interval, unsigned long now);
+    static void refill(Bucket& bucket, unsigned long now);
+    // ms until the bucket holds more than `keep` tokens, 0 if it already does
+    static unsigned long waitFor(const Bucket& bucket, uint8_t keep, unsigned long now);
+};
+
+#endif // LICHESS_RATE_LIMITER_H
@@ -3,8 +3,11 @@
 
 #include <Arduino.h>
 #include <ESPAsyncWebServer.h>
+#include <ArduinoJson.h>
 #include "LichessAPI.h"
 #include "SessionManager.h"
+#include "LichessEventStream.h"
+#include "EventReplayBuffer.h"
 
 /**
  * LichessWebHandler.h
@@ -12,6 +15,17 @@
  * Handles web endpoints for Lichess integration with multi-session support
  * Provides REST API and SSE streaming between browsers and Lichess
  * Supports multiple concurrent games from different browsers
+ *
+ * Events reach browsers on /api/lichess/stream?sessionId=<id>, which only
+ * carries that session's events. Each session slot has its own event source
+ * on that URL, picked by a request filter. There is no channel for clients
+ * without a session - one carrying every session's events would hand any
+ * browser on the network the other players' games.
+ *
+ * Session channel events are numbered per session and the last few are kept
+ * in an EventReplayBuffer, so a browser that reconnects with Last-Event-ID
+ * is sent what it missed - or an eventsMissed event when that is no longer
+ * kept, to resync from /api/lichess/status.
  */
 
 class LichessWebHandler {
@@ -36,8 +50,14 @@ private:
 
     String _apiToken;
 
-    // SSE clients tracking
-    AsyncEventSource* _eventSource;
+    // SSE clients tracking - one channel per session slot
+    AsyncEventSource* _sessionChannels[MAX_SESSIONS];
+    char _channelSessionIds[MAX_SESSIONS][SESSION_ID_LENGTH + 1];  // Session the slot's clients connected for
+    EventReplayBuffer* _replay[MAX_SESSIONS];  // Kept across sessions, nullptr until the slot's first event
+    SemaphoreHandle_t _replayLock;             // loop() adds events, AsyncTCP replays them on connect
+
+    // Account-wide game start/finish events, routed to sessions by game ID
+    LichessEventStream _accountEvents;
 
     // Handler methods (now session-aware)
     void handleTestAccount(AsyncWebServerRequest* request);
@@ -45,10 +65,12 @@ private:
     void handleCreateGame(AsyncWebServerRequest* request);
     void handleMakeMove(AsyncWebServerRequest* request);
     void handleResignGame(AsyncWebServerRequest* request);
+    void handleOfferDraw(AsyncWebServerRequest* request);
     void handleGetGameStatus(AsyncWebServerRequest* request);
     void handleReset(AsyncWebServerRequest* request);
     void handleCheckAdmin(AsyncWebServerRequest* request);
     void handleGetSessions(AsyncWebServerRequest* request);
+    void handleGetMetrics(AsyncWebServerRequest* request);
 
     // SSE stream management
     void setupSSEStream();
@@ -58,6 +80,19 @@ private:
     String getSessionIdFromRequest(AsyncWebServerRequest* request);
     void sendJSONResponse(AsyncWebServerRequest* request, int code, const String& message, bool success = true);
     void sendErrorResponse(AsyncWebServerRequest* request, int code, const String& error);
+    void sendCommandResponse(AsyncWebServerRequest* request, LichessAPI* api, uint32_t commandId, const char* startedStatus);
+    void forwardCommandUpdates();
+    bool syncSessionBoard(Session* session, const char* eventJson, size_t length);
+    void sendStreamRecovered(const Session* session, int missedPlies);
+    void sendSessionEvent(const Session* session, const char* eventJson, size_t length);
+    void sendEvent(const Session* session, const char* message, const char* event);
+    int getRequestSlot(AsyncWebServerRequest* request);
+    void closeStaleChannels();
+    void closeStaleChannel(int slot);
+    void replayEvents(int slot, AsyncEventSourceClient* client);
+    bool isPlayersTurn(const Session* session, const ChessEngine* board) const;
+    void routeAccountEvents();
+    static void writeMoveMetrics(JsonObject json, const MoveMetrics& metrics);
 
 public:
     // Public method for main loop access
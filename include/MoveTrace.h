@@ -0,0 +1,118 @@
+#ifndef MOVE_TRACE_H
+#define MOVE_TRACE_H
+
+#include <Arduino.h>
+
+/**
+ * MoveTrace.h
+ *
+ * Where a move's time goes, from the browser's POST to the move coming back
+ * on the game stream. LichessAPI stamps a MoveTrace as the move passes each
+ * stage; once the echo arrives the trace is split into spans and each span
+ * is added to a LatencyHistogram in MoveMetrics (one per session, one for
+ * the device).
+ *
+ *   queue          POST received until the command leaves the queue (premoves wait here)
+ *   prepare        pausing the stream and SSL cleanup before the request goes out
+ *   poolWait       with the pool's worker before the attempt that succeeded -
+ *                  other requests, rate limit tokens, and earlier failed attempts
+ *   tlsConnect     TLS handshake, only for moves that could not reuse a connection
+ *   post           request written until Lichess answered
+ *   response       answer on the worker until process() picked it up
+ *   streamResume   reopening the game stream after the move, if it was closed
+ *   echo           until the move came back on the game stream
+ *   total          POST received until the echo
+ *
+ * Histograms have fixed buckets and nothing allocates, so this also builds natively.
+ */
+
+#define MOVE_LATENCY_BUCKETS 12  // Upper bounds in LatencyHistogram::BUCKET_BOUNDS, last is open
+
+class LatencyHistogram {
+public:
+    // Upper bounds (ms, inclusive) of all but the last bucket
+    static const unsigned long BUCKET_BOUNDS[MOVE_LATENCY_BUCKETS - 1];
+
+    LatencyHistogram() { reset(); }
+
+    void reset();
+    void record(unsigned long ms);
+
+    unsigned long getCount() const { return _count; }
+    unsigned long getSum() const { return _sum; }
+    unsigned long getMax() const { return _max; }
+    unsigned long getAverage() const { return _count ? _sum / _count : 0; }
+    unsigned long getBucket(int bucket) const { return _buckets[bucket]; }
+
+    // Upper bound of the bucket holding the percentile - an estimate that is
+    // never below the true value. The open bucket reports the maximum.
+    unsigned long getPercentile(uint8_t percent) const;
+
+private:
+    unsigned long _buckets[MOVE_LATENCY_BUCKETS];
+    unsigned long _count;
+    unsigned long _sum;
+    unsigned long _max;
+};
+
+enum MoveSpan {
+    SPAN_QUEUE,
+    SPAN_PREPARE,
+    SPAN_POOL_WAIT,
+    SPAN_TLS_CONNECT,
+    SPAN_POST,
+    SPAN_RESPONSE,
+    SPAN_STREAM_RESUME,
+    SPAN_ECHO,
+    SPAN_TOTAL,
+    SPAN_COUNT
+};
+
+// millis() as the move reached each stage, 0 until it has
+struct MoveTrace {
+    String move;
+    int ply;                    // Ply the move lands on, -1 if the stream has not shown a position yet
+    unsigned long received;     // POST /api/lichess/move arrived
+    unsigned long started;      // Left the command queue
+    unsigned long submitted;    // Handed to the pool's worker
+    unsigned long sent;         // Worker began the attempt that succeeded
+    unsigned long handshake;    // ms of TLS handshake in that attempt, 0 if the connection was reused
+    unsigned long answered;     // Lichess answered
+    unsigned long accepted;     // process() saw the answer
+    unsigned long resumed;      // Game stream reopened, 0 if it stayed open
+    unsigned long echoed;       // Move came back on the game stream
+
+    MoveTrace() { clear(); }
+    void clear();
+    bool isActive() const { return started != 0; }
+    bool isComplete() const { return accepted != 0 && echoed != 0; }
+
+    // Length of a span in ms. Returns false for a span this move did not
+    // go through (no handshake, stream never closed).
+    bool getSpan(MoveSpan span, unsigned long& ms) const;
+};
+
+class MoveMetrics {
+public:
+    MoveMetrics() { reset(); }
+
+    void reset();
+    void record(const MoveTrace& trace);
+    void recordFailure() { _failed++; }
+    // Accepted by Lichess, but the echo was never matched (stream lost, game over)
+    void recordLostEcho() { _lostEchoes++; }
+
+    const LatencyHistogram& getSpan(MoveSpan span) const { return _spans[span]; }
+    unsigned long getTraced() const { return _spans[SPAN_TOTAL].getCount(); }
+    unsigned long getFailed() const { return _failed; }
+    unsigned long getLostEchoes() const { return _lostEchoes; }
+
+    static const char* spanName(MoveSpan span);
+
+private:
+    LatencyHistogram _spans[SPAN_COUNT];
+    unsigned long _failed;
+    unsigned long _lostEchoes;
+};
+
+#endif // MOVE_TRACE_H
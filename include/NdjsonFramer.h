@@ -0,0 +1,52 @@
+#ifndef NDJSON_FRAMER_H
+#define NDJSON_FRAMER_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+
+/**
+ * NdjsonFramer.h
+ *
+ * Splits a newline-delimited JSON stream into lines without per-byte reads or
+ * heap allocation. Socket data is read in blocks into a fixed buffer; each
+ * complete line is handed out in place (NUL-terminated where the newline was)
+ * and the unread tail is compacted to the front only when space runs out.
+ *
+ * Empty lines are Lichess keepalives - they are counted, not returned.
+ * A line longer than the buffer is dropped up to its newline.
+ */
+
+#define NDJSON_BUFFER_SIZE 4096  // Longest event kept (gameFull of a long game is ~3KB)
+
+class NdjsonFramer {
+public:
+    NdjsonFramer() { reset(); }
+
+    void reset();
+
+    // Next complete non-empty line, reading from the client as needed. The
+    // line stays valid (and may be modified, e.g. by zero-copy JSON parsing)
+    // until the next call. Returns false when no whole line is available yet.
+    bool next(WiFiClient* client, char*& line, size_t& length);
+
+    unsigned long getHeartbeatCount() const { return _heartbeats; }
+    unsigned long getLastHeartbeatTime() const { return _lastHeartbeat; }
+    // When bytes last arrived (events or keepalives), 0 if never - a stream
+    // silent for several keepalive intervals is dead even if TCP says otherwise
+    unsigned long getLastReadTime() const { return _lastRead; }
+    unsigned long getOverflowCount() const { return _overflows; }
+
+private:
+    char _buffer[NDJSON_BUFFER_SIZE];
+    size_t _start;      // First byte of the current (unreturned) line
+    size_t _scan;       // Where the newline search resumes
+    size_t _end;        // One past the last byte read
+    bool _discarding;   // Dropping an oversized line until its newline
+
+    unsigned long _heartbeats;
+    unsigned long _lastHeartbeat;
+    unsigned long _lastRead;
+    unsigned long _overflows;
+};
+
+#endif // NDJSON_FRAMER_H
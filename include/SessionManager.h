@@ -2,38 +2,98 @@
 #define SESSION_MANAGER_H
 
 #include <Arduino.h>
+#include <atomic>
 #include <vector>
-#include <map>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include "LichessAPI.h"
+#include "LichessConnectionPool.h"
+#include "MoveTrace.h"
 
-// Forward declaration
-class LichessAPI;
+// Forward declarations
+class ChessEngine;
 
 /**
  * SessionManager.h
  *
  * Manages multiple browser sessions with IP tracking
  * Supports concurrent games from different browsers
- * Each session has its own LichessAPI instance for independent game management
+ * Each session has its own LichessAPI handle for independent game management;
+ * the TLS connections behind them are shared through one LichessConnectionPool
+ *
+ * Sessions are used from two tasks: AsyncTCP request handlers create, look up
+ * and reset them while loop() walks all of them. They live in a fixed array
+ * of slots that never moves, so:
+ * - Lookups and walks over the slots take no lock. A slot is only visible
+ *   once it is fully set up, and getSessionAt() skips slots that are not live.
+ * - Creating, deleting and changing a session's game take one writer lock.
+ *   Each slot's sequence counter is odd while the writer changes it, so
+ *   getGameId() can copy a consistent game ID without the lock.
+ * - gameActive, lastActivity and messageCount are set by both tasks outside
+ *   the lock, so they are atomics.
+ * - A deleted session is only retired. Its LichessAPI is reset and the slot
+ *   freed by loop() in cleanupExpiredSessions(), once no request handler
+ *   holds a ReadGuard. Handlers hold one for as long as they use a Session*.
+ *
+ * A session ID is the slot index and a key - the slot's generation, bumped
+ * each time the slot is reused, and a random tag - so lookups go straight to
+ * the slot and compare one number. Each slot owns its LichessAPI and keeps
+ * its board once a game has needed one, so session churn allocates nothing.
+ *
+ * Lichess events name a game, not a session, so a small hash index maps game
+ * IDs to slots (open addressing, linear probing). setGameId() and deletion
+ * keep it current under the writer lock; readers look up without the lock and
+ * retry if the index changed meanwhile. Game ID and index changes happen with
+ * the task switch disabled, so a reader never waits on a writer it preempted.
  */
 
-#define MAX_SESSIONS 3  // Allow 3 concurrent browser tabs/devices (each LichessAPI ~15-20KB RAM)
+#define MAX_SESSIONS 8  // Concurrent browser tabs/devices (games streaming at once are capped by LICHESS_STREAM_CONNECTIONS)
 #define SESSION_TIMEOUT_MS 1800000  // 30 minutes in milliseconds (1800000ms = 30min)
+#define SESSION_GAME_ID_MAX 16      // Lichess game IDs are 8 characters (12 with the player suffix)
+#define SESSION_COLOR_MAX 6         // "white" or "black"
+#define SESSION_ID_LENGTH 12        // 4 hex digits of slot, 8 of key
+#define SESSION_IP_MAX 40           // Longest IPv6 address, X-Forwarded-For lists are cut short
+#define SESSION_GAME_INDEX_SIZE 16  // Game ID index buckets - a power of two, at least twice MAX_SESSIONS
 
 struct Session {
-    String sessionId;           // Unique session identifier
-    String ipAddress;           // Client IP address
-    String gameId;              // Current Lichess game ID
-    String playerColor;         // "white" or "black"
-    bool gameActive;            // Is game currently active
+    char sessionId[SESSION_ID_LENGTH + 1];  // Unique session identifier (fixed while the session is live)
+    char ipAddress[SESSION_IP_MAX];         // Client IP address (fixed while the session is live)
+    char gameId[SESSION_GAME_ID_MAX];       // Current Lichess game ID, "" if none - set with SessionManager::setGameId()
+    char playerColor[SESSION_COLOR_MAX];    // "white" or "black"
+    std::atomic<bool> gameActive;  // Is game currently active
     bool loggingEnabled;        // Enable/disable server-side logging for this session
     bool debugLogEnabled;       // Enable/disable browser debug logging for this session
     bool pendingRefresh;        // Flag indicating admin requested browser refresh
     unsigned long createdAt;    // Session creation timestamp
-    unsigned long lastActivity; // Last API activity timestamp
-    unsigned long messageCount; // Number of messages sent from this session
-    LichessAPI* lichessAPI;     // Dedicated API instance for this session
-
-    Session() : gameActive(false), loggingEnabled(true), debugLogEnabled(false), pendingRefresh(false), createdAt(0), lastActivity(0), messageCount(0), lichessAPI(nullptr) {}
+    std::atomic<unsigned long> lastActivity;  // Last API activity timestamp
+    std::atomic<unsigned long> messageCount;  // Number of messages sent from this session
+    LichessAPI* lichessAPI;     // Game state handle for this session, owned by its slot; connections come from the pool
+    ChessEngine* board;         // Local copy of the game position, synced from the stream (~5KB, allocated by the slot's first game)
+    long whiteTimeMs;           // Clocks from the last game stream event, -1 if unknown
+    long blackTimeMs;
+
+    Session() { reset(); }
+    Session(const Session&) = delete;
+    Session& operator=(const Session&) = delete;
+
+    // Back to a new session's state - slots are reused, not reassigned
+    void reset() {
+        sessionId[0] = '\0';
+        ipAddress[0] = '\0';
+        gameId[0] = '\0';
+        playerColor[0] = '\0';
+        gameActive = false;
+        loggingEnabled = true;
+        debugLogEnabled = false;
+        pendingRefresh = false;
+        createdAt = 0;
+        lastActivity = 0;
+        messageCount = 0;
+        lichessAPI = nullptr;
+        board = nullptr;
+        whiteTimeMs = -1;
+        blackTimeMs = -1;
+    }
 };
 
 class SessionManager {
@@ -41,23 +101,58 @@ public:
     SessionManager();
     ~SessionManager();
 
+    // Held by request handlers while they use a Session* from getSession() -
+    // a session deleted meanwhile keeps its LichessAPI and board until released
+    class ReadGuard {
+    public:
+        explicit ReadGuard(const SessionManager* manager) : _manager(manager) {
+            if (_manager) _manager->_readers.fetch_add(1);
+        }
+        ~ReadGuard() {
+            if (_manager) _manager->_readers.fetch_sub(1);
+        }
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+
+    private:
+        const SessionManager* _manager;
+    };
+
     // Session lifecycle
     String createSession(const String& ipAddress);
     bool hasSession(const String& sessionId) const;
     Session* getSession(const String& sessionId);
     bool deleteSession(const String& sessionId);
+    // Also frees retired sessions - call from loop() only
     void cleanupExpiredSessions();
 
     // API token management (set once for all sessions)
     void setAPIToken(const char* token);
+    const String& getAPIToken() const { return _apiToken; }
+
+    // TLS connections shared by every session's LichessAPI
+    LichessConnectionPool* getConnectionPool() { return &_connectionPool; }
+
+    // Move latency of every session since boot - outlives the sessions themselves
+    const MoveMetrics& getMoveMetrics() const { return _moveMetrics; }
 
     // Session operations
-    bool setGameId(const String& sessionId, const String& gameId, const String& color);
+    bool setGameId(const String& sessionId, const String& gameId, const char* color = nullptr);  // nullptr keeps the color
     bool setGameActive(const String& sessionId, bool active);
     bool updateActivity(const String& sessionId);
     bool setLoggingEnabled(const String& sessionId, bool enabled);
     bool setDebugLogEnabled(const String& sessionId, bool enabled);
     bool incrementMessageCount(const String& sessionId);
+    ChessEngine* resetBoard(const String& sessionId);  // Allocates on first use, nullptr if no such session
+
+    // Boards are changed by loop() only, under lockBoards(). Request handlers
+    // work on a copy (caller deletes it), nullptr if the session has no board.
+    ChessEngine* copyBoard(const Session* session);
+    void lockBoards();
+    void unlockBoards();
+
+    // Game ID as of one setGameId() - safe from any task
+    String getGameId(const Session* session) const;
 
     // Process all session API instances (call from main loop)
     void processAllSessions();
@@ -65,6 +160,7 @@ public:
     // Session queries
     int getActiveSessionCount() const;
     String getSessionByGameId(const String& gameId) const;
+    Session* getSessionForGame(const String& gameId);  // nullptr if no live session plays it
     std::vector<String> getSessionsByIP(const String& ipAddress) const;
 
     // Admin IP management (for admin button visibility)
@@ -78,20 +174,52 @@ public:
     void printActiveSessions() const;
     String getSessionsJSON() const;
 
-    // Iterator access for processing all sessions (e.g., checking async results)
-    const std::map<String, Session>& getAllSessions() const { return _sessions; }
-    std::map<String, Session>& getAllSessions() { return _sessions; }
+    // Slot access for walking all sessions: for (slot = 0; slot < MAX_SESSIONS; slot++).
+    // nullptr for a slot without a live session.
+    Session* getSessionAt(int slot);
+    const Session* getSessionAt(int slot) const;
+    int getSessionSlot(const Session* session) const { return session - _sessions; }
 
 private:
-    std::map<String, Session> _sessions;
+    enum SlotState : uint8_t { SLOT_FREE, SLOT_LIVE, SLOT_RETIRED };
+
+    Session _sessions[MAX_SESSIONS];
+    ChessEngine* _boards[MAX_SESSIONS];            // Kept across sessions, nullptr until a game needs one
+    std::atomic<uint8_t> _slotState[MAX_SESSIONS];
+    std::atomic<uint32_t> _slotKey[MAX_SESSIONS];  // Generation << 16 | tag, as in the session ID
+    std::atomic<uint32_t> _slotSeq[MAX_SESSIONS];  // Odd while the writer changes the slot
+    uint16_t _slotGeneration[MAX_SESSIONS];
+    mutable std::atomic<int> _readers;             // ReadGuards held
+    SemaphoreHandle_t _writeLock;
+    SemaphoreHandle_t _boardLock;
+    portMUX_TYPE _gameMux;                         // Held while game IDs and the index change
+
+    std::atomic<int8_t> _gameIndex[SESSION_GAME_INDEX_SIZE];  // Slot playing the game hashed here, -1 if empty
+    std::atomic<uint32_t> _gameIndexSeq;                      // Odd while the writer changes the index
+
     std::vector<String> _adminIPs;
     unsigned long _lastCleanup;
     String _apiToken;  // Shared API token for all sessions
+    LichessConnectionPool _connectionPool;
+    MoveMetrics _moveMetrics;
+    LichessAPI _apis[MAX_SESSIONS];  // After the pool they use, so destroyed before it
 
-    String generateSessionId();
     bool isSessionExpired(const Session& session) const;
-    void createLichessAPIForSession(Session* session);
-    void destroyLichessAPIForSession(Session* session);
+    int findSlot(const String& sessionId) const;
+    static bool parseSessionId(const String& sessionId, int& slot, uint32_t& key);
+    void lockWrites();
+    void unlockWrites();
+    void beginSlotWrite(int slot);
+    void endSlotWrite(int slot);
+    void retireSlot(int slot);
+    static uint32_t hashGameId(const char* gameId);
+    void indexGame(int slot);
+    void unindexGame(int slot);
+    int findGameSlot(const String& gameId) const;
+    void retireExpiredSessions();
+    void reclaimRetiredSessions();
+    void createLichessAPIForSession(int slot);
+    void resetLichessAPIForSession(int slot);
 };
 
 #endif // SESSION_MANAGER_H
@@ -3,6 +3,7 @@
 
 #include <Arduino.h>
 #include <ESPAsyncWebServer.h>
+#include "ChessEngine.h"
 
 class GameController; // Forward declaration
 class GeminiAPI; // Forward declaration
@@ -18,21 +19,39 @@ private:
   GeminiAPI* geminiAPI;
   SessionManager* sessionManager;
 
-  // Chess board state tracking
-  String currentBoard[8][8]; // Current board state
+  // Chess board state tracking - rules, history and draw detection live in the engine
+  ChessEngine engine;
   bool boardInitialized;
   bool processingMove; // Flag to prevent race conditions during move processing
-  bool isWhiteTurn; // Track whose turn it is
-
-  // Special move tracking
-  bool whiteKingMoved;
-  bool blackKingMoved;
-  bool whiteKingsideRookMoved;
-  bool whiteQueensideRookMoved;
-  bool blackKingsideRookMoved;
-  bool blackQueensideRookMoved;
-  int enPassantColumn;    // -1 if no en passant available
-  bool enPassantIsWhite;  // Which color can capture en passant
+
+  // Versioned board for delta updates. Every change bumps the version and records
+  // which squares it touched, so clients that send their version get just the diff.
+  static const int BOARD_DELTA_HISTORY = 32;  // Versions a client can lag behind and still get a delta
+  AsyncEventSource* boardEventSource;          // Pushes "board" deltas as they happen
+  uint32_t boardEpoch;                         // Changes on reboot so stale client versions get a full board
+  uint32_t boardVersion;
+  uint8_t lastBoard[64];                       // Engine piece codes as of boardVersion
+  uint64_t changeMasks[BOARD_DELTA_HISTORY];   // Squares changed by each recent version
+
+  // On-device engine self-test: perft against published node counts, then timed
+  // hot paths. Requested over HTTP and run one step per loop() pass on a private
+  // engine, so the live game is untouched and no request handler blocks.
+  static const int BENCH_PERFT_CASES = 5;
+  static const int BENCH_TIMING_CASES = 5;
+  enum BenchState { BENCH_IDLE, BENCH_PENDING, BENCH_RUNNING, BENCH_DONE };
+  struct BenchPerftResult {
+    uint64_t nodes;
+    uint32_t elapsedUs;
+  };
+  struct BenchTimingResult {
+    uint32_t iterations;
+    uint32_t elapsedUs;
+  };
+  BenchState benchState;
+  int benchStep;                               // Next suite entry to run
+  ChessEngine* benchEngine;                    // Allocated for the duration of a run
+  BenchPerftResult benchPerft[BENCH_PERFT_CASES];
+  BenchTimingResult benchTiming[BENCH_TIMING_CASES];
 
   // Captured pieces tracking
   String capturedWhitePieces[16]; // Max 16 pieces can be captured
@@ -40,31 +59,6 @@ private:
   int capturedWhiteCount;
   int capturedBlackCount;
 
-  // Move history for undo/redo functionality
-  struct MoveHistoryEntry {
-    String beforeState[8][8];     // Board state before the move
-    String afterState[8][8];      // Board state after the move
-    bool beforeWhiteKingMoved;
-    bool beforeBlackKingMoved;
-    bool beforeWhiteKingsideRookMoved;
-    bool beforeWhiteQueensideRookMoved;
-    bool beforeBlackKingsideRookMoved;
-    bool beforeBlackQueensideRookMoved;
-    int beforeEnPassantColumn;
-    bool beforeEnPassantIsWhite;
-    bool afterWhiteKingMoved;
-    bool afterBlackKingMoved;
-    bool afterWhiteKingsideRookMoved;
-    bool afterWhiteQueensideRookMoved;
-    bool afterBlackKingsideRookMoved;
-    bool afterBlackQueensideRookMoved;
-    int afterEnPassantColumn;
-    bool afterEnPassantIsWhite;
-  };
-  MoveHistoryEntry moveHistory[20];  // Store last 20 moves
-  int historyCount;                  // Number of stored moves
-  int currentHistoryIndex;           // Current position in history (-1 = latest)
-
   // File upload tracking
   String currentUploadFilename;      // Track the filename being uploaded
 
@@ -72,7 +66,14 @@ private:
   String getMinimalFallbackHTML(); // New minimal fallback function
   String generateChessBoard();
   String generateBoardJSON();
+  String generateStatusJSON();
   String getPieceImageName(String pieceCode);
+  String getPieceCode(int row, int col);
+  uint64_t getChangesSince(uint32_t sinceVersion, bool& full);
+  size_t buildBoardDeltaJSON(char* buffer, size_t size, uint64_t changed);
+  void sendBoardBinary(AsyncWebServerRequest* request, bool full, uint64_t changed);
+  void runBenchPerft(int index);
+  void runBenchTiming(int index);
 
   // Board state management
   void initializeBoard();
@@ -99,10 +100,15 @@ public:
 
   // Public board management
   void applyMove(const String& move, bool isWhite);
+  void noteBoardChange(); // Call after the engine position changes outside WebInterface
 
   // API endpoints
   void handleGetStatus(AsyncWebServerRequest* request);
+  void handleStartBench(AsyncWebServerRequest* request);
+  void handleGetBench(AsyncWebServerRequest* request);
   void handleGetBoard(AsyncWebServerRequest* request);
+  void handleGetPosition(AsyncWebServerRequest* request);
+  void handleSetPosition(AsyncWebServerRequest* request);
   void handleNewGame(AsyncWebServerRequest* request);
   void handleResetGame(AsyncWebServerRequest* request);
   void handleUserMove(AsyncWebServerRequest* request);
@@ -120,50 +126,20 @@ public:
   void handleFileRead(AsyncWebServerRequest* request);
   void handleFileWrite(AsyncWebServerRequest* request);
 
+  // Runs the next step of a requested engine benchmark - call from loop()
+  void processBenchmark();
+
   // AI move handling
   void triggerAIMove();
 
   // Move processing
-  bool applyMoveToBoard(const String& move);
-  bool parseMove(const String& move, int& fromRow, int& fromCol, int& toRow, int& toCol);
-
-  // Chess rule validation helpers
-  bool isValidMove(int fromRow, int fromCol, int toRow, int toCol);
-  bool isPawnMoveValid(int fromRow, int fromCol, int toRow, int toCol, bool isWhite);
-  bool isRookMoveValid(int fromRow, int fromCol, int toRow, int toCol);
-  bool isBishopMoveValid(int fromRow, int fromCol, int toRow, int toCol);
-  bool isKnightMoveValid(int fromRow, int fromCol, int toRow, int toCol);
-  bool isQueenMoveValid(int fromRow, int fromCol, int toRow, int toCol);
-  bool isKingMoveValid(int fromRow, int fromCol, int toRow, int toCol);
-  bool isPathClear(int fromRow, int fromCol, int toRow, int toCol);
-  bool isPieceWhite(const String& piece);
-  char getPieceType(const String& piece);
-
-  // Check detection functions
-  bool isKingInCheck(bool isWhiteKing);
-  bool wouldMoveLeaveKingInCheck(int fromRow, int fromCol, int toRow, int toCol);
-  bool isSquareAttackedBy(int row, int col, bool byWhite);
-  void findKing(bool isWhite, int& kingRow, int& kingCol);
-  bool canPieceAttackSquare(int pieceRow, int pieceCol, int targetRow, int targetCol);
-  bool hasLegalMoves(bool isWhite);
-
-  // Special move functions
-  bool isCastlingMove(int fromRow, int fromCol, int toRow, int toCol);
-  bool canCastle(bool isWhite, bool kingside);
-  void performCastle(bool isWhite, bool kingside);
-  bool isEnPassantCapture(int fromRow, int fromCol, int toRow, int toCol);
-  void performEnPassant(int fromRow, int fromCol, int toRow, int toCol);
-  bool isPawnPromotion(int fromRow, int fromCol, int toRow, int toCol);
-  void promotePawn(int row, int col, char promoteTo, bool isWhite);
-  void updateSpecialMoveTracking(int fromRow, int fromCol, int toRow, int toCol);
-  void resetSpecialMoveFlags();
+  bool applyMoveToBoard(const String& move, String* san = nullptr);
+  bool parseMove(const String& move, Move& parsed);
+  ChessEngine* getChessEngine() { return &engine; }
 
   // Move history functions
-  void saveCurrentBoardState();
-  void saveAfterMoveState();
   bool undoLastWhiteMove();
   bool redoLastWhiteMove();
-  void initializeMoveHistory();
   void handleUndoMove(AsyncWebServerRequest* request);
   void handleRedoMove(AsyncWebServerRequest* request);
 
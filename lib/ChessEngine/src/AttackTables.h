@@ -0,0 +1,101 @@
+#ifndef CHESS_ATTACK_TABLES_H
+#define CHESS_ATTACK_TABLES_H
+
+#include <stdint.h>
+
+/**
+ * AttackTables.h
+ *
+ * Square-set lookup tables for the chess engine, generated at compile time.
+ * Bit n of a mask is square n (row * 8 + col, row 0 = rank 8), matching the
+ * engine's board indexing.
+ *
+ * The tables are a constexpr const object, so the compiler emits them
+ * already filled in. On the ESP32 they link into .rodata in flash (~67KB),
+ * so they cost no boot time and take no IRAM or DRAM.
+ *
+ * Requires C++14 or later for the constexpr loops.
+ */
+
+namespace AttackTables {
+
+struct Tables {
+  uint64_t knight[64];        // Knight moves from each square
+  uint64_t king[64];          // King moves from each square
+  uint64_t pawn[2][64];       // Squares a pawn of each color attacks (WHITE = 0, BLACK = 1)
+  uint64_t rookRays[64];      // Rook moves on an empty board
+  uint64_t bishopRays[64];    // Bishop moves on an empty board
+  uint64_t between[64][64];   // Squares strictly between two aligned squares, 0 if not aligned
+  uint64_t line[64][64];      // Whole rank/file/diagonal through two aligned squares, 0 if not aligned
+};
+
+constexpr int8_t KNIGHT_STEPS[8][2] = {{-2, -1}, {-2, 1}, {-1, -2}, {-1, 2}, {1, -2}, {1, 2}, {2, -1}, {2, 1}};
+constexpr int8_t KING_STEPS[8][2] = {{-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1}};
+
+constexpr bool onBoard(int row, int col) {
+  return row >= 0 && row < 8 && col >= 0 && col < 8;
+}
+
+constexpr uint64_t squareBit(int row, int col) {
+  return 1ULL << (row * 8 + col);
+}
+
+// All squares from (row, col) in one direction up to the edge, excluding the start
+constexpr uint64_t rayMask(int row, int col, int dRow, int dCol) {
+  uint64_t mask = 0;
+  for (int r = row + dRow, c = col + dCol; onBoard(r, c); r += dRow, c += dCol) {
+    mask |= squareBit(r, c);
+  }
+  return mask;
+}
+
+constexpr Tables buildTables() {
+  Tables t{};
+  for (int square = 0; square < 64; square++) {
+    int row = square >> 3;
+    int col = square & 7;
+
+    for (int i = 0; i < 8; i++) {
+      if (onBoard(row + KNIGHT_STEPS[i][0], col + KNIGHT_STEPS[i][1])) {
+        t.knight[square] |= squareBit(row + KNIGHT_STEPS[i][0], col + KNIGHT_STEPS[i][1]);
+      }
+      if (onBoard(row + KING_STEPS[i][0], col + KING_STEPS[i][1])) {
+        t.king[square] |= squareBit(row + KING_STEPS[i][0], col + KING_STEPS[i][1]);
+      }
+    }
+
+    // White pawns capture towards row 0, black pawns towards row 7
+    for (int side = -1; side <= 1; side += 2) {
+      if (onBoard(row - 1, col + side)) t.pawn[0][square] |= squareBit(row - 1, col + side);
+      if (onBoard(row + 1, col + side)) t.pawn[1][square] |= squareBit(row + 1, col + side);
+    }
+
+    t.rookRays[square] = rayMask(row, col, -1, 0) | rayMask(row, col, 1, 0) |
+                         rayMask(row, col, 0, -1) | rayMask(row, col, 0, 1);
+    t.bishopRays[square] = rayMask(row, col, -1, -1) | rayMask(row, col, -1, 1) |
+                           rayMask(row, col, 1, -1) | rayMask(row, col, 1, 1);
+
+    // Walk each direction; every square reached is aligned with this one
+    for (int dRow = -1; dRow <= 1; dRow++) {
+      for (int dCol = -1; dCol <= 1; dCol++) {
+        if (dRow == 0 && dCol == 0) continue;
+        uint64_t fullLine = rayMask(row, col, dRow, dCol) | rayMask(row, col, -dRow, -dCol) |
+                            squareBit(row, col);
+        uint64_t passed = 0;
+        for (int r = row + dRow, c = col + dCol; onBoard(r, c); r += dRow, c += dCol) {
+          int target = r * 8 + c;
+          t.between[square][target] = passed;
+          t.line[square][target] = fullLine;
+          passed |= squareBit(r, c);
+        }
+      }
+    }
+  }
+  return t;
+}
+
+constexpr Tables TABLES = buildTables();
+
+} // namespace AttackTables
+
+#endif
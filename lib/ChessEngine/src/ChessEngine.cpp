@@ -0,0 +1,1196 @@
+#include "ChessEngine.h"
+#include "AttackTables.h"
+#include <string.h>
+
+using AttackTables::TABLES;
+
+// Zobrist key layout: 12 pieces x 64 squares, 16 castling masks, 8 en passant files, side to move
+#define ZOBRIST_CASTLING_BASE 768
+#define ZOBRIST_EN_PASSANT_BASE 784
+#define ZOBRIST_BLACK_TO_MOVE 792
+
+#define HISTORY_MASK (CHESS_HISTORY_CAPACITY - 1)
+
+// Keys are derived from their index with splitmix64, so no key table is kept in RAM
+static uint64_t zobristKey(uint16_t index) {
+  uint64_t z = (uint64_t)(index + 1) * 0x9E3779B97F4A7C15ULL;
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+static uint64_t zobristPieceKey(uint8_t piece, int square) {
+  int pieceIndex = ChessEngine::pieceColor(piece) * 6 + ChessEngine::pieceType(piece) - 1;
+  return zobristKey(pieceIndex * 64 + square);
+}
+
+// Movement directions as {row, col} deltas
+static const int8_t ROOK_DIRECTIONS[4][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+static const int8_t BISHOP_DIRECTIONS[4][2] = {{-1, -1}, {-1, 1}, {1, -1}, {1, 1}};
+
+// Castling rights kept after a move touches a square (king and rook home squares clear rights)
+static uint8_t castlingMaskForSquare(int square) {
+  switch (square) {
+    case 0:  return CASTLE_ALL & ~CASTLE_BLACK_QUEENSIDE;                           // a8
+    case 4:  return CASTLE_ALL & ~(CASTLE_BLACK_KINGSIDE | CASTLE_BLACK_QUEENSIDE);  // e8
+    case 7:  return CASTLE_ALL & ~CASTLE_BLACK_KINGSIDE;                            // h8
+    case 56: return CASTLE_ALL & ~CASTLE_WHITE_QUEENSIDE;                           // a1
+    case 60: return CASTLE_ALL & ~(CASTLE_WHITE_KINGSIDE | CASTLE_WHITE_QUEENSIDE);  // e1
+    case 63: return CASTLE_ALL & ~CASTLE_WHITE_KINGSIDE;                            // h1
+    default: return CASTLE_ALL;
+  }
+}
+
+static inline bool onBoard(int row, int col) {
+  return row >= 0 && row < 8 && col >= 0 && col < 8;
+}
+
+static inline uint64_t squareBit(int square) {
+  return 1ULL << square;
+}
+
+// Index of the lowest set bit, clearing it
+static inline int popLowestSquare(uint64_t& mask) {
+  int square = __builtin_ctzll(mask);
+  mask &= mask - 1;
+  return square;
+}
+
+ChessEngine::ChessEngine() {
+  initializeBoard();
+}
+
+void ChessEngine::begin() {
+  initializeBoard();
+}
+
+void ChessEngine::resetGame() {
+  initializeBoard();
+}
+
+void ChessEngine::clearBoard() {
+  memset(board, 0, sizeof(board));
+  memset(pieceBitboards, 0, sizeof(pieceBitboards));
+  memset(colorBitboards, 0, sizeof(colorBitboards));
+  currentPlayer = WHITE;
+  castlingRights = 0;
+  enPassantFile = -1;
+  halfMoveClock = 0;
+  fullMoveNumber = 1;
+  kingSquare[WHITE] = 60;
+  kingSquare[BLACK] = 4;
+  undoTop = 0;
+  undoCount = 0;
+  redoCount = 0;
+  plyCount = 0;
+  hash = 0;
+}
+
+void ChessEngine::initializeBoard() {
+  static const PieceType backRank[8] = {ROOK, KNIGHT, BISHOP, QUEEN, KING, BISHOP, KNIGHT, ROOK};
+
+  clearBoard();
+  for (int col = 0; col < 8; col++) {
+    board[col] = makePiece(backRank[col], BLACK);
+    board[8 + col] = makePiece(PAWN, BLACK);
+    board[48 + col] = makePiece(PAWN, WHITE);
+    board[56 + col] = makePiece(backRank[col], WHITE);
+  }
+  castlingRights = CASTLE_ALL;
+  rebuildBitboards();
+  computeHash();
+}
+
+// En passant file that actually affects the position: only hashed when an enemy
+// pawn stands ready to capture, so transpositions compare equal
+int ChessEngine::getEnPassantHashFile() const {
+  if (enPassantFile < 0) return -1;
+
+  // The double-pushed pawn belongs to the side that just moved
+  int row = (currentPlayer == WHITE) ? 3 : 4;
+  uint8_t capturer = makePiece(PAWN, currentPlayer);
+  if ((enPassantFile > 0 && board[row * 8 + enPassantFile - 1] == capturer) ||
+      (enPassantFile < 7 && board[row * 8 + enPassantFile + 1] == capturer)) {
+    return enPassantFile;
+  }
+  return -1;
+}
+
+void ChessEngine::computeHash() {
+  hash = 0;
+  for (int square = 0; square < 64; square++) {
+    if (board[square]) {
+      hash ^= zobristPieceKey(board[square], square);
+    }
+  }
+  hash ^= zobristKey(ZOBRIST_CASTLING_BASE + castlingRights);
+  int hashedEnPassant = getEnPassantHashFile();
+  if (hashedEnPassant >= 0) {
+    hash ^= zobristKey(ZOBRIST_EN_PASSANT_BASE + hashedEnPassant);
+  }
+  if (currentPlayer == BLACK) {
+    hash ^= zobristKey(ZOBRIST_BLACK_TO_MOVE);
+  }
+}
+
+// Write a square and keep the bitboards in step (the hash is the caller's job)
+void ChessEngine::setSquare(int square, uint8_t piece) {
+  uint8_t old = board[square];
+  if (old) {
+    pieceBitboards[pieceColor(old)][pieceType(old)] &= ~squareBit(square);
+    colorBitboards[pieceColor(old)] &= ~squareBit(square);
+  }
+  board[square] = piece;
+  if (piece) {
+    pieceBitboards[pieceColor(piece)][pieceType(piece)] |= squareBit(square);
+    colorBitboards[pieceColor(piece)] |= squareBit(square);
+    if (pieceType(piece) == KING) {
+      kingSquare[pieceColor(piece)] = square;
+    }
+  }
+}
+
+void ChessEngine::rebuildBitboards() {
+  memset(pieceBitboards, 0, sizeof(pieceBitboards));
+  memset(colorBitboards, 0, sizeof(colorBitboards));
+  for (int square = 0; square < 64; square++) {
+    uint8_t piece = board[square];
+    if (piece) {
+      pieceBitboards[pieceColor(piece)][pieceType(piece)] |= squareBit(square);
+      colorBitboards[pieceColor(piece)] |= squareBit(square);
+    }
+  }
+}
+
+void ChessEngine::putPiece(int square, uint8_t piece) {
+  hash ^= zobristPieceKey(piece, square);
+  setSquare(square, piece);
+}
+
+void ChessEngine::removePiece(int square) {
+  hash ^= zobristPieceKey(board[square], square);
+  setSquare(square, 0);
+}
+
+Piece ChessEngine::getPiece(int row, int col) const {
+  Piece piece;
+  uint8_t code = board[row * 8 + col];
+  piece.type = pieceType(code);
+  piece.color = pieceColor(code);
+  return piece;
+}
+
+char ChessEngine::pieceTypeChar(PieceType type) {
+  static const char chars[] = "\0prnbqk";
+  return (type >= PAWN && type <= KING) ? chars[type] : 0;
+}
+
+PieceType ChessEngine::pieceTypeFromChar(char c) {
+  switch (c | 0x20) {
+    case 'p': return PAWN;
+    case 'r': return ROOK;
+    case 'n': return KNIGHT;
+    case 'b': return BISHOP;
+    case 'q': return QUEEN;
+    case 'k': return KING;
+    default: return EMPTY;
+  }
+}
+
+// ========================================
+// FEN
+// ========================================
+
+static const char* skipSpaces(const char* p) {
+  while (*p == ' ') p++;
+  return p;
+}
+
+// Parse an unsigned decimal field, returns nullptr if there are no digits
+static const char* parseNumber(const char* p, uint16_t& value) {
+  if (*p < '0' || *p > '9') return nullptr;
+  uint32_t result = 0;
+  while (*p >= '0' && *p <= '9') {
+    result = result * 10 + (*p++ - '0');
+    if (result > 0xFFFF) return nullptr;
+  }
+  value = result;
+  return p;
+}
+
+bool ChessEngine::setFEN(const char* fen) {
+  if (!fen) return false;
+
+  // Piece placement, rank 8 first
+  uint8_t newBoard[64];
+  memset(newBoard, 0, sizeof(newBoard));
+  int newKings[2] = {-1, -1};
+  int row = 0;
+  int col = 0;
+  const char* p = skipSpaces(fen);
+  while (*p && *p != ' ') {
+    char c = *p++;
+    if (c == '/') {
+      if (col != 8 || row == 7) return false;
+      row++;
+      col = 0;
+    } else if (c >= '1' && c <= '8') {
+      col += c - '0';
+      if (col > 8) return false;
+    } else {
+      PieceType type = pieceTypeFromChar(c);
+      if (type == EMPTY || col > 7) return false;
+      PieceColor color = (c >= 'a') ? BLACK : WHITE;
+      if (type == PAWN && (row == 0 || row == 7)) return false;
+      if (type == KING) {
+        if (newKings[color] >= 0) return false;
+        newKings[color] = row * 8 + col;
+      }
+      newBoard[row * 8 + col++] = makePiece(type, color);
+    }
+  }
+  if (row != 7 || col != 8 || newKings[WHITE] < 0 || newKings[BLACK] < 0) return false;
+
+  // Side to move
+  p = skipSpaces(p);
+  PieceColor side;
+  if (*p == 'w') {
+    side = WHITE;
+  } else if (*p == 'b') {
+    side = BLACK;
+  } else {
+    return false;
+  }
+  p++;
+  if (*p && *p != ' ') return false;
+
+  // Castling rights - rights without the king and rook on their home squares are dropped
+  p = skipSpaces(p);
+  uint8_t rights = 0;
+  if (*p == '-') {
+    p++;
+  } else {
+    while (*p && *p != ' ') {
+      switch (*p++) {
+        case 'K': rights |= CASTLE_WHITE_KINGSIDE; break;
+        case 'Q': rights |= CASTLE_WHITE_QUEENSIDE; break;
+        case 'k': rights |= CASTLE_BLACK_KINGSIDE; break;
+        case 'q': rights |= CASTLE_BLACK_QUEENSIDE; break;
+        default: return false;
+      }
+    }
+  }
+  uint8_t whiteKing = makePiece(KING, WHITE), whiteRook = makePiece(ROOK, WHITE);
+  uint8_t blackKing = makePiece(KING, BLACK), blackRook = makePiece(ROOK, BLACK);
+  if (newBoard[60] != whiteKing || newBoard[63] != whiteRook) rights &= ~CASTLE_WHITE_KINGSIDE;
+  if (newBoard[60] != whiteKing || newBoard[56] != whiteRook) rights &= ~CASTLE_WHITE_QUEENSIDE;
+  if (newBoard[4] != blackKing || newBoard[7] != blackRook) rights &= ~CASTLE_BLACK_KINGSIDE;
+  if (newBoard[4] != blackKing || newBoard[0] != blackRook) rights &= ~CASTLE_BLACK_QUEENSIDE;
+
+  // En passant target square - kept only if a double-pushed pawn is actually there
+  p = skipSpaces(p);
+  int8_t newEnPassant = -1;
+  if (*p == '-') {
+    p++;
+  } else if (p[0] >= 'a' && p[0] <= 'h' && p[1] == (side == WHITE ? '6' : '3')) {
+    int file = p[0] - 'a';
+    int pawnRow = (side == WHITE) ? 3 : 4;
+    int behindRow = (side == WHITE) ? 1 : 6;
+    PieceColor pusher = (side == WHITE) ? BLACK : WHITE;
+    if (newBoard[pawnRow * 8 + file] == makePiece(PAWN, pusher) &&
+        !newBoard[(8 - (p[1] - '0')) * 8 + file] && !newBoard[behindRow * 8 + file]) {
+      newEnPassant = file;
+    }
+    p += 2;
+  } else {
+    return false;
+  }
+
+  // Clocks are optional (EPD-style FENs omit them)
+  uint16_t newHalfMoves = 0;
+  uint16_t newFullMoves = 1;
+  p = skipSpaces(p);
+  if (*p) {
+    p = parseNumber(p, newHalfMoves);
+    if (!p) return false;
+    p = skipSpaces(p);
+    if (*p) {
+      p = parseNumber(p, newFullMoves);
+      if (!p || newFullMoves == 0) return false;
+    }
+  }
+  if (*skipSpaces(p)) return false;
+
+  // The side that just moved must not have left its king in check
+  uint8_t savedBoard[64];
+  memcpy(savedBoard, board, sizeof(board));
+  memcpy(board, newBoard, sizeof(board));
+  rebuildBitboards();
+  if (isSquareAttacked(newKings[side == WHITE ? BLACK : WHITE], side)) {
+    memcpy(board, savedBoard, sizeof(board));
+    rebuildBitboards();
+    return false;
+  }
+
+  currentPlayer = side;
+  castlingRights = rights;
+  enPassantFile = newEnPassant;
+  halfMoveClock = newHalfMoves;
+  fullMoveNumber = newFullMoves;
+  kingSquare[WHITE] = newKings[WHITE];
+  kingSquare[BLACK] = newKings[BLACK];
+  undoTop = 0;
+  undoCount = 0;
+  redoCount = 0;
+  plyCount = 0;
+  computeHash();
+  return true;
+}
+
+// Appends one character if it fits before end (kept for the terminator);
+// otherwise clears ok so the caller can give up
+static inline void putChar(char*& out, const char* end, bool& ok, char c) {
+  if (out < end) {
+    *out++ = c;
+  } else {
+    ok = false;
+  }
+}
+
+// Appends decimal digits without pulling in printf
+static void writeNumber(char*& out, const char* end, bool& ok, uint16_t value) {
+  char digits[5];
+  int count = 0;
+  do {
+    digits[count++] = '0' + value % 10;
+    value /= 10;
+  } while (value);
+  while (count) putChar(out, end, ok, digits[--count]);
+}
+
+size_t ChessEngine::getFEN(char* buffer, size_t size) const {
+  if (!buffer || size < CHESS_FEN_MAX) return 0;
+
+  static const char pieceChars[] = " PRNBQK";
+  char* out = buffer;
+  const char* end = buffer + size - 1;
+  bool ok = true;
+  for (int row = 0; row < 8; row++) {
+    int empty = 0;
+    for (int col = 0; col < 8; col++) {
+      uint8_t piece = board[row * 8 + col];
+      if (!piece) {
+        empty++;
+        continue;
+      }
+      if (empty) {
+        putChar(out, end, ok, '0' + empty);
+        empty = 0;
+      }
+      char c = pieceChars[pieceType(piece)];
+      putChar(out, end, ok, pieceColor(piece) == BLACK ? (c | 0x20) : c);
+    }
+    if (empty) putChar(out, end, ok, '0' + empty);
+    if (row < 7) putChar(out, end, ok, '/');
+  }
+
+  putChar(out, end, ok, ' ');
+  putChar(out, end, ok, currentPlayer == WHITE ? 'w' : 'b');
+
+  putChar(out, end, ok, ' ');
+  if (!castlingRights) putChar(out, end, ok, '-');
+  if (castlingRights & CASTLE_WHITE_KINGSIDE) putChar(out, end, ok, 'K');
+  if (castlingRights & CASTLE_WHITE_QUEENSIDE) putChar(out, end, ok, 'Q');
+  if (castlingRights & CASTLE_BLACK_KINGSIDE) putChar(out, end, ok, 'k');
+  if (castlingRights & CASTLE_BLACK_QUEENSIDE) putChar(out, end, ok, 'q');
+
+  putChar(out, end, ok, ' ');
+  if (enPassantFile >= 0) {
+    putChar(out, end, ok, 'a' + enPassantFile);
+    putChar(out, end, ok, currentPlayer == WHITE ? '6' : '3');
+  } else {
+    putChar(out, end, ok, '-');
+  }
+
+  putChar(out, end, ok, ' ');
+  writeNumber(out, end, ok, halfMoveClock);
+  putChar(out, end, ok, ' ');
+  writeNumber(out, end, ok, fullMoveNumber);
+  if (!ok) {
+    buffer[0] = '\0';
+    return 0;
+  }
+  *out = '\0';
+  return out - buffer;
+}
+
+// ========================================
+// Attack detection
+// ========================================
+
+bool ChessEngine::isSquareAttacked(int row, int col, PieceColor attackingColor) const {
+  return isSquareAttacked(row * 8 + col, attackingColor);
+}
+
+// Looks outward from the target square: a piece attacks it if the target is in
+// the piece's attack set, and for sliders nothing stands in between
+bool ChessEngine::isSquareAttacked(int square, PieceColor attackingColor) const {
+  const uint64_t* attackers = pieceBitboards[attackingColor];
+  PieceColor defender = (attackingColor == WHITE) ? BLACK : WHITE;
+
+  // A pawn attacks this square if a defending pawn here would attack the pawn
+  if ((TABLES.pawn[defender][square] & attackers[PAWN]) ||
+      (TABLES.knight[square] & attackers[KNIGHT]) ||
+      (TABLES.king[square] & attackers[KING])) {
+    return true;
+  }
+
+  uint64_t occupied = colorBitboards[WHITE] | colorBitboards[BLACK];
+  uint64_t sliders = (TABLES.rookRays[square] & (attackers[ROOK] | attackers[QUEEN])) |
+                     (TABLES.bishopRays[square] & (attackers[BISHOP] | attackers[QUEEN]));
+  while (sliders) {
+    int from = popLowestSquare(sliders);
+    if (!(TABLES.between[square][from] & occupied)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool ChessEngine::isInCheck(PieceColor color) const {
+  return isSquareAttacked(kingSquare[color], color == WHITE ? BLACK : WHITE);
+}
+
+// ========================================
+// Move generation
+// ========================================
+
+static inline void addMove(Move* moves, int& count, int from, int to, uint8_t promotion, uint8_t flags) {
+  Move& move = moves[count++];
+  move.from = from;
+  move.to = to;
+  move.promotion = promotion;
+  move.flags = flags;
+}
+
+void ChessEngine::addPawnMoves(int from, Move* moves, int& count) const {
+  static const uint8_t promotions[4] = {QUEEN, ROOK, BISHOP, KNIGHT};
+  int row = from >> 3;
+  int col = from & 7;
+  int direction = (currentPlayer == WHITE) ? -1 : 1;
+  int startRow = (currentPlayer == WHITE) ? 6 : 1;
+  int lastRow = (currentPlayer == WHITE) ? 0 : 7;
+  int toRow = row + direction;
+
+  // Pushes
+  int to = toRow * 8 + col;
+  if (!board[to]) {
+    if (toRow == lastRow) {
+      for (int i = 0; i < 4; i++) addMove(moves, count, from, to, promotions[i], 0);
+    } else {
+      addMove(moves, count, from, to, EMPTY, 0);
+      int doubleTo = to + direction * 8;
+      if (row == startRow && !board[doubleTo]) {
+        addMove(moves, count, from, doubleTo, EMPTY, MOVE_FLAG_DOUBLE_PUSH);
+      }
+    }
+  }
+
+  // Captures, including en passant onto the square behind a double-pushed pawn
+  int enPassantRow = (currentPlayer == WHITE) ? 3 : 4;
+  for (int side = -1; side <= 1; side += 2) {
+    int toCol = col + side;
+    if (toCol < 0 || toCol > 7) continue;
+    to = toRow * 8 + toCol;
+    uint8_t target = board[to];
+    if (target && pieceColor(target) != currentPlayer) {
+      if (toRow == lastRow) {
+        for (int i = 0; i < 4; i++) addMove(moves, count, from, to, promotions[i], MOVE_FLAG_CAPTURE);
+      } else {
+        addMove(moves, count, from, to, EMPTY, MOVE_FLAG_CAPTURE);
+      }
+    } else if (!target && row == enPassantRow && toCol == enPassantFile) {
+      addMove(moves, count, from, to, EMPTY, MOVE_FLAG_CAPTURE | MOVE_FLAG_EN_PASSANT);
+    }
+  }
+}
+
+void ChessEngine::addSlidingMoves(int from, const int8_t (*directions)[2], int directionCount, Move* moves, int& count) const {
+  int row = from >> 3;
+  int col = from & 7;
+  for (int i = 0; i < directionCount; i++) {
+    int r = row + directions[i][0];
+    int c = col + directions[i][1];
+    while (onBoard(r, c)) {
+      int to = r * 8 + c;
+      uint8_t target = board[to];
+      if (target) {
+        if (pieceColor(target) != currentPlayer) {
+          addMove(moves, count, from, to, EMPTY, MOVE_FLAG_CAPTURE);
+        }
+        break;
+      }
+      addMove(moves, count, from, to, EMPTY, 0);
+      r += directions[i][0];
+      c += directions[i][1];
+    }
+  }
+}
+
+void ChessEngine::addStepMoves(int from, uint64_t targets, Move* moves, int& count) const {
+  PieceColor opponent = (currentPlayer == WHITE) ? BLACK : WHITE;
+  targets &= ~colorBitboards[currentPlayer];
+  while (targets) {
+    int to = popLowestSquare(targets);
+    addMove(moves, count, from, to, EMPTY, (colorBitboards[opponent] & squareBit(to)) ? MOVE_FLAG_CAPTURE : 0);
+  }
+}
+
+// Castling needs the rights, empty squares between king and rook, and a king
+// that is not in check and does not pass through an attacked square.
+// The landing square is covered by the normal legality check.
+void ChessEngine::addCastlingMoves(Move* moves, int& count) const {
+  uint8_t kingside = (currentPlayer == WHITE) ? CASTLE_WHITE_KINGSIDE : CASTLE_BLACK_KINGSIDE;
+  uint8_t queenside = (currentPlayer == WHITE) ? CASTLE_WHITE_QUEENSIDE : CASTLE_BLACK_QUEENSIDE;
+  if (!(castlingRights & (kingside | queenside))) return;
+
+  int home = (currentPlayer == WHITE) ? 60 : 4;
+  PieceColor opponent = (currentPlayer == WHITE) ? BLACK : WHITE;
+  if (kingSquare[currentPlayer] != home || isSquareAttacked(home, opponent)) return;
+
+  if ((castlingRights & kingside) && !board[home + 1] && !board[home + 2] &&
+      !isSquareAttacked(home + 1, opponent)) {
+    addMove(moves, count, home, home + 2, EMPTY, MOVE_FLAG_CASTLE);
+  }
+  if ((castlingRights & queenside) && !board[home - 1] && !board[home - 2] && !board[home - 3] &&
+      !isSquareAttacked(home - 1, opponent)) {
+    addMove(moves, count, home, home - 2, EMPTY, MOVE_FLAG_CASTLE);
+  }
+}
+
+int ChessEngine::generatePseudoLegalMoves(Move* moves) const {
+  int count = 0;
+  for (int square = 0; square < 64; square++) {
+    uint8_t piece = board[square];
+    if (!piece || pieceColor(piece) != currentPlayer) continue;
+
+    switch (pieceType(piece)) {
+      case PAWN:   addPawnMoves(square, moves, count); break;
+      case KNIGHT: addStepMoves(square, TABLES.knight[square], moves, count); break;
+      case BISHOP: addSlidingMoves(square, BISHOP_DIRECTIONS, 4, moves, count); break;
+      case ROOK:   addSlidingMoves(square, ROOK_DIRECTIONS, 4, moves, count); break;
+      case QUEEN:
+        addSlidingMoves(square, ROOK_DIRECTIONS, 4, moves, count);
+        addSlidingMoves(square, BISHOP_DIRECTIONS, 4, moves, count);
+        break;
+      case KING:   addStepMoves(square, TABLES.king[square], moves, count); break;
+      default: break;
+    }
+  }
+  addCastlingMoves(moves, count);
+  return count;
+}
+
+// Moves of a non-king piece that is not lined up with its own king (or that
+// stay on that line) cannot expose the king, so only king moves, en passant,
+// pinned-line candidates and evasions need the full make/unmake test
+bool ChessEngine::leavesKingInCheck(const Move& move, bool inCheck) {
+  PieceColor mover = currentPlayer;
+  int king = kingSquare[mover];
+  if (!inCheck && move.from != king && !(move.flags & MOVE_FLAG_EN_PASSANT)) {
+    uint64_t kingLine = TABLES.line[king][move.from];
+    if (!kingLine || (kingLine & squareBit(move.to))) {
+      return false;
+    }
+  }
+
+  // Play the move, test the mover's king, and take it back again
+  uint64_t keyBefore = hash;
+  UndoRecord record;
+  makeMove(move, record);
+  bool exposed = isInCheck(mover);
+  unmakeMove(record);
+  hash = keyBefore;
+  return exposed;
+}
+
+int ChessEngine::generateLegalMoves(Move* moves) {
+  int count = generatePseudoLegalMoves(moves);
+  bool inCheck = isInCheck(currentPlayer);
+  int legalCount = 0;
+  for (int i = 0; i < count; i++) {
+    if (!leavesKingInCheck(moves[i], inCheck)) {
+      moves[legalCount++] = moves[i];
+    }
+  }
+  return legalCount;
+}
+
+// Match a parsed move (from, to, promotion) against the legal moves and return
+// the generated one, which carries the correct flags
+bool ChessEngine::findLegalMove(const Move& candidate, Move& legalMove) {
+  if (!candidate.isValid() || candidate.from > 63 || candidate.to > 63) return false;
+
+  uint8_t piece = board[candidate.from];
+  if (!piece || pieceColor(piece) != currentPlayer) return false;
+
+  // A pawn reaching the last rank without a promotion piece promotes to a queen
+  Move wanted = candidate;
+  if (pieceType(piece) == PAWN && (candidate.toRow() == 0 || candidate.toRow() == 7) &&
+      wanted.promotion == EMPTY) {
+    wanted.promotion = QUEEN;
+  }
+
+  Move moves[CHESS_MAX_MOVES];
+  int count = generatePseudoLegalMoves(moves);
+  for (int i = 0; i < count; i++) {
+    if (moves[i].sameAs(wanted)) {
+      if (leavesKingInCheck(moves[i], isInCheck(currentPlayer))) return false;
+      legalMove = moves[i];
+      return true;
+    }
+  }
+  return false;
+}
+
+bool ChessEngine::isLegalMove(const Move& move) {
+  Move legalMove;
+  return findLegalMove(move, legalMove);
+}
+
+bool ChessEngine::hasLegalMoves() {
+  Move moves[CHESS_MAX_MOVES];
+  int count = generatePseudoLegalMoves(moves);
+  bool inCheck = isInCheck(currentPlayer);
+  for (int i = 0; i < count; i++) {
+    if (!leavesKingInCheck(moves[i], inCheck)) return true;
+  }
+  return false;
+}
+
+// Leaf nodes of the legal move tree, counting the last ply from the move list
+// length rather than playing it. Stack use is one move list per ply of depth.
+uint64_t ChessEngine::perft(int depth) {
+  if (depth <= 0) return 1;
+
+  Move moves[CHESS_MAX_MOVES];
+  int count = generateLegalMoves(moves);
+  if (depth == 1) return count;
+
+  uint64_t nodes = 0;
+  uint64_t keyBefore = hash;
+  for (int i = 0; i < count; i++) {
+    UndoRecord record;
+    makeMove(moves[i], record);
+    nodes += perft(depth - 1);
+    unmakeMove(record);
+    hash = keyBefore;
+  }
+  return nodes;
+}
+
+// ========================================
+// Make / unmake
+// ========================================
+
+// Apply a generated move without validation, keeping the hash up to date
+void ChessEngine::makeMove(const Move& move, UndoRecord& record) {
+  int from = move.from;
+  int to = move.to;
+  uint8_t piece = board[from];
+
+  record.move = move;
+  record.captured = board[to];
+  record.castlingRights = castlingRights;
+  record.enPassantFile = enPassantFile;
+  record.halfMoveClock = halfMoveClock;
+
+  // Remove the old castling/en passant contributions; re-added below
+  hash ^= zobristKey(ZOBRIST_CASTLING_BASE + castlingRights);
+  int hashedEnPassant = getEnPassantHashFile();
+  if (hashedEnPassant >= 0) {
+    hash ^= zobristKey(ZOBRIST_EN_PASSANT_BASE + hashedEnPassant);
+  }
+
+  if (move.flags & MOVE_FLAG_EN_PASSANT) {
+    // The captured pawn sits beside the mover, not on the destination square
+    int capturedSquare = (from & ~7) | (to & 7);
+    record.captured = board[capturedSquare];
+    removePiece(capturedSquare);
+  } else if (record.captured) {
+    removePiece(to);
+  }
+
+  removePiece(from);
+  putPiece(to, move.promotion ? makePiece((PieceType)move.promotion, currentPlayer) : piece);
+
+  if (move.flags & MOVE_FLAG_CASTLE) {
+    // Rook jumps over the king: h-file rook to f-file, a-file rook to d-file
+    int rookFrom = (to > from) ? from + 3 : from - 4;
+    int rookTo = (to > from) ? from + 1 : from - 1;
+    uint8_t rook = board[rookFrom];
+    removePiece(rookFrom);
+    putPiece(rookTo, rook);
+  }
+
+  castlingRights &= castlingMaskForSquare(from) & castlingMaskForSquare(to);
+  enPassantFile = (move.flags & MOVE_FLAG_DOUBLE_PUSH) ? (to & 7) : -1;
+
+  // Captures and pawn moves are irreversible and reset the fifty-move count
+  if (pieceType(piece) == PAWN || record.captured) {
+    halfMoveClock = 0;
+  } else if (halfMoveClock < 0xFFFF) {
+    halfMoveClock++;
+  }
+  if (currentPlayer == BLACK) {
+    fullMoveNumber++;
+  }
+  currentPlayer = (currentPlayer == WHITE) ? BLACK : WHITE;
+
+  hash ^= zobristKey(ZOBRIST_CASTLING_BASE + castlingRights);
+  hashedEnPassant = getEnPassantHashFile();
+  if (hashedEnPassant >= 0) {
+    hash ^= zobristKey(ZOBRIST_EN_PASSANT_BASE + hashedEnPassant);
+  }
+  hash ^= zobristKey(ZOBRIST_BLACK_TO_MOVE);
+}
+
+// Reverse a move applied with makeMove(). Skips the hash - the caller restores
+// it from the key saved before the move.
+void ChessEngine::unmakeMove(const UndoRecord& record) {
+  const Move& move = record.move;
+  int from = move.from;
+  int to = move.to;
+
+  currentPlayer = (currentPlayer == WHITE) ? BLACK : WHITE;
+  if (currentPlayer == BLACK) {
+    fullMoveNumber--;
+  }
+
+  uint8_t piece = move.promotion ? makePiece(PAWN, currentPlayer) : board[to];
+  setSquare(to, 0);
+  setSquare(from, piece);
+
+  if (move.flags & MOVE_FLAG_EN_PASSANT) {
+    setSquare((from & ~7) | (to & 7), record.captured);
+  } else if (record.captured) {
+    setSquare(to, record.captured);
+  }
+
+  if (move.flags & MOVE_FLAG_CASTLE) {
+    int rookFrom = (to > from) ? from + 3 : from - 4;
+    int rookTo = (to > from) ? from + 1 : from - 1;
+    setSquare(rookFrom, board[rookTo]);
+    setSquare(rookTo, 0);
+  }
+
+  castlingRights = record.castlingRights;
+  enPassantFile = record.enPassantFile;
+  halfMoveClock = record.halfMoveClock;
+}
+
+// ========================================
+// Playing moves and history
+// ========================================
+
+void ChessEngine::pushMove(const Move& move) {
+  int index = undoTop & HISTORY_MASK;
+  keyRing[index] = hash;
+  makeMove(move, undoRing[index]);
+  undoTop++;
+  if (undoCount < CHESS_HISTORY_CAPACITY) {
+    undoCount++;
+  }
+  redoCount = 0;
+  plyCount++;
+}
+
+bool ChessEngine::playMove(const Move& move) {
+  Move legalMove;
+  if (!findLegalMove(move, legalMove)) {
+    return false;
+  }
+  pushMove(legalMove);
+  return true;
+}
+
+bool ChessEngine::playMove(const char* moveStr) {
+  Move move = parseMove(moveStr);
+  if (!move.isValid()) {
+    move = parseSAN(moveStr);
+  }
+  return playMove(move);
+}
+
+bool ChessEngine::undoMove() {
+  if (undoCount == 0) {
+    return false;
+  }
+  undoTop--;
+  int index = undoTop & HISTORY_MASK;
+  unmakeMove(undoRing[index]);
+  hash = keyRing[index];
+  undoCount--;
+  redoCount++;
+  plyCount--;
+  return true;
+}
+
+bool ChessEngine::redoMove() {
+  if (redoCount == 0) {
+    return false;
+  }
+  int index = undoTop & HISTORY_MASK;
+  Move move = undoRing[index].move;
+  keyRing[index] = hash;
+  makeMove(move, undoRing[index]);
+  undoTop++;
+  undoCount++;
+  redoCount--;
+  plyCount++;
+  return true;
+}
+
+Move ChessEngine::getLastMove() const {
+  Move move = {0, 0, EMPTY, 0};
+  if (undoCount > 0) {
+    move = undoRing[(undoTop - 1) & HISTORY_MASK].move;
+  }
+  return move;
+}
+
+// ========================================
+// Move text
+// ========================================
+
+Move ChessEngine::parseMove(const char* moveStr) const {
+  Move move = {0, 0, EMPTY, 0};
+  if (!moveStr) return move;
+
+  // Web coordinates: "fromRow,fromCol,toRow,toCol"
+  if (strchr(moveStr, ',')) {
+    int values[4];
+    int count = 0;
+    const char* p = moveStr;
+    while (count < 4 && *p) {
+      if (*p >= '0' && *p <= '7') {
+        values[count++] = *p - '0';
+        p++;
+        if (*p && *p != ',') return move;
+      }
+      if (*p) p++;
+    }
+    if (count == 4) {
+      move.from = values[0] * 8 + values[1];
+      move.to = values[2] * 8 + values[3];
+    }
+    return move;
+  }
+
+  // UCI: "e2e4", with an optional promotion piece "e7e8q"
+  size_t len = strlen(moveStr);
+  if (len < 4 || len > 5) return move;
+  if (moveStr[0] < 'a' || moveStr[0] > 'h' || moveStr[1] < '1' || moveStr[1] > '8' ||
+      moveStr[2] < 'a' || moveStr[2] > 'h' || moveStr[3] < '1' || moveStr[3] > '8') {
+    return move;
+  }
+  move.from = (8 - (moveStr[1] - '0')) * 8 + (moveStr[0] - 'a');
+  move.to = (8 - (moveStr[3] - '0')) * 8 + (moveStr[2] - 'a');
+  if (len == 5) {
+    PieceType promotion = pieceTypeFromChar(moveStr[4]);
+    if (promotion == EMPTY || promotion == PAWN || promotion == KING) {
+      move.from = move.to = 0;
+      return move;
+    }
+    move.promotion = promotion;
+  }
+  return move;
+}
+
+size_t ChessEngine::formatUCI(const Move& move, char* buffer, size_t size) {
+  if (!buffer || size < CHESS_UCI_MAX || !move.isValid()) return 0;
+
+  char* out = buffer;
+  *out++ = 'a' + move.fromCol();
+  *out++ = '8' - move.fromRow();
+  *out++ = 'a' + move.toCol();
+  *out++ = '8' - move.toRow();
+  if (move.promotion != EMPTY) {
+    *out++ = pieceTypeChar((PieceType)move.promotion);
+  }
+  *out = '\0';
+  return out - buffer;
+}
+
+// SAN for a legal move: piece letter, just enough of the origin square to tell
+// apart other pieces of the same type reaching the same square, capture,
+// destination, promotion and check/mate suffix
+size_t ChessEngine::formatSAN(const Move& move, char* buffer, size_t size) {
+  static const char pieceLetters[] = " PRNBQK";
+  Move legal;
+  if (!buffer || size < CHESS_SAN_MAX || !findLegalMove(move, legal)) return 0;
+
+  char* out = buffer;
+  PieceType type = pieceType(board[legal.from]);
+
+  if (legal.flags & MOVE_FLAG_CASTLE) {
+    const char* castle = (legal.to > legal.from) ? "O-O" : "O-O-O";
+    while (*castle) *out++ = *castle++;
+  } else {
+    if (type == PAWN) {
+      if (legal.flags & MOVE_FLAG_CAPTURE) {
+        *out++ = 'a' + legal.fromCol();
+      }
+    } else {
+      *out++ = pieceLetters[type];
+
+      // Other legal moves of the same piece type to the same square
+      bool ambiguous = false, sameFile = false, sameRank = false;
+      Move moves[CHESS_MAX_MOVES];
+      int count = generatePseudoLegalMoves(moves);
+      bool inCheck = isInCheck(currentPlayer);
+      for (int i = 0; i < count; i++) {
+        const Move& other = moves[i];
+        if (other.to != legal.to || other.from == legal.from ||
+            pieceType(board[other.from]) != type || leavesKingInCheck(other, inCheck)) {
+          continue;
+        }
+        ambiguous = true;
+        if (other.fromCol() == legal.fromCol()) sameFile = true;
+        if (other.fromRow() == legal.fromRow()) sameRank = true;
+      }
+      if (ambiguous) {
+        if (!sameFile || sameRank) *out++ = 'a' + legal.fromCol();
+        if (sameFile) *out++ = '8' - legal.fromRow();
+      }
+    }
+
+    if (legal.flags & MOVE_FLAG_CAPTURE) *out++ = 'x';
+    *out++ = 'a' + legal.toCol();
+    *out++ = '8' - legal.toRow();
+    if (legal.promotion != EMPTY) {
+      *out++ = '=';
+      *out++ = pieceLetters[legal.promotion];
+    }
+  }
+
+  // Check or mate - play the move to find out
+  uint64_t keyBefore = hash;
+  UndoRecord record;
+  makeMove(legal, record);
+  if (isInCheck(currentPlayer)) {
+    *out++ = hasLegalMoves() ? '+' : '#';
+  }
+  unmakeMove(record);
+  hash = keyBefore;
+
+  *out = '\0';
+  return out - buffer;
+}
+
+Move ChessEngine::parseSAN(const char* san) {
+  Move none = {0, 0, EMPTY, 0};
+  if (!san) return none;
+
+  // Copy without surrounding spaces and annotation suffixes (+, #, !, ?)
+  char text[12];
+  size_t len = 0;
+  while (*san == ' ') san++;
+  while (san[len] && san[len] != ' ') {
+    if (len >= sizeof(text) - 1) return none;
+    text[len] = san[len];
+    len++;
+  }
+  while (len > 0 && (text[len - 1] == '+' || text[len - 1] == '#' ||
+                     text[len - 1] == '!' || text[len - 1] == '?')) {
+    len--;
+  }
+  text[len] = '\0';
+  if (len < 2) return none;
+
+  // Castling, with letter O or digit zero
+  if (strcmp(text, "O-O") == 0 || strcmp(text, "0-0") == 0 ||
+      strcmp(text, "O-O-O") == 0 || strcmp(text, "0-0-0") == 0) {
+    int home = (currentPlayer == WHITE) ? 60 : 4;
+    Move castle = {(uint8_t)home, (uint8_t)(len == 3 ? home + 2 : home - 2), EMPTY, 0};
+    Move legal;
+    return (findLegalMove(castle, legal) && (legal.flags & MOVE_FLAG_CASTLE)) ? legal : none;
+  }
+
+  // Piece letter - lowercase letters are pawn files, so "b" never means bishop
+  const char* p = text;
+  const char* end = text + len;
+  PieceType type = PAWN;
+  if (*p == 'N' || *p == 'B' || *p == 'R' || *p == 'Q' || *p == 'K') {
+    type = pieceTypeFromChar(*p++);
+  }
+
+  // Promotion suffix: "=Q" or a bare trailing piece letter ("e8Q")
+  uint8_t promotion = EMPTY;
+  if (end - p >= 3 && pieceTypeFromChar(end[-1]) != EMPTY && (end[-1] < 'a' || end[-1] > 'h')) {
+    promotion = pieceTypeFromChar(end[-1]);
+    end--;
+    if (end[-1] == '=') end--;
+    if (type != PAWN || promotion == PAWN || promotion == KING) return none;
+  }
+
+  // Destination is the last square; anything between is origin file/rank and 'x'
+  if (end - p < 2 || end[-2] < 'a' || end[-2] > 'h' || end[-1] < '1' || end[-1] > '8') return none;
+  int to = ('8' - end[-1]) * 8 + (end[-2] - 'a');
+  int fromCol = -1, fromRow = -1;
+  bool capture = false;
+  for (const char* q = p; q < end - 2; q++) {
+    if (*q >= 'a' && *q <= 'h' && fromCol < 0) {
+      fromCol = *q - 'a';
+    } else if (*q >= '1' && *q <= '8' && fromRow < 0) {
+      fromRow = '8' - *q;
+    } else if ((*q == 'x' || *q == ':') && !capture) {
+      capture = true;
+    } else if (*q != '-') {
+      return none;
+    }
+  }
+
+  Move match = none;
+  int matches = 0;
+  Move moves[CHESS_MAX_MOVES];
+  int count = generatePseudoLegalMoves(moves);
+  bool inCheck = isInCheck(currentPlayer);
+  for (int i = 0; i < count; i++) {
+    const Move& move = moves[i];
+    if (move.to != to || pieceType(board[move.from]) != type) continue;
+    if (fromCol >= 0 && move.fromCol() != fromCol) continue;
+    if (fromRow >= 0 && move.fromRow() != fromRow) continue;
+    if (capture && !(move.flags & MOVE_FLAG_CAPTURE)) continue;
+    // A promotion without a piece letter is taken as a queen
+    uint8_t wanted = promotion ? promotion : (move.promotion ? (uint8_t)QUEEN : (uint8_t)EMPTY);
+    if (move.promotion != wanted) continue;
+    if (move.flags & MOVE_FLAG_CASTLE) continue;
+    if (leavesKingInCheck(move, inCheck)) continue;
+    match = move;
+    matches++;
+  }
+  return matches == 1 ? match : none;
+}
+
+int ChessEngine::syncMoveList(const char* uciMoves) {
+  // Count the moves and check the ones we already have still match
+  int total = 0;
+  bool prefixMatches = true;
+  const char* p = uciMoves ? uciMoves : "";
+  int lastKnown = plyCount - 1;
+  Move lastMove = getLastMove();
+
+  while (*p) {
+    while (*p == ' ') p++;
+    if (!*p) break;
+    const char* start = p;
+    while (*p && *p != ' ') p++;
+
+    if (total == lastKnown) {
+      char token[8];
+      size_t len = p - start;
+      if (len >= sizeof(token) || undoCount == 0) {
+        prefixMatches = false;
+      } else {
+        memcpy(token, start, len);
+        token[len] = '\0';
+        prefixMatches = parseMove(token).sameAs(lastMove);
+      }
+    }
+    total++;
+  }
+
+  // A shorter list (takeback) or a different history means replaying from the start
+  int skip = plyCount;
+  if (total < plyCount || !prefixMatches) {
+    initializeBoard();
+    skip = 0;
+  }
+
+  int applied = 0;
+  int index = 0;
+  p = uciMoves ? uciMoves : "";
+  while (*p) {
+    while (*p == ' ') p++;
+    if (!*p) break;
+    const char* start = p;
+    while (*p && *p != ' ') p++;
+
+    if (index++ < skip) continue;
+
+    char token[8];
+    size_t len = p - start;
+    if (len >= sizeof(token)) return -1;
+    memcpy(token, start, len);
+    token[len] = '\0';
+    if (!playMove(token)) return -1;
+    applied++;
+  }
+  return applied;
+}
+
+// ========================================
+// Game result
+// ========================================
+
+bool ChessEngine::isInsufficientMaterial() const {
+  int minorPieces = 0;
+  int bishopSquareColors = 0;   // Bit 0: bishop on a light square, bit 1: on a dark square
+  bool hasKnight = false;
+
+  for (int square = 0; square < 64; square++) {
+    switch (pieceType(board[square])) {
+      case PAWN:
+      case ROOK:
+      case QUEEN:
+        return false;
+      case KNIGHT:
+        minorPieces++;
+        hasKnight = true;
+        break;
+      case BISHOP:
+        minorPieces++;
+        bishopSquareColors |= (((square >> 3) + (square & 7)) & 1) ? 2 : 1;
+        break;
+      default:
+        break;
+    }
+  }
+
+  // K vs K, K+minor vs K, or only bishops all on one square color
+  if (minorPieces <= 1) return true;
+  return !hasKnight && bishopSquareColors != 3;
+}
+
+// Number of times the current position has occurred, counting itself.
+// Only positions since the last irreversible move can repeat, and only with
+// the same side to move, so every other key is checked.
+int ChessEngine::countRepetitions() const {
+  int count = 1;
+  int limit = halfMoveClock < undoCount ? halfMoveClock : undoCount;
+  for (int back = 2; back <= limit; back += 2) {
+    if (keyRing[(undoTop - back) & HISTORY_MASK] == hash) {
+      count++;
+    }
+  }
+  return count;
+}
+
+GameResult ChessEngine::getGameResult() {
+  if (!hasLegalMoves()) {
+    if (isInCheck(currentPlayer)) {
+      return currentPlayer == WHITE ? BLACK_WINS : WHITE_WINS;
+    }
+    return DRAW_STALEMATE;
+  }
+  if (isInsufficientMaterial()) return DRAW_INSUFFICIENT;
+  if (halfMoveClock >= 100) return DRAW_50MOVE;
+  if (countRepetitions() >= 3) return DRAW_REPETITION;
+  return GAME_ONGOING;
+}
+
+bool ChessEngine::isGameOver() {
+  return getGameResult() != GAME_ONGOING;
+}
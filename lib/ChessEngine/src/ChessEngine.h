@@ -0,0 +1,222 @@
+#ifndef CHESS_ENGINE_H
+#define CHESS_ENGINE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * ChessEngine.h
+ *
+ * Chess rules core shared by every game mode (local board, Gemini AI, Lichess)
+ * - Position with incremental Zobrist key
+ * - Pseudo-legal move generation; legality from pin lines, make/unmake when needed
+ * - Attack detection by table lookup (see AttackTables.h)
+ * - Undo/redo ring with O(1) cost per ply
+ * - Check, mate, stalemate and draw detection
+ * - FEN import/export into caller-provided buffers
+ * - UCI and SAN move parsing/formatting with legality-aware disambiguation
+ *
+ * Has no Arduino dependency and never allocates, so it also builds natively.
+ *
+ * Squares are indexed row * 8 + col with row 0 = rank 8 and col 0 = file a,
+ * the same orientation the web board uses.
+ */
+
+#define BOARD_SIZE 8
+#define CHESS_MAX_MOVES 256          // Move list capacity (legal positions never exceed 218)
+
+// Longest FEN getFEN() can write, plus terminator: 71 placement (8 pieces per rank,
+// 7 slashes), side, "KQkq", en passant square, two 5-digit clocks and 5 spaces
+#define CHESS_FEN_MAX 94
+#define CHESS_SAN_MAX 8              // Longest SAN ("Qa1xb2+", "exd8=Q#") plus terminator
+#define CHESS_UCI_MAX 6              // Longest UCI ("e7e8q") plus terminator
+
+#ifndef CHESS_HISTORY_CAPACITY
+#define CHESS_HISTORY_CAPACITY 256   // Undo ring size in plies (must be a power of 2)
+#endif
+
+enum PieceType {
+  EMPTY = 0,
+  PAWN = 1,
+  ROOK = 2,
+  KNIGHT = 3,
+  BISHOP = 4,
+  QUEEN = 5,
+  KING = 6
+};
+
+enum PieceColor {
+  WHITE = 0,
+  BLACK = 1
+};
+
+struct Piece {
+  PieceType type;
+  PieceColor color;
+};
+
+// Castling rights bits
+#define CASTLE_WHITE_KINGSIDE  0x01
+#define CASTLE_WHITE_QUEENSIDE 0x02
+#define CASTLE_BLACK_KINGSIDE  0x04
+#define CASTLE_BLACK_QUEENSIDE 0x08
+#define CASTLE_ALL             0x0F
+
+// Move flags (filled in by move generation)
+#define MOVE_FLAG_CAPTURE     0x01
+#define MOVE_FLAG_DOUBLE_PUSH 0x02
+#define MOVE_FLAG_EN_PASSANT  0x04
+#define MOVE_FLAG_CASTLE      0x08
+
+struct Move {
+  uint8_t from;        // Source square
+  uint8_t to;          // Destination square
+  uint8_t promotion;   // PieceType to promote to, EMPTY if none
+  uint8_t flags;       // MOVE_FLAG_* bits
+
+  int fromRow() const { return from >> 3; }
+  int fromCol() const { return from & 7; }
+  int toRow() const { return to >> 3; }
+  int toCol() const { return to & 7; }
+  bool isValid() const { return from != to; }
+  bool sameAs(const Move& other) const {
+    return from == other.from && to == other.to && promotion == other.promotion;
+  }
+};
+
+enum GameResult {
+  GAME_ONGOING,
+  WHITE_WINS,
+  BLACK_WINS,
+  DRAW_STALEMATE,
+  DRAW_INSUFFICIENT,
+  DRAW_50MOVE,
+  DRAW_REPETITION
+};
+
+class ChessEngine {
+private:
+  // One compact record per ply - enough to unmake or redo the move
+  struct UndoRecord {
+    Move move;
+    uint8_t captured;          // Piece code captured, 0 if none
+    uint8_t castlingRights;    // Castling rights before the move
+    int8_t enPassantFile;      // En passant file before the move, -1 if none
+    uint16_t halfMoveClock;    // Halfmove clock before the move
+  };
+
+  uint8_t board[64];           // Piece codes: type | (color << 3), 0 = empty
+  uint64_t pieceBitboards[2][7];  // Squares of each color and piece type, kept in step with board
+  uint64_t colorBitboards[2];     // All squares of each color
+  PieceColor currentPlayer;
+  uint8_t castlingRights;
+  int8_t enPassantFile;        // File of a pawn that just double-pushed, -1 if none
+  uint16_t halfMoveClock;
+  uint16_t fullMoveNumber;
+  uint8_t kingSquare[2];
+  uint64_t hash;               // Zobrist key of the current position
+
+  // Undo ring - keyRing[i] is the position key before the ply in undoRing[i]
+  UndoRecord undoRing[CHESS_HISTORY_CAPACITY];
+  uint64_t keyRing[CHESS_HISTORY_CAPACITY];
+  uint16_t undoTop;            // Ring position one past the last applied ply
+  uint16_t undoCount;          // Plies that can be undone
+  uint16_t redoCount;          // Undone plies that can be redone
+  uint16_t plyCount;           // Plies played since the start position
+
+  void initializeBoard();
+  void clearBoard();
+  void setSquare(int square, uint8_t piece);
+  void rebuildBitboards();
+  void putPiece(int square, uint8_t piece);
+  void removePiece(int square);
+  void makeMove(const Move& move, UndoRecord& record);
+  void unmakeMove(const UndoRecord& record);
+  void pushMove(const Move& move);
+  int generatePseudoLegalMoves(Move* moves) const;
+  void addPawnMoves(int from, Move* moves, int& count) const;
+  void addSlidingMoves(int from, const int8_t (*directions)[2], int directionCount, Move* moves, int& count) const;
+  void addStepMoves(int from, uint64_t targets, Move* moves, int& count) const;
+  void addCastlingMoves(Move* moves, int& count) const;
+  bool leavesKingInCheck(const Move& move, bool inCheck);
+  int getEnPassantHashFile() const;
+  void computeHash();
+
+public:
+  ChessEngine();
+
+  void begin();
+  void resetGame();
+
+  // FEN - setFEN() replaces the position and clears the move history; on a
+  // malformed or impossible position it returns false and leaves the board unchanged.
+  // getFEN() returns the length written, or 0 if the buffer is smaller than CHESS_FEN_MAX.
+  bool setFEN(const char* fen);
+  size_t getFEN(char* buffer, size_t size) const;
+
+  // Move input - UCI ("e2e4", "e7e8n") or web coordinates ("6,4,4,4")
+  // Returns a move with isValid() == false if the text cannot be parsed
+  Move parseMove(const char* moveStr) const;
+  // SAN ("Nbd7", "exd8=N+", "O-O") resolved against the legal moves.
+  // Returns an invalid move if no legal move or more than one matches.
+  Move parseSAN(const char* san);
+  // Any of the above - UCI/coordinates first, then SAN
+  bool playMove(const char* moveStr);
+  bool playMove(const Move& move);
+
+  // Move output - return the length written, or 0 if the buffer is too small
+  // or (for SAN) the move is not legal in the current position
+  static size_t formatUCI(const Move& move, char* buffer, size_t size);
+  size_t formatSAN(const Move& move, char* buffer, size_t size);
+
+  // Undo/redo one ply
+  bool undoMove();
+  bool redoMove();
+  int getUndoDepth() const { return undoCount; }
+  int getRedoDepth() const { return redoCount; }
+  Move getLastMove() const;
+
+  // Bring the position in line with a space separated UCI move list, applying
+  // only the moves not seen yet. A list that does not extend the current
+  // history is replayed from the standard start position.
+  // Returns the number of plies applied, or -1 if the list contains an illegal move
+  int syncMoveList(const char* uciMoves);
+
+  // Move generation and legality
+  int generateLegalMoves(Move* moves);
+  bool findLegalMove(const Move& candidate, Move& legalMove);
+  bool isLegalMove(const Move& move);
+  bool hasLegalMoves();
+  // Leaf node count of the legal move tree - for validating move generation
+  // against published results. Does not touch the move history.
+  uint64_t perft(int depth);
+
+  // Board state queries
+  PieceColor getCurrentPlayer() const { return currentPlayer; }
+  Piece getPiece(int row, int col) const;
+  uint8_t getPieceCode(int square) const { return board[square]; }
+  bool isInCheck(PieceColor color) const;
+  bool isSquareAttacked(int row, int col, PieceColor attackingColor) const;
+  bool isSquareAttacked(int square, PieceColor attackingColor) const;
+  bool isInsufficientMaterial() const;
+  int countRepetitions() const;
+
+  GameResult getGameResult();
+  bool isGameOver();
+
+  uint64_t getHash() const { return hash; }
+  int getHalfMoveClock() const { return halfMoveClock; }
+  int getFullMoveNumber() const { return fullMoveNumber; }
+  int getPly() const { return plyCount; }
+  uint8_t getCastlingRights() const { return castlingRights; }
+  int getEnPassantFile() const { return enPassantFile; }
+
+  // Piece code helpers
+  static PieceType pieceType(uint8_t piece) { return (PieceType)(piece & 7); }
+  static PieceColor pieceColor(uint8_t piece) { return (PieceColor)(piece >> 3); }
+  static uint8_t makePiece(PieceType type, PieceColor color) { return type | (color << 3); }
+  static char pieceTypeChar(PieceType type);        // 'p', 'r', 'n', 'b', 'q', 'k' or 0
+  static PieceType pieceTypeFromChar(char c);       // Either case, EMPTY if unknown
+};
+
+#endif
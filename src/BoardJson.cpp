@@ -0,0 +1,88 @@
+#include "BoardJson.h"
+
+// Web client piece codes indexed by engine piece code (type | color << 3)
+static const char* const PIECE_CODE_TEXT[16] = {
+  "", "wp", "wr", "wn", "wb", "wq", "wk", "",
+  "", "bp", "br", "bn", "bb", "bq", "bk", ""
+};
+
+const char* pieceCodeText(uint8_t piece) {
+  return PIECE_CODE_TEXT[piece & 0x0F];
+}
+
+String buildStatusJSON(ChessEngine& engine) {
+  String status = "{";
+  bool isWhiteTurn = engine.getCurrentPlayer() == WHITE;
+  status += "\"currentPlayer\":\"" + String(isWhiteTurn ? "White" : "Black") + "\",";
+  status += "\"gameActive\":true,";
+  status += "\"moveCount\":" + String(engine.getPly()) + ",";
+  status += "\"status\":\"ready\",";
+
+  // Check if either king is in check
+  bool whiteInCheck = engine.isInCheck(WHITE);
+  bool blackInCheck = engine.isInCheck(BLACK);
+
+  status += "\"whiteInCheck\":" + String(whiteInCheck ? "true" : "false") + ",";
+  status += "\"blackInCheck\":" + String(blackInCheck ? "true" : "false") + ",";
+
+  // Checkmate/stalemate only ever applies to the side to move
+  GameResult result = engine.getGameResult();
+  status += "\"whiteCheckmate\":" + String(result == BLACK_WINS ? "true" : "false") + ",";
+  status += "\"blackCheckmate\":" + String(result == WHITE_WINS ? "true" : "false") + ",";
+  status += "\"stalemate\":" + String(result == DRAW_STALEMATE ? "true" : "false") + ",";
+
+  // Draw adjudication from the position history
+  int repetitions = engine.countRepetitions();
+  uint64_t positionHash = engine.getHash();
+  char hashHex[17];
+  snprintf(hashHex, sizeof(hashHex), "%08lx%08lx", (unsigned long)(positionHash >> 32), (unsigned long)(positionHash & 0xFFFFFFFF));
+
+  status += "\"halfmoveClock\":" + String(engine.getHalfMoveClock()) + ",";
+  status += "\"repetitionCount\":" + String(repetitions) + ",";
+  status += "\"threefoldRepetition\":" + String(repetitions >= 3 ? "true" : "false") + ",";
+  status += "\"fiftyMoveRule\":" + String(engine.getHalfMoveClock() >= 100 ? "true" : "false") + ",";
+  status += "\"insufficientMaterial\":" + String(result == DRAW_INSUFFICIENT ? "true" : "false") + ",";
+  status += "\"positionHash\":\"" + String(hashHex) + "\",";
+  status += "\"checkMessage\":\"\"";
+
+  status += "}";
+
+  return status;
+}
+
+String buildBoardJSON(const uint8_t board[64], uint32_t epoch, uint32_t version) {
+  char json[512];
+  size_t len = snprintf(json, sizeof(json), "{\"epoch\":%lu,\"version\":%lu,\"full\":true,\"board\":[",
+                        (unsigned long)epoch, (unsigned long)version);
+
+  for (int row = 0; row < 8; row++) {
+    json[len++] = row > 0 ? ',' : '[';
+    if (row > 0) json[len++] = '[';
+    for (int col = 0; col < 8; col++) {
+      len += snprintf(json + len, sizeof(json) - len, "%s\"%s\"", col > 0 ? "," : "",
+                      pieceCodeText(board[row * 8 + col]));
+    }
+    json[len++] = ']';
+  }
+
+  snprintf(json + len, sizeof(json) - len, "]}");
+  return String(json);
+}
+
+size_t buildBoardDeltaJSON(char* buffer, size_t size, const uint8_t board[64], uint32_t epoch,
+                           uint32_t version, uint64_t changed) {
+  size_t len = snprintf(buffer, size, "{\"epoch\":%lu,\"version\":%lu,\"full\":false,\"changes\":[",
+                        (unsigned long)epoch, (unsigned long)version);
+  bool first = true;
+  for (int square = 0; square < 64 && len < size; square++) {
+    if (changed & (1ULL << square)) {
+      len += snprintf(buffer + len, size - len, "%s[%d,\"%s\"]", first ? "" : ",",
+                      square, pieceCodeText(board[square]));
+      first = false;
+    }
+  }
+  if (len < size) {
+    len += snprintf(buffer + len, size - len, "]}");
+  }
+  return len;
+}
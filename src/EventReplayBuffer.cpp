@@ -0,0 +1,61 @@
+#include "EventReplayBuffer.h"
+
+void EventReplayBuffer::clear() {
+    _head = 0;
+    _count = 0;
+    _writePos = 0;
+    _nextId = 1;
+}
+
+void EventReplayBuffer::dropOldest() {
+    _head = (_head + 1) % SSE_REPLAY_EVENTS;
+    _count--;
+}
+
+bool EventReplayBuffer::overlapsKept(uint16_t offset, uint16_t size) const {
+    for (int i = 0; i < _count; i++) {
+        const Entry& entry = _entries[(_head + i) % SSE_REPLAY_EVENTS];
+        if (offset < entry.offset + entry.length + 1 && entry.offset < offset + size) {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t EventReplayBuffer::add(const char* event, const char* message) {
+    uint32_t id = _nextId++;
+    size_t length = strlen(message);
+    if (length + 1 > SSE_REPLAY_BYTES) {
+        // Earlier events stay out of reach too - replaying them without this one would skip it
+        _head = 0;
+        _count = 0;
+        _writePos = 0;
+        return id;
+    }
+
+    uint16_t size = length + 1;
+    if (_writePos + size > SSE_REPLAY_BYTES) {
+        _writePos = 0;
+    }
+    // Oldest first, until the new message's bytes are free
+    while (_count == SSE_REPLAY_EVENTS || (_count > 0 && overlapsKept(_writePos, size))) {
+        dropOldest();
+    }
+
+    Entry& entry = _entries[(_head + _count) % SSE_REPLAY_EVENTS];
+    entry.id = id;
+    entry.event = event;
+    entry.offset = _writePos;
+    entry.length = length;
+    memcpy(_data + _writePos, message, size);
+    _writePos += size;
+    _count++;
+    return id;
+}
+
+void EventReplayBuffer::get(int index, uint32_t& id, const char*& event, const char*& message) const {
+    const Entry& entry = _entries[(_head + index) % SSE_REPLAY_EVENTS];
+    id = entry.id;
+    event = entry.event;
+    message = _data + entry.offset;
+}
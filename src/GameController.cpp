@@ -12,6 +12,7 @@ GameController::GameController() {
   currentState = GAME_IDLE;
   gameId = "";
   totalMoves = 0;
+  chess = nullptr;
   webInterface = nullptr;
 }
 
@@ -43,6 +44,10 @@ void GameController::startNewGame() {
   currentState = GAME_WAITING_USER; // Start with user's turn (white goes first)
   gameId = generateGameId();
   totalMoves = 0;
+
+  if (chess) {
+    chess->resetGame();
+  }
 }
 
 void GameController::pauseGame() {
@@ -129,6 +134,10 @@ bool GameController::submitUserMove(const String& move) {
     return false;
   }
 
+  // Reject illegal moves before touching any game state
+  if (chess && !chess->playMove(move.c_str())) {
+    return false;
+  }
 
   // Process the user's move
   player1.lastMove = move;
@@ -144,6 +153,11 @@ bool GameController::submitUserMove(const String& move) {
     delay(50); // Give async_tcp time to process
   }
 
+  if (chess && chess->isGameOver()) {
+    currentState = GAME_FINISHED;
+    return true;
+  }
+
   // Switch to AI's turn
   currentState = GAME_WAITING_AI;
   lastMoveTime = millis();
@@ -173,8 +187,12 @@ void GameController::requestAIMove() {
   unsigned long startTime = millis();
 
   // Build current position and move history strings
-  // For now, use simple format - could be enhanced with FEN notation
-  String position = "starting position"; // Placeholder
+  String position = "starting position";
+  if (chess) {
+    char fen[CHESS_FEN_MAX];
+    chess->getFEN(fen, sizeof(fen));
+    position = fen;
+  }
   String moveHistory = "";
 
   // Build move history from player moves
@@ -229,6 +247,12 @@ void GameController::requestAIMove() {
 
   unsigned long thinkTime = millis() - startTime;
 
+  // An AI reply the rules engine refuses counts as a failed request
+  if (!aiMove.isEmpty() && chess && !chess->playMove(aiMove.c_str())) {
+    Serial.printf("AI move rejected by engine: %s\n", aiMove.c_str());
+    aiMove = "";
+  }
+
   if (!aiMove.isEmpty()) {
     // Reset failure counter on success
     consecutiveFailures = 0;
@@ -248,7 +272,7 @@ void GameController::requestAIMove() {
     }
 
     // Switch back to user's turn
-    currentState = GAME_WAITING_USER;
+    currentState = (chess && chess->isGameOver()) ? GAME_FINISHED : GAME_WAITING_USER;
 
 
     // Aggressive yielding to prevent async_tcp watchdog timeout
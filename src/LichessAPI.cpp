@@ -3,18 +3,28 @@
 #include "SDLogger.h"
 
 LichessAPI::LichessAPI()
-    : _streaming(false), _streamClient(nullptr), _state(STATE_IDLE),
-      _stateStartTime(0), _wasStreaming(false), _retryAttempt(0), _retryDelay(0),
+    : _nextCommandId(1), _playerToMove(true), _pool(nullptr), _stream(nullptr), _request(nullptr),
+      _streamRequest(nullptr), _streamClient(nullptr), _streaming(false), _streamOpenedAt(0),
+      _streamRecovering(false), _streamRecovered(false), _streamReconnectAt(0),
+      _streamReconnectDelay(STREAM_RECONNECT_INITIAL_DELAY), _streamReconnects(0), _state(STATE_IDLE),
+      _stateStartTime(0), _wasStreaming(false), _dualConnectionEnabled(true), _retryAttempt(0), _retryDelay(0),
       _operationSuccess(false), _pendingLevel(3), _pendingTimeLimit(600), _pendingIncrement(0),
-      _lastHeartbeatTime(0), _heartbeatCount(0), _consecutiveFailures(0), _lastSuccessfulRequest(0) {
-    // Configure SSL client for insecure mode (development)
-    _client.setInsecure();
-    // Set connection timeout to prevent hanging (15 seconds)
-    _client.setTimeout(15);  // timeout in seconds for WiFiClientSecure
+      _pendingDrawAccept(true), _lastHeartbeatTime(0), _heartbeatCount(0), _moveStartTime(0),
+      _lastMoveLatency(0), _totalMoveLatency(0), _movesTimed(0), _lastMoveDual(false),
+      _deviceMoveMetrics(nullptr), _streamPly(-1), _handshakeCount(0), _lastHandshakeTime(0),
+      _totalHandshakeTime(0), _reusedConnections(0), _consecutiveFailures(0), _lastSuccessfulRequest(0),
+      _accountCheckStart(0) {
+    // TLS clients live in the shared LichessConnectionPool - see setConnectionPool()
+    _activeCommand.id = 0;
+    _commandLock = xSemaphoreCreateMutex();
 }
 
 LichessAPI::~LichessAPI() {
     stopStream();
+    cancelRequests();
+    if (_commandLock) {
+        vSemaphoreDelete(_commandLock);
+    }
 }
 
 bool LichessAPI::begin(const char* apiToken) {
@@ -26,11 +36,30 @@ bool LichessAPI::begin(const char* apiToken) {
     return true;
 }
 
-bool LichessAPI::testAccount(String& username) {
+LichessAPI::AccountCheck LichessAPI::pollAccountCheck(String& username) {
+    // Only request handlers call this, so the check is submitted without
+    // retries and picked up by whichever poll finds it done
+    if (!_request) {
+        if (!submitAPICall(API_ACCOUNT, "GET", "", false)) {
+            return ACCOUNT_CHECK_FAILED;
+        }
+        _accountCheckStart = millis();
+        return ACCOUNT_CHECK_PENDING;
+    }
+
     String response;
-    // Disable retry for testAccount - called from web handler, must not block too long
-    if (!makeAPICall(API_ACCOUNT, "GET", "", response, false)) {
-        return false;
+    bool success;
+    if (!finishAPICall(response, success)) {
+        if (millis() - _accountCheckStart < ACCOUNT_CHECK_TIMEOUT) {
+            return ACCOUNT_CHECK_PENDING;
+        }
+        _pool->finishRequest(_request);
+        _request = nullptr;
+        setError("Account check timed out");
+        return ACCOUNT_CHECK_FAILED;
+    }
+    if (!success) {
+        return ACCOUNT_CHECK_FAILED;
     }
 
     // Parse JSON response
@@ -39,16 +68,16 @@ bool LichessAPI::testAccount(String& username) {
 
     if (error) {
         setError("Failed to parse account response");
-        return false;
+        return ACCOUNT_CHECK_FAILED;
     }
 
     if (doc["username"].is<const char*>()) {
         username = doc["username"].as<String>();
-        return true;
+        return ACCOUNT_CHECK_OK;
     }
 
     setError("No username in response");
-    return false;
+    return ACCOUNT_CHECK_FAILED;
 }
 
 String LichessAPI::createAIGame(int level, int timeLimitSeconds, int incrementSeconds, const char* color) {
@@ -109,13 +138,24 @@ bool LichessAPI::makeMove(const String& gameId, const String& uciMove) {
         return false;
     }
 
+    // The move reopens the stream itself afterwards
+    _streamRecovering = false;
+
     // Store move details for async processing
     _pendingGameId = gameId;
     _pendingMove = uciMove;
-    _wasStreaming = _streaming;
+    _moveStartTime = millis();
+    _stateStartTime = _moveStartTime;
+
+    // With room for a second TLS session the stream stays open during the move
+    _lastMoveDual = _streaming && canUseDualConnection();
+    _wasStreaming = _streaming && !_lastMoveDual;
 
     // Start async state machine
-    if (_wasStreaming) {
+    if (_lastMoveDual) {
+        _state = STATE_MAKING_MOVE;
+        LOG_PRINTF("[%lu] MOVE START: %s (game: %s) - stream kept open (dual connection)\n", millis(), uciMove.c_str(), gameId.c_str());
+    } else if (_wasStreaming) {
         // Set flag FIRST to stop processStreamEvents from accessing _streamClient
         _streaming = false;
         _state = STATE_WAITING_STREAM_STOP;
@@ -142,9 +182,12 @@ bool LichessAPI::resignGame(const String& gameId) {
         return false;
     }
 
-    // Store game ID for async processing
+    // Store game ID for async processing - no pending move, so the SSL cleanup
+    // step routes this to resign (a failed move can leave one behind)
     _pendingGameId = gameId;
+    _pendingMove = "";
     _wasStreaming = _streaming;
+    _streamRecovering = false;
 
     // Start async state machine
     if (_wasStreaming) {
@@ -163,227 +206,343 @@ bool LichessAPI::resignGame(const String& gameId) {
     return true;  // Resign initiated, will complete in process()
 }
 
+bool LichessAPI::offerDraw(const String& gameId, bool accept) {
+    if (gameId.length() == 0) {
+        setError("Invalid game ID");
+        return false;
+    }
+
+    // Check if already busy with another operation
+    if (_state != STATE_IDLE) {
+        setError("API busy with another operation");
+        return false;
+    }
+
+    // Goes out on the pool's API connection - the game stream stays open
+    _pendingGameId = gameId;
+    _pendingDrawAccept = accept;
+    _state = STATE_OFFERING_DRAW;
+    _stateStartTime = millis();
+    Serial.printf("Starting async draw %s\n", accept ? "offer" : "decline");
+
+    return true;  // Draw offer initiated, will complete in process()
+}
+
 bool LichessAPI::startStream(const String& gameId) {
     if (_streaming) {
         setError("Stream already active");
         return false;
     }
 
+    // Already on its way
+    if (_streamRequest) {
+        return true;
+    }
+
     if (gameId.length() == 0) {
         setError("Invalid game ID");
         return false;
     }
 
-    String url = String(API_BOARD_GAME_STREAM) + gameId;
-
-    // Start HTTPS connection with extended timeout
-    _streamHttp.begin(_client, url);
-    _streamHttp.addHeader("Authorization", "Bearer " + _apiToken);
-    _streamHttp.addHeader("Accept", "application/x-ndjson");
-    _streamHttp.setTimeout(30000); // 30 second timeout
-
-    Serial.println("Starting Lichess stream connection...");
-    yield(); // Feed watchdog
+    if (!_pool) {
+        setError("No connection pool");
+        return false;
+    }
 
-    int httpCode = _streamHttp.GET();
+    // Lichess is failing or rate limiting stream opens - don't spend a TLS session finding out again
+    if (_pool->isCircuitOpen(LichessConnectionPool::ENDPOINT_STREAM)) {
+        setCircuitError(_pool->getBreakerStatus(LichessConnectionPool::ENDPOINT_STREAM).retryIn);
+        return false;
+    }
 
-    yield(); // Feed watchdog after GET
-    Serial.printf("Stream connection response: %d\n", httpCode);
+    String url = String(API_BOARD_GAME_STREAM) + gameId;
+    _streamGameId = gameId;
 
-    if (httpCode != HTTP_CODE_OK) {
-        setError("Stream connection failed: " + String(httpCode));
-        _streamHttp.end();
+    // Lease one of the pool's stream connections for the life of the stream
+    _stream = _pool->acquireStream(this);
+    if (!_stream) {
+        setError("Stream connection failed: no free connection");
         return false;
     }
 
-    // Get stream client pointer
-    _streamClient = _streamHttp.getStreamPtr();
-    _streaming = true;
-    _streamBuffer = "";
+    // The worker connects and waits for the response headers; process() picks up the result
+    _streamRequest = _pool->submitStreamOpen(this, _stream, url, _apiToken);
+    if (!_streamRequest) {
+        setError("Stream connection failed: request queue full");
+        releaseStreamConnection();
+        return false;
+    }
 
-    Serial.println("Lichess stream started successfully");
+    Serial.println("Starting Lichess stream connection...");
     return true;
 }
 
 void LichessAPI::stopStream() {
+    // Stopped on purpose - the watchdog has nothing to bring back
+    _streamRecovering = false;
+
+    if (_streamRequest) {
+        // An open still in flight is closed by the worker; a finished one is ours to close
+        if (_pool->finishRequest(_streamRequest)) {
+            releaseStreamConnection();
+        } else {
+            _stream = nullptr;
+        }
+        _streamRequest = nullptr;
+        Serial.println("Lichess stream open cancelled");
+    }
+
     if (_streaming) {
-        _streamHttp.end();
+        releaseStreamConnection();
         _streamClient = nullptr;
         _streaming = false;
-        _streamBuffer = "";
         Serial.println("Lichess stream stopped");
     }
 }
 
-bool LichessAPI::processStreamEvents(String& eventJson) {
-    if (!_streaming || !_streamClient) {
+bool LichessAPI::processStreamEvents(char*& eventJson, size_t& length) {
+    if (!_streaming || !_streamClient || !_stream) {
         return false;
     }
 
-    // Read available data from stream client
-    while (_streamClient->available()) {
-        char c = _streamClient->read();
-
-        if (c == '\n') {
-            // Complete line received
-            if (_streamBuffer.length() > 0) {
-                // Return the complete JSON event
-                eventJson = _streamBuffer;
-                // Only log actual JSON events, not heartbeat packets.
-                // Lichess sends periodic heartbeat/keepalive messages (single chars like "1", "\n")
-                // to keep the HTTP stream connection alive. These are filtered out here.
-                if (eventJson.length() > 2 && (eventJson.startsWith("{") || eventJson.startsWith("["))) {
-                    LOG_PRINTF("[%lu] STREAM EVENT: %s\n", millis(), eventJson.substring(0, 100).c_str());
-                } else {
-                    // Track heartbeat packets for diagnostics
-                    _lastHeartbeatTime = millis();
-                    _heartbeatCount++;
-                }
-                _streamBuffer = "";
-                return true;
-            }
-        } else if (c != '\r') {
-            // Add to buffer (skip carriage return)
-            _streamBuffer += c;
-
-            // Prevent buffer overflow
-            if (_streamBuffer.length() > 4096) {
-                LOG_PRINTF("[%lu] WARNING: Stream buffer overflow, clearing\n", millis());
-                _streamBuffer = "";
-                setError("Stream buffer overflow");
-                return false;
-            }
-        }
+    // Block reads into the connection's fixed buffer; whole lines come back in place
+    NdjsonFramer& framer = _stream->framer;
+    bool gotEvent = framer.next(_streamClient, eventJson, length);
+
+    // Lichess sends empty keepalive lines to hold the stream open - the framer
+    // counts them instead of returning them, track them for diagnostics
+    _heartbeatCount = framer.getHeartbeatCount();
+    if (framer.getLastHeartbeatTime() > 0) {
+        _lastHeartbeatTime = framer.getLastHeartbeatTime();
+    }
+
+    if (gotEvent) {
+        LOG_PRINTF("[%lu] STREAM EVENT: %.100s\n", millis(), eventJson);
+        return true;
     }
 
-    // Check if connection is still alive
+    // A half-dead TCP connection can look connected for minutes - a stream
+    // that has missed several keepalives in a row is treated as gone too
+    if (getStreamSilence() >= LICHESS_STREAM_STALL_TIMEOUT) {
+        recoverStream("stalled");
+        return false;
+    }
     if (!_streamClient->connected()) {
-        Serial.println("Stream connection lost");
-        stopStream();
-        setError("Stream connection lost");
+        recoverStream("lost");
         return false;
     }
 
     return false;
 }
 
-// Private helper methods
+unsigned long LichessAPI::getStreamSilence() const {
+    if (!_streaming || !_stream) {
+        return 0;
+    }
+    unsigned long lastActivity = max(_stream->framer.getLastReadTime(), _streamOpenedAt);
+    return millis() - lastActivity;
+}
 
-bool LichessAPI::makeAPICall(const char* url, const char* method, const String& body, String& response, bool enableRetry) {
-    // Use shared _http client for API calls
-    // Note: This will work because the stream uses _streamHttp, not _http
-
-    Serial.printf("API Call: %s %s\n", method, url);
-    Serial.printf("API Token: %s (length: %d)\n", _apiToken.c_str(), _apiToken.length());
-
-    // Retry logic for SSL connection issues (max 3 attempts)
-    // Disabled for web handler context to avoid watchdog timeout
-    int maxRetries = enableRetry ? 3 : 1;
-    int retryDelay = 1000;  // Start with 1 second delay
-    int httpCode = -1;
-
-    for (int attempt = 1; attempt <= maxRetries; attempt++) {
-        // Begin connection
-        if (!_http.begin(_client, url)) {
-            if (attempt < maxRetries) {
-                Serial.printf("Begin failed (attempt %d/%d), retrying in %dms...\n",
-                             attempt, maxRetries, retryDelay);
-                delay(retryDelay);
-                retryDelay *= 2;
-                continue;
-            } else {
-                setError("Failed to connect to Lichess after " + String(maxRetries) + " attempts");
-                return false;
-            }
-        }
+// Drop a dead stream and schedule it to reopen - the opponent's moves made
+// meanwhile come back in the new stream's gameFull
+void LichessAPI::recoverStream(const char* reason) {
+    unsigned long silence = getStreamSilence();
+    // Backoff starts over after a stream that stayed up a while, but keeps
+    // growing for one that dies again right after reopening
+    if (millis() - _streamOpenedAt >= LICHESS_STREAM_STALL_TIMEOUT) {
+        _streamReconnectDelay = STREAM_RECONNECT_INITIAL_DELAY;
+    }
+    stopStream();
 
-        // Set headers
-        _http.addHeader("Authorization", "Bearer " + _apiToken);
-        if (body.length() > 0) {
-            _http.addHeader("Content-Type", "application/x-www-form-urlencoded");
-        }
-        _http.setTimeout(15000);
+    _streamRecovering = true;
+    _streamReconnects++;
+    unsigned long delay = LichessConnectionPool::jitter(_streamReconnectDelay);
+    _streamReconnectAt = millis() + delay;
+    _streamReconnectDelay = min(_streamReconnectDelay * 2, STREAM_RECONNECT_MAX_DELAY);
 
-        // Make request
-        if (strcmp(method, "POST") == 0) {
-            httpCode = _http.POST(body);
-        } else if (strcmp(method, "GET") == 0) {
-            httpCode = _http.GET();
-        } else {
-            setError("Unsupported HTTP method");
-            _http.end();
-            return false;
-        }
+    _lastError = String("Game stream ") + reason + " - reconnecting";
+    Serial.printf("Game stream %s after %lu ms silence (game %s) - reconnecting in %lu ms\n",
+                  reason, silence, _streamGameId.c_str(), delay);
+    LOG_PRINTF("[%lu] STREAM %s: reconnect #%lu scheduled\n", millis(), reason, _streamReconnects);
+}
 
-        // Check if we got connection error and should retry
-        // httpCode < 0: SSL/connection failure
-        // httpCode 1-99: Invalid HTTP status codes indicating connection issues
-        if (httpCode < 0 || (httpCode > 0 && httpCode < 100)) {
-            _http.end();  // Clean up before retry
-
-            if (attempt < maxRetries) {
-                Serial.printf("HTTP request failed (code: %d, attempt %d/%d), retrying in %dms...\n",
-                             httpCode, attempt, maxRetries, retryDelay);
-                delay(retryDelay);
-                retryDelay *= 2;  // Exponential backoff: 1s, 2s
-                continue;
-            } else {
-                // Run network diagnostics
-                runNetworkDiagnostics();
+void LichessAPI::processStreamRecovery() {
+    if (!_streamRecovering || _streaming || _streamRequest || _state != STATE_IDLE) {
+        return;
+    }
+    if ((long)(millis() - _streamReconnectAt) < 0) {
+        return;
+    }
 
-                if (httpCode < 0) {
-                    setError("HTTP request failed: " + _http.errorToString(httpCode));
-                } else {
-                    setError("HTTP connection error: " + String(httpCode));
-                }
-                return false;
-            }
-        }
+    // A failed open (breaker open, no free connection) leaves the flag set for the next try
+    startStream(_streamGameId);
+
+    unsigned long delay = LichessConnectionPool::jitter(_streamReconnectDelay);
+    _streamReconnectAt = millis() + delay;
+    _streamReconnectDelay = min(_streamReconnectDelay * 2, STREAM_RECONNECT_MAX_DELAY);
+}
 
-        // Success! Break out of retry loop
-        break;
+bool LichessAPI::takeStreamRecovered() {
+    bool recovered = _streamRecovered;
+    _streamRecovered = false;
+    return recovered;
+}
+
+// Private helper methods
+
+void LichessAPI::releaseStreamConnection() {
+    if (_pool && _stream) {
+        _pool->releaseStream(_stream);
     }
+    _stream = nullptr;
+}
 
-    // Check response code
-    if (httpCode < 0) {
-        setError("HTTP request failed after retries: " + _http.errorToString(httpCode));
-        _http.end();
+// Queue a request for the pool's worker; finishAPICall() collects the result
+bool LichessAPI::submitAPICall(const String& url, const char* method, const String& body, bool enableRetry) {
+    if (!_pool) {
+        setError("No connection pool");
         return false;
     }
 
-    // Treat invalid HTTP codes (1-99) as connection errors - these should have been caught in retry loop
-    if (httpCode > 0 && httpCode < 100) {
-        setError("HTTP connection error: " + String(httpCode) + " (invalid status code)");
-        _http.end();
+    _request = _pool->submitRequest(this, url, strcmp(method, "POST") == 0, body, _apiToken, enableRetry);
+    if (!_request) {
+        setError("Lichess API connection busy");
+        return false;
+    }
+    return true;
+}
+
+// Returns false while the request is still with the worker. Once it has
+// finished, fills in success and the response body and frees the request.
+bool LichessAPI::finishAPICall(String& response, bool& success) {
+    if (!_request) {
+        success = false;
+        return true;
+    }
+    if (!_pool->isDone(_request)) {
         return false;
     }
 
+    recordHandshake(_request);
+    if (_state == STATE_MAKING_MOVE && _moveTrace.isActive()) {
+        _moveTrace.sent = _request->startedAt;
+        _moveTrace.handshake = _request->handshakeTime;
+        _moveTrace.answered = _request->finishedAt;
+    }
+    int httpCode = _request->httpCode;
+    response = _request->response;
+    String error = _request->error;
+    String url = _request->url;
+    unsigned long retryAfter = _request->retryAfter;
+    _pool->finishRequest(_request);
+    _request = nullptr;
+
+    // Refused by the breaker without a network attempt - not a failure of this session's connection
+    if (httpCode == LichessConnectionPool::HTTP_CIRCUIT_OPEN) {
+        setCircuitError(retryAfter);
+        success = false;
+        return true;
+    }
+
+    // httpCode < 0: SSL/connection failure, 1-99: invalid status - the worker already retried
+    if (httpCode < 100) {
+        runNetworkDiagnostics();
+        setError(error.length() > 0 ? error : "HTTP request failed: " + String(httpCode));
+        success = false;
+        return true;
+    }
+
     if (httpCode != HTTP_CODE_OK && httpCode != HTTP_CODE_CREATED) {
-        response = _http.getString();
         Serial.printf("Lichess API Error Details:\n");
         Serial.printf("  HTTP Status: %d\n", httpCode);
-        Serial.printf("  Request URL: %s\n", url);
-        Serial.printf("  Request Method: %s\n", method);
+        Serial.printf("  Request URL: %s\n", url.c_str());
         Serial.printf("  API Token: %s (length: %d)\n", _apiToken.c_str(), _apiToken.length());
-        Serial.printf("  Authorization Header: Bearer %s\n", _apiToken.c_str());
-        Serial.printf("  Request Body: %s\n", body.c_str());
         Serial.printf("  Response Body: %s\n", response.c_str());
-        setError("HTTP error: " + String(httpCode));
-        _http.end();
-        return false;
+        if (httpCode == HTTP_CODE_TOO_MANY_REQUESTS) {
+            setError("Rate limited by Lichess - retry in " + String(retryAfter / 1000) + "s");
+        } else {
+            setError("HTTP error: " + String(httpCode));
+        }
+        success = false;
+        return true;
     }
 
-    // Get response
-    response = _http.getString();
-    _http.end();
-
     // Track successful request
     _consecutiveFailures = 0;
     _lastSuccessfulRequest = millis();
-
+    success = true;
     return true;
 }
 
+// A stream open queued by startStream() has finished on the worker
+void LichessAPI::completeStreamOpen() {
+    if (!_streamRequest || !_pool->isDone(_streamRequest)) {
+        return;
+    }
+
+    recordHandshake(_streamRequest);
+    int httpCode = _streamRequest->httpCode;
+    String error = _streamRequest->error;
+    unsigned long retryAfter = _streamRequest->retryAfter;
+    _pool->finishRequest(_streamRequest);
+    _streamRequest = nullptr;
+
+    if (httpCode != HTTP_CODE_OK) {
+        if (httpCode == LichessConnectionPool::HTTP_CIRCUIT_OPEN) {
+            setCircuitError(retryAfter);
+        } else {
+            setError(error);
+        }
+        releaseStreamConnection();
+        return;
+    }
+
+    // Get stream client pointer
+    _streamClient = _stream->http.getStreamPtr();
+    _streaming = true;
+    _streamOpenedAt = millis();
+    // First stream open after an accepted move is the one its echo comes on
+    if (_moveTrace.accepted > 0 && _moveTrace.resumed == 0 && _moveTrace.echoed == 0) {
+        _moveTrace.resumed = _streamOpenedAt;
+    }
+    if (_streamRecovering) {
+        _streamRecovering = false;
+        _streamRecovered = true;
+        Serial.printf("Game stream %s reopened - resyncing from gameFull\n", _streamGameId.c_str());
+    }
+    Serial.println("Lichess stream started successfully");
+}
+
+// Drop whatever is with the worker - the pool cleans up after requests nobody waits for
+void LichessAPI::cancelRequests() {
+    if (!_pool) {
+        return;
+    }
+    if (_request) {
+        _pool->finishRequest(_request);
+        _request = nullptr;
+    }
+    if (_streamRequest) {
+        stopStream();
+    }
+}
+
+void LichessAPI::recordHandshake(const LichessConnectionPool::Request* request) {
+    if (request->reused) {
+        _reusedConnections++;
+        return;
+    }
+    if (request->handshakeTime == 0) {
+        return;  // Never connected
+    }
+
+    _lastHandshakeTime = request->handshakeTime;
+    _totalHandshakeTime += _lastHandshakeTime;
+    _handshakeCount++;
+    Serial.printf("TLS handshake with %s: %lu ms (%lu handshakes, %lu reused)\n",
+                  LICHESS_HOST, _lastHandshakeTime, _handshakeCount, _reusedConnections);
+}
+
 void LichessAPI::setError(const String& error) {
     _lastError = error;
     Serial.print("LichessAPI Error: ");
@@ -394,13 +553,21 @@ void LichessAPI::setError(const String& error) {
     Serial.printf("Consecutive failures: %d/%d\n", _consecutiveFailures, MAX_CONSECUTIVE_FAILURES);
 }
 
-void LichessAPI::runNetworkDiagnostics() {
-    Serial.println("\n========== NETWORK DIAGNOSTICS ==========");
+// A request the pool refused because Lichess keeps failing or rate limited us.
+// Not counted as a consecutive failure: resetting this session's connections
+// cannot help while the breaker is open, and would only add to the storm.
+void LichessAPI::setCircuitError(unsigned long retryIn) {
+    _lastError = "Lichess unavailable - retrying in " + String((retryIn + 999) / 1000) + "s";
+    Serial.print("LichessAPI Error: ");
+    Serial.println(_lastError);
+}
 
-    // 0. Check Lichess heartbeat status (if streaming)
+// Stream health for a failed request - the worker has already run the
+// WiFi/DNS/connect checks (see LichessConnectionPool::runNetworkDiagnostics)
+void LichessAPI::runNetworkDiagnostics() {
     if (_streaming) {
         unsigned long timeSinceHeartbeat = millis() - _lastHeartbeatTime;
-        Serial.printf("0. Lichess Stream Status: ACTIVE\n");
+        Serial.printf("Lichess Stream Status: ACTIVE\n");
         Serial.printf("   Total heartbeats received: %lu\n", _heartbeatCount);
         Serial.printf("   Last heartbeat: %lu ms ago\n", timeSinceHeartbeat);
         if (timeSinceHeartbeat < 10000) {
@@ -409,116 +576,357 @@ void LichessAPI::runNetworkDiagnostics() {
             Serial.println("   ⚠ WARNING: No recent heartbeats (stream may be stalled)");
         }
     } else {
-        Serial.println("0. Lichess Stream Status: NOT STREAMING");
-    }
-
-    // 1. Check WiFi status
-    wl_status_t wifiStatus = WiFi.status();
-    Serial.printf("1. WiFi Status: %d ", wifiStatus);
-    switch(wifiStatus) {
-        case WL_CONNECTED: Serial.println("(CONNECTED)"); break;
-        case WL_NO_SHIELD: Serial.println("(NO_SHIELD)"); break;
-        case WL_IDLE_STATUS: Serial.println("(IDLE)"); break;
-        case WL_NO_SSID_AVAIL: Serial.println("(NO_SSID)"); break;
-        case WL_SCAN_COMPLETED: Serial.println("(SCAN_COMPLETED)"); break;
-        case WL_CONNECT_FAILED: Serial.println("(CONNECT_FAILED)"); break;
-        case WL_CONNECTION_LOST: Serial.println("(CONNECTION_LOST)"); break;
-        case WL_DISCONNECTED: Serial.println("(DISCONNECTED)"); break;
-        default: Serial.println("(UNKNOWN)"); break;
-    }
-
-    if (wifiStatus != WL_CONNECTED) {
-        Serial.println("WiFi not connected! Skipping further tests.");
-        Serial.println("=========================================\n");
-        return;
+        Serial.println("Lichess Stream Status: NOT STREAMING");
     }
+}
 
-    // 2. Check local network info
-    Serial.printf("2. Local IP: %s\n", WiFi.localIP().toString().c_str());
-    Serial.printf("   Gateway: %s\n", WiFi.gatewayIP().toString().c_str());
-    Serial.printf("   DNS: %s\n", WiFi.dnsIP().toString().c_str());
-    Serial.printf("   Signal: %d dBm\n", WiFi.RSSI());
+uint32_t LichessAPI::queueCreateGame(int level, int timeLimit, int increment, const String& color) {
+    // The new game replaces the old one - a premove still waiting there would hold it back for good
+    endGame("", "New game");
 
-    // 3. Test DNS resolution for lichess.org
-    Serial.print("3. DNS Lookup (lichess.org): ");
-    IPAddress lichessIP;
-    if (WiFi.hostByName("lichess.org", lichessIP)) {
-        Serial.printf("SUCCESS -> %s\n", lichessIP.toString().c_str());
-    } else {
-        Serial.println("FAILED - Cannot resolve lichess.org");
-        Serial.println("=========================================\n");
-        return;
+    QueuedRequest req{};
+    req.type = CMD_CREATE_GAME;
+    req.level = level;
+    req.timeLimit = timeLimit;
+    req.increment = increment;
+    req.color = color;
+    return enqueueCommand(req);
+}
+
+uint32_t LichessAPI::queueMove(const String& gameId, const String& uciMove, unsigned long receivedAt) {
+    QueuedRequest req{};
+    req.type = CMD_MAKE_MOVE;
+    req.gameId = gameId;
+    req.move = uciMove;
+    req.receivedAt = receivedAt > 0 ? receivedAt : millis();
+    return enqueueCommand(req);
+}
+
+uint32_t LichessAPI::queueResign(const String& gameId) {
+    // Nothing queued for the game can be played once it is resigned - this also
+    // keeps a premove waiting for the opponent from holding the resign back
+    cancelGameCommands(gameId, "Game resigned");
+
+    QueuedRequest req{};
+    req.type = CMD_RESIGN;
+    req.gameId = gameId;
+    return enqueueCommand(req);
+}
+
+uint32_t LichessAPI::queueDrawOffer(const String& gameId, bool accept) {
+    QueuedRequest req{};
+    req.type = CMD_DRAW;
+    req.gameId = gameId;
+    req.accept = accept;
+    return enqueueCommand(req);
+}
+
+void LichessAPI::endGame(const String& gameId, const char* reason) {
+    cancelGameCommands(gameId, reason);
+    // Nothing queued after this waits for the opponent - a late move goes out and fails
+    _playerToMove = true;
+}
+
+void LichessAPI::cancelGameCommands(const String& gameId, const char* reason) {
+    lockCommands();
+    for (auto it = _requestQueue.begin(); it != _requestQueue.end();) {
+        if ((it->type == CMD_MAKE_MOVE || it->type == CMD_DRAW) && (gameId.length() == 0 || it->gameId == gameId)) {
+            reportCommand(*it, CMD_CANCELLED, reason);
+            it = _requestQueue.erase(it);
+        } else {
+            ++it;
+        }
     }
+    unlockCommands();
+}
 
-    // 4. Test DNS resolution for Google
-    Serial.print("4. DNS Lookup (google.com): ");
-    IPAddress googleIP;
-    if (WiFi.hostByName("google.com", googleIP)) {
-        Serial.printf("SUCCESS -> %s\n", googleIP.toString().c_str());
-    } else {
-        Serial.println("FAILED - Cannot resolve google.com");
+void LichessAPI::lockCommands() const {
+    xSemaphoreTake(_commandLock, portMAX_DELAY);
+}
+
+void LichessAPI::unlockCommands() const {
+    xSemaphoreGive(_commandLock);
+}
+
+uint32_t LichessAPI::enqueueCommand(QueuedRequest& command) {
+    lockCommands();
+
+    // A double click or a browser retry gets the command already on its way
+    const QueuedRequest* duplicate = findDuplicateCommand(command);
+    if (duplicate) {
+        uint32_t id = duplicate->id;
+        unlockCommands();
+        Serial.printf("Duplicate %s command - already queued as #%lu\n",
+                      commandTypeName(command.type), (unsigned long)id);
+        return id;
     }
 
-    // 5. Test HTTP connection to Lichess
-    Serial.print("5. HTTP Connect Test (lichess.org:443): ");
-    WiFiClientSecure testClient;
-    testClient.setInsecure();
-    if (testClient.connect("lichess.org", 443)) {
-        Serial.println("SUCCESS - Can connect to Lichess");
-        testClient.stop();
-    } else {
-        Serial.println("FAILED - Cannot connect to Lichess");
+    int queueSize = _requestQueue.size();
+    if (queueSize >= (int)MAX_QUEUED_COMMANDS) {
+        unlockCommands();
+        // Not a connection failure, and _lastError belongs to loop() - the caller reports it from the 0
+        Serial.printf("Command queue full (%d queued) - %s rejected\n",
+                      queueSize, commandTypeName(command.type));
+        return 0;
     }
 
-    Serial.println("=========================================\n");
+    command.id = _nextCommandId++;
+    if (_nextCommandId == 0) {
+        _nextCommandId = 1;  // 0 means "not queued"
+    }
+    _requestQueue.push_back(command);
+    reportCommand(command, CMD_QUEUED, "");
+    queueSize = _requestQueue.size();
+    unlockCommands();
+
+    Serial.printf("Queued %s command #%lu (queue size: %d)\n",
+                  commandTypeName(command.type), (unsigned long)command.id, queueSize);
+    return command.id;
 }
 
-bool LichessAPI::queueCreateGame(int level, int timeLimit, int increment, const String& color) {
-    QueuedRequest req;
-    req.type = QueuedRequest::CREATE_GAME;
-    req.level = level;
-    req.timeLimit = timeLimit;
-    req.increment = increment;
-    req.color = color;
+int LichessAPI::getQueueSize() const {
+    lockCommands();
+    int queueSize = _requestQueue.size();
+    unlockCommands();
+    return queueSize;
+}
 
-    _requestQueue.push_back(req);
-    Serial.printf("Queued game creation request (queue size: %d)\n", _requestQueue.size());
-    return true;
+const LichessAPI::QueuedRequest* LichessAPI::findDuplicateCommand(const QueuedRequest& command) const {
+    auto same = [&command](const QueuedRequest& other) {
+        if (other.id == 0 || other.type != command.type) {
+            return false;
+        }
+        switch (command.type) {
+            case CMD_MAKE_MOVE:   return other.gameId == command.gameId && other.move == command.move;
+            case CMD_DRAW:        return other.gameId == command.gameId && other.accept == command.accept;
+            case CMD_RESIGN:      return other.gameId == command.gameId;
+            case CMD_CREATE_GAME: return true;  // One new game at a time
+        }
+        return false;
+    };
+
+    // Only the newest command counts: g1f3, f3g1, g1f3 is three moves
+    const QueuedRequest& newest = _requestQueue.empty() ? _activeCommand : _requestQueue.back();
+    return same(newest) ? &newest : nullptr;
+}
+
+bool LichessAPI::hasQueuedMove() const {
+    bool queuedMove = false;
+    lockCommands();
+    if (_activeCommand.id != 0 && _activeCommand.type == CMD_MAKE_MOVE) {
+        queuedMove = true;
+    }
+    for (const auto& queued : _requestQueue) {
+        if (queued.type == CMD_MAKE_MOVE) {
+            queuedMove = true;
+        }
+    }
+    unlockCommands();
+    return queuedMove;
 }
 
 void LichessAPI::processQueue() {
-    // Only process queue if we're idle and not streaming
-    if (_state != STATE_IDLE || _requestQueue.empty()) {
+    // Only process queue if we're idle
+    if (_state != STATE_IDLE) {
         return;
     }
 
-    // If streaming is active, stop it before processing queue
-    // (especially for CREATE_GAME requests which need exclusive SSL access)
-    if (_streaming) {
-        Serial.println("Stopping active stream to process queued request");
-        stopStream();
-        // Wait a moment for cleanup
-        delay(100);
+    // Taken off the queue under the lock; the command itself runs without it
+    lockCommands();
+    // A premove waits for the opponent's reply to arrive on the stream
+    if (_requestQueue.empty() || (_requestQueue.front().type == CMD_MAKE_MOVE && !_playerToMove)) {
+        unlockCommands();
+        return;
     }
 
     // Get next request from queue
     QueuedRequest req = _requestQueue.front();
     _requestQueue.erase(_requestQueue.begin());
+    int remaining = _requestQueue.size();
+    unlockCommands();
 
-    Serial.printf("Processing queued request (type: %d, remaining: %d)\n", req.type, _requestQueue.size());
+    // A new game needs exclusive SSL access - stop the old game's stream first
+    if (req.type == CMD_CREATE_GAME && _streaming) {
+        Serial.println("Stopping active stream to process queued request");
+        stopStream();
+    }
 
-    // Process the request
+    Serial.printf("Processing queued %s command #%lu (remaining: %d)\n",
+                  commandTypeName(req.type), (unsigned long)req.id, remaining);
+
+    // Process the request - errors from earlier commands must not be reported as this one's
+    _operationSuccess = false;
+    _lastError = "";
+    bool started = false;
     switch (req.type) {
-        case QueuedRequest::CREATE_GAME:
+        case CMD_CREATE_GAME:
             createAIGame(req.level, req.timeLimit, req.increment, req.color.c_str());
+            started = _state != STATE_IDLE;
+            break;
+        case CMD_MAKE_MOVE:
+            started = makeMove(req.gameId, req.move);
+            if (started) {
+                beginMoveTrace(req);
+            }
             break;
-        case QueuedRequest::MAKE_MOVE:
-            makeMove(req.gameId, req.move);
+        case CMD_RESIGN:
+            started = resignGame(req.gameId);
             break;
-        case QueuedRequest::RESIGN_GAME:
-            resignGame(req.gameId);
+        case CMD_DRAW:
+            started = offerDraw(req.gameId, req.accept);
             break;
     }
+
+    lockCommands();
+    if (!started) {
+        reportCommand(req, CMD_FAILED, _lastError);
+    } else {
+        _activeCommand = req;
+        reportCommand(req, CMD_RUNNING, "");
+    }
+    unlockCommands();
+}
+
+// The running command's operation is back to IDLE - report how it went
+void LichessAPI::finishCommand(bool success) {
+    lockCommands();
+    if (_activeCommand.id == 0) {
+        unlockCommands();
+        return;
+    }
+    bool moveFailed = _activeCommand.type == CMD_MAKE_MOVE && !success;
+
+    if (success) {
+        reportCommand(_activeCommand, CMD_DONE, _activeCommand.type == CMD_CREATE_GAME ? _createdGameId : String(""));
+    } else {
+        reportCommand(_activeCommand, CMD_FAILED, _lastError);
+    }
+    _activeCommand.id = 0;
+    unlockCommands();
+
+    // A move that never reached Lichess has no echo to wait for. One accepted
+    // whose stream failed to reopen may still be echoed once the watchdog or
+    // the next move brings the stream back.
+    if (moveFailed && _moveTrace.accepted == 0) {
+        dropMoveTrace(false);
+    }
+}
+
+// _commandLock held
+void LichessAPI::reportCommand(const QueuedRequest& command, CommandStatus status, const String& detail) {
+    // Nobody draining the updates - keep the newest
+    if (_commandUpdates.size() >= MAX_COMMAND_UPDATES) {
+        _commandUpdates.erase(_commandUpdates.begin());
+    }
+
+    CommandUpdate update;
+    update.id = command.id;
+    update.type = command.type;
+    update.status = status;
+    if (detail.length() > 0) {
+        update.detail = detail;
+    } else {
+        update.detail = command.type == CMD_MAKE_MOVE ? command.move : command.gameId;
+    }
+    _commandUpdates.push_back(update);
+}
+
+bool LichessAPI::popCommandUpdate(CommandUpdate& update) {
+    lockCommands();
+    bool popped = !_commandUpdates.empty();
+    if (popped) {
+        update = _commandUpdates.front();
+        _commandUpdates.erase(_commandUpdates.begin());
+    }
+    unlockCommands();
+    return popped;
+}
+
+void LichessAPI::beginMoveTrace(const QueuedRequest& command) {
+    // Commands run one at a time, so an older trace still open never saw its echo
+    if (_moveTrace.isActive()) {
+        dropMoveTrace(_moveTrace.accepted > 0);
+    }
+
+    _moveTrace.clear();
+    _moveTrace.move = command.move;
+    _moveTrace.ply = _streamPly >= 0 ? _streamPly + 1 : -1;
+    _moveTrace.received = command.receivedAt;
+    _moveTrace.started = millis();
+}
+
+void LichessAPI::traceStreamPly(int ply) {
+    _streamPly = ply;
+
+    // Without a known ply, any position after the move went out counts
+    if (!_moveTrace.isActive() || _moveTrace.submitted == 0 || _moveTrace.echoed > 0) {
+        return;
+    }
+    if (_moveTrace.ply >= 0 && ply < _moveTrace.ply) {
+        return;
+    }
+
+    _moveTrace.echoed = millis();
+    if (_moveTrace.isComplete()) {
+        completeMoveTrace();
+    }
+}
+
+void LichessAPI::completeMoveTrace() {
+    _moveMetrics.record(_moveTrace);
+    if (_deviceMoveMetrics) {
+        _deviceMoveMetrics->record(_moveTrace);
+    }
+
+    unsigned long spans[SPAN_COUNT];
+    for (int i = 0; i < SPAN_COUNT; i++) {
+        if (!_moveTrace.getSpan((MoveSpan)i, spans[i])) {
+            spans[i] = 0;
+        }
+    }
+    LOG_PRINTF("[%lu] MOVE TRACE: %s queue %lu, prepare %lu, pool %lu, tls %lu, post %lu, response %lu, "
+               "resume %lu, echo %lu = %lu ms\n", millis(), _moveTrace.move.c_str(), spans[SPAN_QUEUE],
+               spans[SPAN_PREPARE], spans[SPAN_POOL_WAIT], spans[SPAN_TLS_CONNECT], spans[SPAN_POST],
+               spans[SPAN_RESPONSE], spans[SPAN_STREAM_RESUME], spans[SPAN_ECHO], spans[SPAN_TOTAL]);
+    _moveTrace.clear();
+}
+
+// accepted: Lichess took the move but its echo never arrived
+void LichessAPI::dropMoveTrace(bool accepted) {
+    if (accepted) {
+        _moveMetrics.recordLostEcho();
+    } else {
+        _moveMetrics.recordFailure();
+    }
+    if (_deviceMoveMetrics) {
+        if (accepted) {
+            _deviceMoveMetrics->recordLostEcho();
+        } else {
+            _deviceMoveMetrics->recordFailure();
+        }
+    }
+    _moveTrace.clear();
+}
+
+const char* LichessAPI::commandTypeName(CommandType type) {
+    switch (type) {
+        case CMD_CREATE_GAME: return "create";
+        case CMD_MAKE_MOVE:   return "move";
+        case CMD_RESIGN:      return "resign";
+        case CMD_DRAW:        return "draw";
+    }
+    return "unknown";
+}
+
+const char* LichessAPI::commandStatusName(CommandStatus status) {
+    switch (status) {
+        case CMD_QUEUED:    return "queued";
+        case CMD_RUNNING:   return "running";
+        case CMD_DONE:      return "done";
+        case CMD_FAILED:    return "failed";
+        case CMD_CANCELLED: return "cancelled";
+    }
+    return "unknown";
 }
 
 bool LichessAPI::checkOperationTimeout() {
@@ -565,8 +973,12 @@ bool LichessAPI::checkOperationTimeout() {
 }
 
 void LichessAPI::process() {
+    completeStreamOpen();
+    processStreamRecovery();
+
     // Check for operation timeout
     if (checkOperationTimeout()) {
+        finishCommand(false);
         Serial.println("Operation timed out, processing queue...");
         processQueue();
         return;
@@ -574,7 +986,8 @@ void LichessAPI::process() {
 
     // Process async state machine
     if (_state == STATE_IDLE) {
-        // Process next queued request if available
+        // Report the command that just finished, then start the next queued one
+        finishCommand(_operationSuccess);
         processQueue();
         return;
     }
@@ -584,11 +997,9 @@ void LichessAPI::process() {
     switch (_state) {
         case STATE_WAITING_STREAM_STOP:
             if (elapsed >= STREAM_STOP_DELAY) {
-                // Safe to clean up stream connection now
-                _streamHttp.end();
-                _client.stop();
+                // Safe to clean up stream connection now - frees its TLS session for the API call
+                releaseStreamConnection();
                 _streamClient = nullptr;
-                _streamBuffer = "";
                 Serial.println("Stream stopped, waiting for SSL cleanup");
 
                 // Move to SSL cleanup state
@@ -617,11 +1028,20 @@ void LichessAPI::process() {
             break;
 
         case STATE_MAKING_MOVE: {
-            // Make the API call for the move
-            String url = String(API_BOARD_GAME_MOVE) + _pendingGameId + "/move/" + _pendingMove;
-            String response;
+            // First pass queues the move on the pool's worker, later passes wait for it
+            if (!_request) {
+                if (!submitAPICall(String(API_BOARD_GAME_MOVE) + _pendingGameId + "/move/" + _pendingMove, "POST", "")) {
+                    Serial.println("Move failed: " + _lastError);
+                    _state = STATE_IDLE;
+                } else if (_moveTrace.isActive()) {
+                    _moveTrace.submitted = millis();
+                }
+                break;
+            }
 
-            bool success = makeAPICall(url.c_str(), "POST", "", response);
+            String response;
+            bool success;
+            if (!finishAPICall(response, success)) break;
 
             if (!success) {
                 // Move failed, return to idle
@@ -641,17 +1061,33 @@ void LichessAPI::process() {
             }
 
             if (doc["ok"].is<bool>() && doc["ok"].as<bool>()) {
-                LOG_PRINTF("[%lu] MOVE ACCEPTED: %s\n", millis(), _pendingMove.c_str());
+                _operationSuccess = true;
+                _playerToMove = false;  // Opponent's turn until the stream says otherwise
+                _lastMoveLatency = millis() - _moveStartTime;
+                _totalMoveLatency += _lastMoveLatency;
+                _movesTimed++;
+                LOG_PRINTF("[%lu] MOVE ACCEPTED: %s in %lu ms (%s, avg %lu ms)\n", millis(), _pendingMove.c_str(),
+                           _lastMoveLatency, _lastMoveDual ? "dual" : "single", getAverageMoveLatency());
+
+                // With the stream kept open the echo may already be in
+                if (_moveTrace.isActive()) {
+                    _moveTrace.accepted = millis();
+                    if (_moveTrace.isComplete()) {
+                        completeMoveTrace();
+                    }
+                }
 
-                // Resume stream if it was active before
-                if (_wasStreaming) {
+                // The opponent's reply only arrives on the game stream - reopen it if it
+                // was paused for this move or parked while it was our turn
+                if (!_streaming) {
                     _state = STATE_RESUMING_STREAM;
                     _stateStartTime = millis();
-                    LOG_PRINTF("[%lu] Move complete, waiting to resume stream\n", millis());
+                    LOG_PRINTF("[%lu] Move complete, waiting to %s stream\n", millis(), _wasStreaming ? "resume" : "open");
                 } else {
-                    // No stream to resume, done
+                    // Stream was never interrupted, done
                     _state = STATE_IDLE;
-                    LOG_PRINTF("[%lu] Move complete (no stream)\n", millis());
+                    _pendingMove = "";
+                    LOG_PRINTF("[%lu] Move complete (stream open)\n", millis());
                 }
             } else {
                 setError("Move rejected by server");
@@ -661,7 +1097,8 @@ void LichessAPI::process() {
         }
 
         case STATE_RESUMING_STREAM:
-            if (elapsed >= STREAM_RESUME_DELAY) {
+            // Only a paused stream needs the SSL cleanup delay
+            if (elapsed >= (_wasStreaming ? STREAM_RESUME_DELAY : 0)) {
                 LOG_PRINTF("[%lu] Resuming stream for game %s (waiting for opponent move)\n", millis(), _pendingGameId.c_str());
                 if (startStream(_pendingGameId)) {
                     LOG_PRINTF("[%lu] Stream resumed - listening for opponent\n", millis());
@@ -674,12 +1111,17 @@ void LichessAPI::process() {
             break;
 
         case STATE_RESIGNING_GAME: {
-            // Make the API call to resign
-            String url = String(API_BOARD_GAME_MOVE) + _pendingGameId + "/resign";
-            String response;
+            // Queue the resign, then wait for the worker on later passes
+            if (!_request) {
+                Serial.println("Resigning game: " + _pendingGameId);
+                if (submitAPICall(String(API_BOARD_GAME_MOVE) + _pendingGameId + "/resign", "POST", "", false)) {
+                    break;
+                }
+            }
 
-            Serial.println("Resigning game: " + _pendingGameId);
-            bool success = makeAPICall(url.c_str(), "POST", "", response, false);
+            String response;
+            bool success = false;
+            if (_request && !finishAPICall(response, success)) break;
 
             if (success) {
                 Serial.println("Game resigned successfully");
@@ -694,18 +1136,49 @@ void LichessAPI::process() {
             break;
         }
 
-        case STATE_CREATING_GAME: {
-            // Build form data for game creation
-            String body = "level=" + String(_pendingLevel) +
-                          "&clock.limit=" + String(_pendingTimeLimit) +
-                          "&clock.increment=" + String(_pendingIncrement) +
-                          "&color=" + _pendingColor;
+        case STATE_OFFERING_DRAW: {
+            // Queue the draw offer, then wait for the worker on later passes
+            if (!_request) {
+                String url = String(API_BOARD_GAME_MOVE) + _pendingGameId + "/draw/" + (_pendingDrawAccept ? "yes" : "no");
+                if (submitAPICall(url, "POST", "", false)) {
+                    break;
+                }
+            }
 
             String response;
-            Serial.printf("Creating game: level=%d, time=%d, color=%s\n",
-                         _pendingLevel, _pendingTimeLimit, _pendingColor.c_str());
+            bool success = false;
+            if (_request && !finishAPICall(response, success)) break;
+
+            if (success) {
+                Serial.printf("Draw %s sent\n", _pendingDrawAccept ? "offer" : "decline");
+            } else {
+                Serial.println("Draw offer failed: " + _lastError);
+            }
+            _operationSuccess = success;
+            _state = STATE_IDLE;
+            _pendingGameId = "";
+            break;
+        }
 
-            bool success = makeAPICall(API_CHALLENGE_AI, "POST", body, response, false);
+        case STATE_CREATING_GAME: {
+            // Queue the challenge, then wait for the worker on later passes
+            if (!_request) {
+                // Build form data for game creation
+                String body = "level=" + String(_pendingLevel) +
+                              "&clock.limit=" + String(_pendingTimeLimit) +
+                              "&clock.increment=" + String(_pendingIncrement) +
+                              "&color=" + _pendingColor;
+
+                Serial.printf("Creating game: level=%d, time=%d, color=%s\n",
+                             _pendingLevel, _pendingTimeLimit, _pendingColor.c_str());
+                if (submitAPICall(API_CHALLENGE_AI, "POST", body, false)) {
+                    break;
+                }
+            }
+
+            String response;
+            bool success = false;
+            if (_request && !finishAPICall(response, success)) break;
 
             if (!success) {
                 Serial.println("Game creation failed: " + _lastError);
@@ -730,6 +1203,7 @@ void LichessAPI::process() {
             if (doc["id"].is<const char*>()) {
                 _createdGameId = doc["id"].as<String>();
                 _operationSuccess = true;
+                _playerToMove = _pendingColor != "black";  // Until the stream reports the position
                 Serial.println("Game created: " + _createdGameId);
 
                 // Start streaming the new game
@@ -779,11 +1253,27 @@ void LichessAPI::forceReset() {
     }
 
     // Clear operation queue
+    lockCommands();
     int queueSize = _requestQueue.size();
+    for (const auto& queued : _requestQueue) {
+        reportCommand(queued, CMD_CANCELLED, "Reset");
+    }
     _requestQueue.clear();
+    if (_activeCommand.id != 0) {
+        reportCommand(_activeCommand, CMD_CANCELLED, "Reset");
+        _activeCommand.id = 0;
+    }
+    unlockCommands();
     if (queueSize > 0) {
         Serial.printf("Cleared %d queued operations\n", queueSize);
     }
+    _playerToMove = true;
+    if (_moveTrace.isActive()) {
+        dropMoveTrace(_moveTrace.accepted > 0);
+    }
+
+    // Abandon anything still with the worker
+    cancelRequests();
 
     // Reset state machine to IDLE
     _state = STATE_IDLE;
@@ -796,14 +1286,13 @@ void LichessAPI::forceReset() {
     _operationSuccess = false;
     _wasStreaming = false;
 
-    // Close any open connections
-    if (_client.connected()) {
-        _client.stop();
-        Serial.println("Closed SSL client connection");
+    // Close any open connections - a stream paused mid-move may still hold its lease
+    if (_stream) {
+        releaseStreamConnection();
+        Serial.println("Released stream connection");
     }
-    if (_http.connected()) {
-        _http.end();
-        Serial.println("Closed HTTP client connection");
+    if (_pool) {
+        _pool->closeApiConnection();
     }
 
     // Clear error state
@@ -816,6 +1305,19 @@ void LichessAPI::forceReset() {
     Serial.println("=== FORCE RESET COMPLETE ===");
 }
 
+bool LichessAPI::canUseDualConnection() const {
+    if (!_dualConnectionEnabled || !_pool) {
+        return false;
+    }
+
+    // An open API connection costs nothing extra; opening one needs room for another TLS session
+    if (_pool->isApiConnected() || _pool->hasHeapForConnection()) {
+        return true;
+    }
+    Serial.println("Dual connection unavailable - pausing stream for move");
+    return false;
+}
+
 bool LichessAPI::isConnectionHealthy() {
     // Check if we've had too many consecutive failures
     if (_consecutiveFailures >= MAX_CONSECUTIVE_FAILURES) {
@@ -844,33 +1346,22 @@ void LichessAPI::resetConnection() {
     if (_streaming) {
         Serial.println("Stopping stream...");
         stopStream();
-        delay(100);  // Give it time to clean up
     }
 
-    // Force close all connections
-    if (_client.connected()) {
-        Serial.println("Closing stale SSL connection...");
-        _client.stop();
-        delay(100);
-    }
+    // Abandon anything still with the worker
+    cancelRequests();
 
-    if (_http.connected()) {
-        Serial.println("Closing HTTP connection...");
-        _http.end();
-        delay(100);
+    // Force close all connections - the shared API connection is reopened on the next call
+    if (_stream) {
+        Serial.println("Releasing stream connection...");
+        releaseStreamConnection();
     }
 
-    if (_streamHttp.connected()) {
-        Serial.println("Closing stream HTTP connection...");
-        _streamHttp.end();
-        delay(100);
+    if (_pool) {
+        Serial.println("Closing shared API connection...");
+        _pool->closeApiConnection();  // Closed by the worker before its next request
     }
 
-    // Recreate SSL client with fresh configuration
-    Serial.println("Reinitializing SSL client...");
-    _client.setInsecure();
-    _client.setTimeout(15);
-
     // Reset health tracking
     _consecutiveFailures = 0;
     _lastSuccessfulRequest = millis();
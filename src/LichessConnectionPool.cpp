@@ -0,0 +1,751 @@
+#include "LichessConnectionPool.h"
+
+// Rate budget per endpoint class: burst, ms per token, and how many global
+// tokens it leaves for higher priority classes. Moves come first and may
+// use the last global token; account checks stop while 4 are left.
+static const struct {
+    uint8_t burst;
+    unsigned long interval;
+    uint8_t reserve;
+} RATE_BUDGETS[LichessConnectionPool::ENDPOINT_COUNT] = {
+    {3, 3000, 4},    // ENDPOINT_ACCOUNT
+    {2, 10000, 3},   // ENDPOINT_CHALLENGE
+    {6, 250, 0},     // ENDPOINT_BOARD
+    {4, 2000, 2},    // ENDPOINT_STREAM
+};
+
+LichessConnectionPool::LichessConnectionPool()
+    : _apiBusy(false), _apiConnected(false), _closeApiRequested(false), _lastApiUse(0),
+      _requestQueue(nullptr), _workerTask(nullptr), _requestMux(portMUX_INITIALIZER_UNLOCKED), _retryCount(0) {
+    // Configure SSL clients for insecure mode (development), 15 second timeout
+    _apiClient.setInsecure();
+    _apiClient.setTimeout(15);
+
+    // API calls ask for keep-alive so the next call skips the TLS handshake
+    _apiHttp.setReuse(true);
+
+    // Keep Retry-After from a 429 - HTTPClient drops headers it was not asked for
+    static const char* rateLimitHeaders[] = {"Retry-After"};
+    _apiHttp.collectHeaders(rateLimitHeaders, 1);
+
+    for (int i = 0; i < LICHESS_STREAM_CONNECTIONS; i++) {
+        _streams[i].client.setInsecure();
+        _streams[i].client.setTimeout(15);
+        // A stream never hands its connection back, so it always closes
+        _streams[i].http.setReuse(false);
+        _streams[i].http.collectHeaders(rateLimitHeaders, 1);
+        _streams[i].owner = nullptr;
+    }
+
+    for (int i = 0; i < LICHESS_REQUEST_SLOTS; i++) {
+        _requests[i].owner = nullptr;
+        _requests[i].stream = nullptr;
+        _requests[i].status = Request::FREE;
+    }
+
+    for (int i = 0; i < ENDPOINT_COUNT; i++) {
+        _breakers[i].state = BREAKER_CLOSED;
+        _breakers[i].failures = 0;
+        _breakers[i].openedAt = 0;
+        _breakers[i].openTime = BREAKER_OPEN_TIME;
+        _breakers[i].trips = 0;
+        _breakers[i].lastFailureCode = 0;
+        _limiter.setBudget(i, RATE_BUDGETS[i].burst, RATE_BUDGETS[i].interval, RATE_BUDGETS[i].reserve, millis());
+    }
+    _limiter.setGlobalBudget(LICHESS_RATE_BURST, LICHESS_RATE_INTERVAL, millis());
+}
+
+bool LichessConnectionPool::begin() {
+    if (_workerTask) {
+        return true;
+    }
+
+    _requestQueue = xQueueCreate(LICHESS_REQUEST_SLOTS, sizeof(Request*));
+    if (!_requestQueue) {
+        Serial.println("Lichess worker: failed to create request queue");
+        return false;
+    }
+
+    if (xTaskCreatePinnedToCore(workerLoop, "lichess_http", LICHESS_WORKER_STACK, this,
+                                LICHESS_WORKER_PRIORITY, &_workerTask, tskNO_AFFINITY) != pdPASS) {
+        Serial.println("Lichess worker: failed to start task");
+        _workerTask = nullptr;
+        return false;
+    }
+
+    Serial.println("Lichess worker task started");
+    return true;
+}
+
+// Submitting side (loop task, web handlers)
+
+LichessConnectionPool::Request* LichessConnectionPool::claimRequest(const void* owner) {
+    Request* slot = nullptr;
+    portENTER_CRITICAL(&_requestMux);
+    for (int i = 0; i < LICHESS_REQUEST_SLOTS; i++) {
+        Request& request = _requests[i];
+        // Abandoned requests the worker has finished are free too
+        if (request.status == Request::FREE || (request.status == Request::DONE && !request.owner)) {
+            request.status = Request::CLAIMED;
+            request.owner = owner;
+            slot = &request;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&_requestMux);
+
+    if (!slot) {
+        Serial.printf("No free request slot (%d pending)\n", getPendingRequestCount());
+    }
+    return slot;
+}
+
+bool LichessConnectionPool::queueRequest(Request* request) {
+    request->httpCode = 0;
+    request->response = "";
+    request->error = "";
+    request->retryAfter = 0;
+    request->attempts = 0;
+    request->retryAt = 0;
+    request->throttledSince = 0;
+    request->reused = false;
+    request->handshakeTime = 0;
+    request->queuedAt = millis();
+    request->startedAt = 0;
+    request->finishedAt = 0;
+    request->status = Request::QUEUED;
+
+    if (!_requestQueue || xQueueSend(_requestQueue, &request, 0) != pdTRUE) {
+        Serial.println("Lichess worker not running - request dropped");
+        request->owner = nullptr;
+        request->status = Request::FREE;
+        return false;
+    }
+    return true;
+}
+
+LichessConnectionPool::Request* LichessConnectionPool::submitRequest(const void* owner, const String& url, bool post,
+                                                                     const String& body, const String& token, bool retry) {
+    Request* request = claimRequest(owner);
+    if (!request) {
+        return nullptr;
+    }
+
+    request->stream = nullptr;
+    request->url = url;
+    request->body = body;
+    request->token = token;
+    request->post = post;
+    request->retry = retry;
+    request->endpoint = classifyEndpoint(url, false);
+    return queueRequest(request) ? request : nullptr;
+}
+
+LichessConnectionPool::Request* LichessConnectionPool::submitStreamOpen(const void* owner, StreamConnection* stream,
+                                                                        const String& url, const String& token) {
+    Request* request = claimRequest(owner);
+    if (!request) {
+        return nullptr;
+    }
+
+    request->stream = stream;
+    request->url = url;
+    request->body = "";
+    request->token = token;
+    request->post = false;
+    request->retry = false;
+    request->endpoint = ENDPOINT_STREAM;
+    return queueRequest(request) ? request : nullptr;
+}
+
+bool LichessConnectionPool::finishRequest(Request* request) {
+    if (!request) return false;
+
+    // Once DONE the slot stays ours until it is freed below - release the
+    // body now, before another task can claim the slot and reuse it
+    if (isDone(request)) {
+        request->response = "";
+    }
+
+    bool done;
+    portENTER_CRITICAL(&_requestMux);
+    done = request->status == Request::DONE;
+    request->owner = nullptr;
+    if (done) {
+        request->status = Request::FREE;
+    } else if (request->stream) {
+        // The worker still has the connection - ours until it closes it
+        request->stream->owner = this;
+    }
+    portEXIT_CRITICAL(&_requestMux);
+    return done;
+}
+
+int LichessConnectionPool::getPendingRequestCount() const {
+    int count = 0;
+    portENTER_CRITICAL(&_requestMux);
+    for (int i = 0; i < LICHESS_REQUEST_SLOTS; i++) {
+        if (_requests[i].status == Request::QUEUED || _requests[i].status == Request::RUNNING) count++;
+    }
+    portEXIT_CRITICAL(&_requestMux);
+    return count;
+}
+
+LichessConnectionPool::StreamConnection* LichessConnectionPool::acquireStream(const void* owner) {
+    StreamConnection* leased = nullptr;
+    StreamConnection* slot = nullptr;
+    portENTER_CRITICAL(&_requestMux);
+    for (int i = 0; i < LICHESS_STREAM_CONNECTIONS; i++) {
+        if (_streams[i].owner == owner) {
+            leased = &_streams[i];
+            break;
+        }
+        if (!slot && !_streams[i].owner) {
+            slot = &_streams[i];
+        }
+    }
+    // Owners are matched by address, and a session slot's LichessAPI is rebuilt
+    // in place for the slot's next session - so a connection is never handed
+    // back while an open is still in flight on it, whoever it belongs to
+    bool opening = leased && isStreamOpening(leased);
+    if (!leased && slot) {
+        slot->owner = owner;  // Claimed before the heap check so no other task takes it meanwhile
+    }
+    portEXIT_CRITICAL(&_requestMux);
+
+    if (opening) {
+        Serial.println("Stream connection still opening - not leased again");
+        return nullptr;
+    }
+    if (leased) {
+        return leased;
+    }
+    if (!slot) {
+        Serial.printf("No free stream connection (%d in use)\n", LICHESS_STREAM_CONNECTIONS);
+        return nullptr;
+    }
+    if (!hasHeapForConnection()) {
+        portENTER_CRITICAL(&_requestMux);
+        slot->owner = nullptr;
+        portEXIT_CRITICAL(&_requestMux);
+        return nullptr;
+    }
+
+    slot->framer.reset();
+    Serial.printf("Stream connection leased (%d free)\n", getFreeStreamCount());
+    return slot;
+}
+
+// _requestMux held
+bool LichessConnectionPool::isStreamOpening(const StreamConnection* connection) const {
+    for (int i = 0; i < LICHESS_REQUEST_SLOTS; i++) {
+        const Request& request = _requests[i];
+        if (request.stream == connection && request.status != Request::FREE && request.status != Request::DONE) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void LichessConnectionPool::releaseStream(StreamConnection* connection) {
+    if (!connection) return;
+
+    connection->http.end();
+    connection->client.stop();  // The server is still mid-response, so the connection cannot be reused
+    portENTER_CRITICAL(&_requestMux);
+    connection->owner = nullptr;
+    portEXIT_CRITICAL(&_requestMux);
+    Serial.printf("Stream connection released (%d free)\n", getFreeStreamCount());
+}
+
+int LichessConnectionPool::getFreeStreamCount() const {
+    int count = 0;
+    portENTER_CRITICAL(&_requestMux);
+    for (int i = 0; i < LICHESS_STREAM_CONNECTIONS; i++) {
+        if (!_streams[i].owner) count++;
+    }
+    portEXIT_CRITICAL(&_requestMux);
+    return count;
+}
+
+LichessConnectionPool::BreakerStatus LichessConnectionPool::getBreakerStatus(Endpoint endpoint) const {
+    BreakerStatus status;
+    portENTER_CRITICAL(&_requestMux);
+    const CircuitBreaker& breaker = _breakers[endpoint];
+    status.state = breaker.state;
+    status.failures = breaker.failures;
+    status.trips = breaker.trips;
+    status.lastFailureCode = breaker.lastFailureCode;
+    unsigned long openFor = millis() - breaker.openedAt;
+    status.retryIn = (breaker.state == BREAKER_OPEN && openFor < breaker.openTime) ? breaker.openTime - openFor : 0;
+    portEXIT_CRITICAL(&_requestMux);
+    return status;
+}
+
+LichessConnectionPool::Endpoint LichessConnectionPool::classifyEndpoint(const String& url, bool stream) {
+    if (stream) return ENDPOINT_STREAM;
+    if (url.indexOf("/api/challenge/") >= 0) return ENDPOINT_CHALLENGE;
+    if (url.indexOf("/api/board/") >= 0) return ENDPOINT_BOARD;
+    return ENDPOINT_ACCOUNT;
+}
+
+LichessConnectionPool::RateStatus LichessConnectionPool::getRateStatus(Endpoint endpoint) const {
+    RateStatus status;
+    portENTER_CRITICAL(&_requestMux);
+    status.tokens = _limiter.getTokens(endpoint, millis());
+    status.globalTokens = _limiter.getGlobalTokens(millis());
+    status.counters = _limiter.getCounters(endpoint);
+    portEXIT_CRITICAL(&_requestMux);
+    return status;
+}
+
+// Order in which waiting requests get tokens - same order as the rate budgets' reserves
+uint8_t LichessConnectionPool::endpointPriority(Endpoint endpoint) {
+    return RATE_BUDGETS[endpoint].reserve;
+}
+
+const char* LichessConnectionPool::endpointName(Endpoint endpoint) {
+    switch (endpoint) {
+        case ENDPOINT_ACCOUNT: return "account";
+        case ENDPOINT_CHALLENGE: return "challenge";
+        case ENDPOINT_BOARD: return "board";
+        case ENDPOINT_STREAM: return "stream";
+        default: return "unknown";
+    }
+}
+
+const char* LichessConnectionPool::breakerStateName(BreakerState state) {
+    switch (state) {
+        case BREAKER_CLOSED: return "closed";
+        case BREAKER_OPEN: return "open";
+        case BREAKER_HALF_OPEN: return "half-open";
+        default: return "unknown";
+    }
+}
+
+unsigned long LichessConnectionPool::jitter(unsigned long delay) {
+    return delay / 2 + random(delay / 2 + 1);
+}
+
+bool LichessConnectionPool::hasHeapForConnection() const {
+    uint32_t freeHeap = ESP.getFreeHeap();
+    uint32_t largestBlock = ESP.getMaxAllocHeap();
+    if (freeHeap < TLS_MIN_FREE_HEAP || largestBlock < TLS_MIN_BLOCK) {
+        Serial.printf("Not enough heap for another TLS connection (free %lu, largest block %lu)\n",
+                      (unsigned long)freeHeap, (unsigned long)largestBlock);
+        return false;
+    }
+    return true;
+}
+
+// Worker task side - the only code that blocks on the network
+
+void LichessConnectionPool::workerLoop(void* param) {
+    LichessConnectionPool* pool = static_cast<LichessConnectionPool*>(param);
+    Request* request;
+
+    while (true) {
+        // Sleep until a request arrives or a scheduled retry falls due
+        if (xQueueReceive(pool->_requestQueue, &request, pool->nextWorkerWait()) == pdTRUE) {
+            pool->runRequest(request);
+        }
+        pool->runDueRetries();
+        pool->closeIdleApiConnection();
+    }
+}
+
+TickType_t LichessConnectionPool::nextWorkerWait() const {
+    unsigned long wait = WORKER_IDLE_POLL;
+    unsigned long now = millis();
+    for (int i = 0; i < _retryCount; i++) {
+        long due = (long)(_retrying[i]->retryAt - now);
+        if (due <= 0) {
+            return 0;
+        }
+        if ((unsigned long)due < wait) {
+            wait = due;
+        }
+    }
+    return pdMS_TO_TICKS(wait);
+}
+
+// Run every waiting request that is due, highest priority first so a move
+// gets the next rate limit token before an account check that waited longer
+void LichessConnectionPool::runDueRetries() {
+    while (true) {
+        int next = -1;
+        unsigned long now = millis();
+        for (int i = 0; i < _retryCount; i++) {
+            Request* request = _retrying[i];
+            if ((long)(now - request->retryAt) < 0) {
+                continue;
+            }
+            if (next < 0) {
+                next = i;
+                continue;
+            }
+            // Oldest first within a priority
+            uint8_t priority = endpointPriority(request->endpoint);
+            uint8_t nextPriority = endpointPriority(_retrying[next]->endpoint);
+            if (priority < nextPriority ||
+                (priority == nextPriority && (long)(request->queuedAt - _retrying[next]->queuedAt) < 0)) {
+                next = i;
+            }
+        }
+        if (next < 0) {
+            return;
+        }
+
+        Request* request = _retrying[next];
+        _retrying[next] = _retrying[--_retryCount];
+        runRequest(request);  // May schedule itself again, never due at once
+    }
+}
+
+void LichessConnectionPool::runRequest(Request* request) {
+    // Still RUNNING when it comes back for a retry
+    if (request->status != Request::RUNNING) {
+        request->status = Request::RUNNING;
+        request->startedAt = millis();
+    }
+
+    // Nobody is waiting for a request abandoned while queued - skip the network entirely
+    if (!request->owner) {
+        request->error = "Request cancelled";
+    } else if (!allowAttempt(request)) {
+        request->httpCode = HTTP_CIRCUIT_OPEN;
+        request->retryAfter = getBreakerStatus(request->endpoint).retryIn;
+        request->error = String("Lichess ") + endpointName(request->endpoint) + " requests paused for " +
+                         String((request->retryAfter + 999) / 1000) + "s after repeated failures";
+    } else if (!takeRateToken(request)) {
+        _retrying[_retryCount++] = request;  // Each slot is in here at most once
+        return;
+    } else if (request->stream) {
+        runStreamOpen(request);
+    } else if (!runApiRequest(request)) {
+        _retrying[_retryCount++] = request;
+        return;
+    }
+    request->finishedAt = millis();
+
+    // Publish the results; whoever abandoned an opened stream can no longer close it
+    StreamConnection* orphanedStream = nullptr;
+    portENTER_CRITICAL(&_requestMux);
+    if (!request->owner && request->stream) {
+        orphanedStream = request->stream;
+    }
+    request->status.store(Request::DONE, std::memory_order_release);
+    portEXIT_CRITICAL(&_requestMux);
+
+    if (orphanedStream) {
+        Serial.println("Stream open abandoned - closing connection");
+        releaseStream(orphanedStream);
+    }
+}
+
+// Open a TLS connection to lichess.org unless the client still holds one,
+// recording how long a full handshake takes
+bool LichessConnectionPool::connectClient(WiFiClientSecure& client, Request* request) {
+    if (client.connected()) {
+        request->reused = true;
+        return true;
+    }
+
+    request->reused = false;
+    unsigned long start = millis();
+    if (!client.connect(LICHESS_HOST, LICHESS_SERVER_PORT)) {
+        return false;
+    }
+    request->handshakeTime = millis() - start;
+    return true;
+}
+
+// One attempt at an API request. Returns false if it failed in a way worth
+// retrying - runRequest() then schedules it for request->retryAt instead of
+// the worker waiting here.
+bool LichessConnectionPool::runApiRequest(Request* request) {
+    if (_closeApiRequested) {
+        _apiClient.stop();
+        _closeApiRequested = false;
+    }
+    _apiBusy = true;
+    request->attempts++;
+
+    Serial.printf("API Call: %s %s\n", request->post ? "POST" : "GET", request->url.c_str());
+
+    int httpCode = sendApiRequest(request);
+
+    // A kept-alive connection the server already closed - reconnect straight away
+    if (httpCode < 100 && request->reused) {
+        Serial.println("Kept-alive connection was stale, reconnecting...");
+        httpCode = sendApiRequest(request);
+    }
+
+    request->httpCode = httpCode;
+    _apiConnected = _apiClient.connected();
+    _lastApiUse = millis();
+    _apiBusy = false;
+    recordOutcome(request);
+
+    // httpCode < 0: SSL/connection failure, 1-99: invalid status indicating connection issues.
+    // Retried only while the breaker stays closed - once it opens, the rest fail fast.
+    if (httpCode < 100) {
+        int maxAttempts = request->retry ? MAX_ATTEMPTS : 1;
+        if (request->attempts < maxAttempts && getBreakerStatus(request->endpoint).state == BREAKER_CLOSED) {
+            unsigned long retryDelay = jitter(RETRY_INITIAL_DELAY << (request->attempts - 1));
+            request->retryAt = millis() + retryDelay;
+            Serial.printf("HTTP request failed (code: %d, attempt %d/%d), retrying in %lums...\n",
+                          httpCode, request->attempts, maxAttempts, retryDelay);
+            return false;
+        }
+        runNetworkDiagnostics();
+    }
+    return true;
+}
+
+// Send once on the shared API connection, filling in the response or error
+int LichessConnectionPool::sendApiRequest(Request* request) {
+    // Connect (or reuse the kept-alive connection), then begin - HTTPClient
+    // sends on an already connected client without a new handshake
+    if (!connectClient(_apiClient, request) || !_apiHttp.begin(_apiClient, request->url)) {
+        request->error = "Failed to connect to Lichess";
+        return HTTPC_ERROR_CONNECTION_REFUSED;
+    }
+
+    _apiHttp.addHeader("Authorization", "Bearer " + request->token);
+    if (request->body.length() > 0) {
+        _apiHttp.addHeader("Content-Type", "application/x-www-form-urlencoded");
+    }
+    _apiHttp.setTimeout(REQUEST_TIMEOUT);
+
+    int httpCode = request->post ? _apiHttp.POST(request->body) : _apiHttp.GET();
+
+    if (httpCode < 0 || (httpCode > 0 && httpCode < 100)) {
+        _apiHttp.end();
+        _apiClient.stop();
+        if (httpCode < 0) {
+            request->error = "HTTP request failed: " + _apiHttp.errorToString(httpCode);
+        } else {
+            request->error = "HTTP connection error: " + String(httpCode) + " (invalid status code)";
+        }
+        return httpCode;
+    }
+
+    if (httpCode == HTTP_CODE_TOO_MANY_REQUESTS) {
+        request->retryAfter = parseRetryAfter(_apiHttp.header("Retry-After"));
+    }
+
+    // Got a response - end() leaves the connection open if the server agreed to keep-alive
+    request->error = "";
+    request->response = _apiHttp.getString();
+    _apiHttp.end();
+    return httpCode;
+}
+
+void LichessConnectionPool::runStreamOpen(Request* request) {
+    StreamConnection* stream = request->stream;
+
+    request->attempts++;
+    if (!connectClient(stream->client, request)) {
+        request->httpCode = HTTPC_ERROR_CONNECTION_REFUSED;
+        request->error = "Stream connection failed: TLS connect";
+        recordOutcome(request);
+        return;
+    }
+
+    stream->http.begin(stream->client, request->url);
+    stream->http.addHeader("Authorization", "Bearer " + request->token);
+    stream->http.addHeader("Accept", "application/x-ndjson");
+    stream->http.setTimeout(STREAM_OPEN_TIMEOUT);
+
+    // Returns once the response headers are in - the body is the event stream
+    request->httpCode = stream->http.GET();
+    Serial.printf("Stream connection response: %d\n", request->httpCode);
+    if (request->httpCode == HTTP_CODE_TOO_MANY_REQUESTS) {
+        request->retryAfter = parseRetryAfter(stream->http.header("Retry-After"));
+    }
+    if (request->httpCode != HTTP_CODE_OK) {
+        request->error = "Stream connection failed: " + String(request->httpCode);
+    }
+    recordOutcome(request);
+}
+
+// Whether an attempt may go out. Once an open breaker's time is up it goes
+// half-open and lets this one request through as the trial.
+bool LichessConnectionPool::allowAttempt(Request* request) {
+    bool allowed = true;
+    bool trial = false;
+    portENTER_CRITICAL(&_requestMux);
+    CircuitBreaker& breaker = _breakers[request->endpoint];
+    if (breaker.state == BREAKER_OPEN) {
+        if (millis() - breaker.openedAt >= breaker.openTime) {
+            breaker.state = BREAKER_HALF_OPEN;
+            trial = true;
+        } else {
+            allowed = false;
+        }
+    }
+    portEXIT_CRITICAL(&_requestMux);
+
+    if (trial) {
+        Serial.printf("Circuit breaker %s half-open - sending trial request\n", endpointName(request->endpoint));
+    }
+    return allowed;
+}
+
+// Take a rate limit token, or set retryAt to when one will be due
+bool LichessConnectionPool::takeRateToken(Request* request) {
+    unsigned long now = millis();
+    unsigned long wait;
+    portENTER_CRITICAL(&_requestMux);
+    wait = _limiter.acquire(request->endpoint, now);
+    if (wait == 0 && request->throttledSince) {
+        _limiter.recordDelay(request->endpoint, now - request->throttledSince);
+    }
+    portEXIT_CRITICAL(&_requestMux);
+
+    if (wait == 0) {
+        request->throttledSince = 0;
+        return true;
+    }
+    if (!request->throttledSince) {
+        request->throttledSince = now ? now : 1;
+        Serial.printf("Rate limit: %s request waits %lu ms\n", endpointName(request->endpoint), wait);
+    }
+    request->retryAt = now + wait;
+    return false;
+}
+
+// Feed an attempt's result to its endpoint's breaker. Connection failures,
+// 5xx and 429 count against it; any other response means Lichess is up.
+void LichessConnectionPool::recordOutcome(Request* request) {
+    int httpCode = request->httpCode;
+    bool failed = httpCode < 100 || httpCode >= 500 || httpCode == HTTP_CODE_TOO_MANY_REQUESTS;
+    BreakerState before;
+    BreakerState after;
+    unsigned long openTime;
+
+    portENTER_CRITICAL(&_requestMux);
+    CircuitBreaker& breaker = _breakers[request->endpoint];
+    before = breaker.state;
+    if (!failed) {
+        breaker.state = BREAKER_CLOSED;
+        breaker.failures = 0;
+        breaker.openTime = BREAKER_OPEN_TIME;
+    } else {
+        if (breaker.failures < 255) breaker.failures++;
+        breaker.lastFailureCode = httpCode;
+
+        bool open = false;
+        if (httpCode == HTTP_CODE_TOO_MANY_REQUESTS) {
+            // Rate limited - hold off exactly as long as Lichess asked
+            breaker.openTime = request->retryAfter;
+            open = true;
+        } else if (breaker.state == BREAKER_HALF_OPEN) {
+            breaker.openTime = min(breaker.openTime * 2, BREAKER_MAX_OPEN_TIME);
+            open = true;
+        } else if (breaker.state == BREAKER_CLOSED && breaker.failures >= BREAKER_THRESHOLD) {
+            open = true;
+        }
+        if (open) {
+            breaker.state = BREAKER_OPEN;
+            breaker.openedAt = millis();
+            breaker.trips++;
+        }
+    }
+    after = breaker.state;
+    openTime = breaker.openTime;
+    portEXIT_CRITICAL(&_requestMux);
+
+    if (after == BREAKER_OPEN && (before != BREAKER_OPEN || httpCode == HTTP_CODE_TOO_MANY_REQUESTS)) {
+        Serial.printf("Circuit breaker %s OPEN for %lu ms (last code %d)\n",
+                      endpointName(request->endpoint), openTime, httpCode);
+    } else if (after == BREAKER_CLOSED && before != BREAKER_CLOSED) {
+        Serial.printf("Circuit breaker %s closed - Lichess reachable again\n", endpointName(request->endpoint));
+    }
+}
+
+// Retry-After in seconds, or RATE_LIMIT_PAUSE if missing - the HTTP-date
+// form is not worth parsing here
+unsigned long LichessConnectionPool::parseRetryAfter(const String& value) {
+    long seconds = value.toInt();
+    if (seconds <= 0) {
+        return RATE_LIMIT_PAUSE;
+    }
+    return min((unsigned long)seconds * 1000UL, BREAKER_MAX_OPEN_TIME);
+}
+
+void LichessConnectionPool::closeIdleApiConnection() {
+    if (_closeApiRequested || (_apiConnected && millis() - _lastApiUse >= API_KEEPALIVE_IDLE)) {
+        if (_apiClient.connected()) {
+            _apiClient.stop();
+            Serial.println(_closeApiRequested ? "Closed shared API connection" : "Closed idle API connection");
+        }
+        _apiConnected = false;
+        _closeApiRequested = false;
+    }
+}
+
+void LichessConnectionPool::runNetworkDiagnostics() {
+    Serial.println("\n========== NETWORK DIAGNOSTICS ==========");
+
+    // 1. Check WiFi status
+    wl_status_t wifiStatus = WiFi.status();
+    Serial.printf("1. WiFi Status: %d ", wifiStatus);
+    switch(wifiStatus) {
+        case WL_CONNECTED: Serial.println("(CONNECTED)"); break;
+        case WL_NO_SHIELD: Serial.println("(NO_SHIELD)"); break;
+        case WL_IDLE_STATUS: Serial.println("(IDLE)"); break;
+        case WL_NO_SSID_AVAIL: Serial.println("(NO_SSID)"); break;
+        case WL_SCAN_COMPLETED: Serial.println("(SCAN_COMPLETED)"); break;
+        case WL_CONNECT_FAILED: Serial.println("(CONNECT_FAILED)"); break;
+        case WL_CONNECTION_LOST: Serial.println("(CONNECTION_LOST)"); break;
+        case WL_DISCONNECTED: Serial.println("(DISCONNECTED)"); break;
+        default: Serial.println("(UNKNOWN)"); break;
+    }
+
+    if (wifiStatus != WL_CONNECTED) {
+        Serial.println("WiFi not connected! Skipping further tests.");
+        Serial.println("=========================================\n");
+        return;
+    }
+
+    // 2. Check local network info
+    Serial.printf("2. Local IP: %s\n", WiFi.localIP().toString().c_str());
+    Serial.printf("   Gateway: %s\n", WiFi.gatewayIP().toString().c_str());
+    Serial.printf("   DNS: %s\n", WiFi.dnsIP().toString().c_str());
+    Serial.printf("   Signal: %d dBm\n", WiFi.RSSI());
+
+    // 3. Test DNS resolution for lichess.org
+    Serial.printf("3. DNS Lookup (%s): ", LICHESS_HOST);
+    IPAddress lichessIP;
+    if (WiFi.hostByName(LICHESS_HOST, lichessIP)) {
+        Serial.printf("SUCCESS -> %s\n", lichessIP.toString().c_str());
+    } else {
+        Serial.printf("FAILED - Cannot resolve %s\n", LICHESS_HOST);
+        Serial.println("=========================================\n");
+        return;
+    }
+
+    // 4. Test DNS resolution for Google
+    Serial.print("4. DNS Lookup (google.com): ");
+    IPAddress googleIP;
+    if (WiFi.hostByName("google.com", googleIP)) {
+        Serial.printf("SUCCESS -> %s\n", googleIP.toString().c_str());
+    } else {
+        Serial.println("FAILED - Cannot resolve google.com");
+    }
+
+    // 5. Test HTTP connection to Lichess
+    Serial.printf("5. HTTP Connect Test (%s:%d): ", LICHESS_HOST, LICHESS_SERVER_PORT);
+    WiFiClientSecure testClient;
+    testClient.setInsecure();
+    if (testClient.connect(LICHESS_HOST, LICHESS_SERVER_PORT)) {
+        Serial.println("SUCCESS - Can connect to Lichess");
+        testClient.stop();
+    } else {
+        Serial.println("FAILED - Cannot connect to Lichess");
+    }
+
+    Serial.println("=========================================\n");
+}
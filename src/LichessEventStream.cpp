@@ -0,0 +1,147 @@
+#include "LichessEventStream.h"
+#include "SDLogger.h"
+
+LichessEventStream::LichessEventStream()
+    : _pool(nullptr), _stream(nullptr), _connectRequest(nullptr), _streamClient(nullptr), _active(false),
+      _nextConnectTime(0), _reconnectDelay(RECONNECT_INITIAL_DELAY), _connectedAt(0) {
+}
+
+LichessEventStream::~LichessEventStream() {
+    disconnect();
+}
+
+void LichessEventStream::begin(LichessConnectionPool* pool, const String& apiToken) {
+    _pool = pool;
+    _apiToken = apiToken;
+}
+
+void LichessEventStream::setActive(bool active) {
+    if (_active == active) return;
+
+    _active = active;
+    if (!active) {
+        disconnect();
+        Serial.println("Account event stream closed (no active games)");
+    } else {
+        _nextConnectTime = millis();
+        _reconnectDelay = RECONNECT_INITIAL_DELAY;
+    }
+}
+
+bool LichessEventStream::connect() {
+    if (!_pool || _apiToken.length() == 0) {
+        return false;
+    }
+
+    // Don't lease a TLS session for an open the breaker would refuse
+    if (_pool->isCircuitOpen(LichessConnectionPool::ENDPOINT_STREAM)) {
+        return false;
+    }
+
+    _stream = _pool->acquireStream(this);
+    if (!_stream) {
+        return false;
+    }
+
+    // The worker connects and waits for the response headers
+    _connectRequest = _pool->submitStreamOpen(this, _stream, API_STREAM_EVENT, _apiToken);
+    if (!_connectRequest) {
+        disconnect();
+        return false;
+    }
+    return true;
+}
+
+bool LichessEventStream::completeConnect() {
+    int httpCode = _connectRequest->httpCode;
+    _pool->finishRequest(_connectRequest);
+    _connectRequest = nullptr;
+
+    if (httpCode != HTTP_CODE_OK) {
+        Serial.printf("Account event stream connection failed: %d\n", httpCode);
+        disconnect();
+        return false;
+    }
+
+    _streamClient = _stream->http.getStreamPtr();
+    _connectedAt = millis();
+    Serial.println("Account event stream connected");
+    return true;
+}
+
+void LichessEventStream::disconnect() {
+    if (_connectRequest) {
+        // An open still in flight is closed by the worker; a finished one is ours to close
+        if (!_pool->finishRequest(_connectRequest)) {
+            _stream = nullptr;
+        }
+        _connectRequest = nullptr;
+    }
+    if (_stream) {
+        _pool->releaseStream(_stream);
+        _stream = nullptr;
+    }
+    _streamClient = nullptr;
+}
+
+void LichessEventStream::scheduleReconnect() {
+    // Jittered so game streams failing at the same moment don't reconnect in
+    // step, and never before the stream breaker will let an open through
+    unsigned long delay = LichessConnectionPool::jitter(_reconnectDelay);
+    delay = max(delay, _pool->getBreakerStatus(LichessConnectionPool::ENDPOINT_STREAM).retryIn);
+    _nextConnectTime = millis() + delay;
+    Serial.printf("Account event stream retry in %lu ms\n", delay);
+    _reconnectDelay = min(_reconnectDelay * 2, RECONNECT_MAX_DELAY);
+}
+
+bool LichessEventStream::processEvents(char*& eventJson, size_t& length) {
+    if (!_active) {
+        return false;
+    }
+
+    if (!_stream) {
+        if ((long)(millis() - _nextConnectTime) < 0) {
+            return false;
+        }
+        if (!connect()) {
+            scheduleReconnect();
+        }
+        return false;
+    }
+
+    if (_connectRequest) {
+        if (!_pool->isDone(_connectRequest)) {
+            return false;
+        }
+        if (!completeConnect()) {
+            scheduleReconnect();
+            return false;
+        }
+        _reconnectDelay = RECONNECT_INITIAL_DELAY;
+    }
+
+    if (!_streamClient) {
+        return false;
+    }
+
+    if (_stream->framer.next(_streamClient, eventJson, length)) {
+        LOG_PRINTF("[%lu] ACCOUNT EVENT: %.100s\n", millis(), eventJson);
+        return true;
+    }
+
+    // Lichess keeps this stream alive with empty lines - missing several in a
+    // row means a half-dead connection that may not report itself for minutes.
+    // On reconnect Lichess sends gameStart again for every game in progress.
+    unsigned long lastActivity = max(_stream->framer.getLastReadTime(), _connectedAt);
+    if (millis() - lastActivity >= LICHESS_STREAM_STALL_TIMEOUT) {
+        Serial.printf("Account event stream stalled (%lu ms silent) - reconnecting\n", millis() - lastActivity);
+        disconnect();
+        scheduleReconnect();
+    } else if (!_streamClient->connected()) {
+        Serial.println("Account event stream lost - reconnecting");
+        disconnect();
+        _nextConnectTime = millis() + LichessConnectionPool::jitter(_reconnectDelay);
+    }
+
+    return false;
+}
@@ -0,0 +1,87 @@
+#include "LichessRateLimiter.h"
+
+LichessRateLimiter::LichessRateLimiter() {
+    configure(_global, 1, 1000, 0);
+    for (int i = 0; i < LICHESS_RATE_MAX_BUDGETS; i++) {
+        configure(_buckets[i], 1, 1000, 0);
+        _reserve[i] = 0;
+        _counters[i] = Counters{0, 0, 0, 0};
+    }
+}
+
+void LichessRateLimiter::setGlobalBudget(uint8_t burst, unsigned long interval, unsigned long now) {
+    configure(_global, burst, interval, now);
+}
+
+void LichessRateLimiter::setBudget(int budget, uint8_t burst, unsigned long interval, uint8_t reserve,
+                                   unsigned long now) {
+    configure(_buckets[budget], burst, interval, now);
+    _reserve[budget] = reserve;
+}
+
+void LichessRateLimiter::configure(Bucket& bucket, uint8_t burst, unsigned long interval, unsigned long now) {
+    bucket.burst = burst > 0 ? burst : 1;
+    bucket.tokens = bucket.burst;  // Start full
+    bucket.interval = interval > 0 ? interval : 1;
+    bucket.lastRefill = now;
+}
+
+void LichessRateLimiter::refill(Bucket& bucket, unsigned long now) {
+    unsigned long earned = (now - bucket.lastRefill) / bucket.interval;
+    if (earned == 0) {
+        return;
+    }
+    if (bucket.tokens + earned >= bucket.burst) {
+        // A full bucket earns nothing - restart the clock so idle time does not bank tokens
+        bucket.tokens = bucket.burst;
+        bucket.lastRefill = now;
+    } else {
+        bucket.tokens += earned;
+        bucket.lastRefill += earned * bucket.interval;
+    }
+}
+
+unsigned long LichessRateLimiter::waitFor(const Bucket& bucket, uint8_t keep, unsigned long now) {
+    if (bucket.tokens > keep) {
+        return 0;
+    }
+    unsigned long needed = keep + 1 - bucket.tokens;
+    unsigned long ready = bucket.lastRefill + needed * bucket.interval;
+    long wait = (long)(ready - now);
+    return wait > 0 ? wait : 1;
+}
+
+unsigned long LichessRateLimiter::acquire(int budget, unsigned long now) {
+    Bucket& bucket = _buckets[budget];
+    refill(bucket, now);
+    refill(_global, now);
+
+    unsigned long wait = max(waitFor(bucket, 0, now), waitFor(_global, _reserve[budget], now));
+    if (wait > 0) {
+        return wait;
+    }
+
+    bucket.tokens--;
+    _global.tokens--;
+    _counters[budget].granted++;
+    return 0;
+}
+
+void LichessRateLimiter::recordDelay(int budget, unsigned long delay) {
+    Counters& counters = _counters[budget];
+    counters.throttled++;
+    counters.totalDelay += delay;
+    if (delay > counters.maxDelay) {
+        counters.maxDelay = delay;
+    }
+}
+
+uint8_t LichessRateLimiter::getTokens(int budget, unsigned long now) {
+    refill(_buckets[budget], now);
+    return _buckets[budget].tokens;
+}
+
+uint8_t LichessRateLimiter::getGlobalTokens(unsigned long now) {
+    refill(_global, now);
+    return _global.tokens;
+}
@@ -1,18 +1,30 @@
 #include "LichessWebHandler.h"
 #include <ArduinoJson.h>
+#include <memory>
+#include "ChessEngine.h"
 #include "SDLogger.h"
 
 // Global instance
 LichessWebHandler* g_lichessWebHandler = nullptr;
 
 LichessWebHandler::LichessWebHandler()
-    : _server(nullptr), _lichessAPI(nullptr), _sessionManager(nullptr), _eventSource(nullptr) {
+    : _server(nullptr), _lichessAPI(nullptr), _sessionManager(nullptr) {
+    for (int slot = 0; slot < MAX_SESSIONS; slot++) {
+        _sessionChannels[slot] = nullptr;
+        _channelSessionIds[slot][0] = '\0';
+        _replay[slot] = nullptr;
+    }
+    _replayLock = xSemaphoreCreateMutex();
     g_lichessWebHandler = this;
 }
 
 LichessWebHandler::~LichessWebHandler() {
-    if (_eventSource) {
-        delete _eventSource;
+    for (int slot = 0; slot < MAX_SESSIONS; slot++) {
+        delete _sessionChannels[slot];
+        delete _replay[slot];
+    }
+    if (_replayLock) {
+        vSemaphoreDelete(_replayLock);
     }
     g_lichessWebHandler = nullptr;
 }
@@ -22,9 +34,20 @@ void LichessWebHandler::begin(AsyncWebServer* server, LichessAPI* api, SessionMa
     _lichessAPI = api;
     _sessionManager = sessionMgr;
 
-    // Setup SSE event source
-    _eventSource = new AsyncEventSource("/api/lichess/stream");
-    _server->addHandler(_eventSource);
+    // Setup SSE event sources - all on one URL, the request's session picks the channel
+    for (int slot = 0; slot < MAX_SESSIONS; slot++) {
+        _sessionChannels[slot] = new AsyncEventSource("/api/lichess/stream");
+        _sessionChannels[slot]->setFilter([this, slot](AsyncWebServerRequest* request) {
+            return getRequestSlot(request) == slot;
+        });
+        _sessionChannels[slot]->onConnect([this, slot](AsyncEventSourceClient* client) {
+            replayEvents(slot, client);
+        });
+        _server->addHandler(_sessionChannels[slot]);
+    }
+
+    // Account event stream shares the sessions' connection pool and token
+    _accountEvents.begin(_sessionManager->getConnectionPool(), _sessionManager->getAPIToken());
 
     // Setup endpoints (now session-aware)
     _server->on("/api/lichess/account", HTTP_GET, [this](AsyncWebServerRequest* request) {
@@ -47,6 +70,10 @@ void LichessWebHandler::begin(AsyncWebServer* server, LichessAPI* api, SessionMa
         this->handleResignGame(request);
     });
 
+    _server->on("/api/lichess/draw", HTTP_POST, [this](AsyncWebServerRequest* request) {
+        this->handleOfferDraw(request);
+    });
+
     _server->on("/api/lichess/status", HTTP_GET, [this](AsyncWebServerRequest* request) {
         this->handleGetGameStatus(request);
     });
@@ -63,6 +90,10 @@ void LichessWebHandler::begin(AsyncWebServer* server, LichessAPI* api, SessionMa
         this->handleGetSessions(request);
     });
 
+    _server->on("/api/lichess/metrics", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        this->handleGetMetrics(request);
+    });
+
     Serial.println("Chess web handlers registered (multi-session mode)");
 }
 
@@ -79,11 +110,18 @@ void LichessWebHandler::handleTestAccount(AsyncWebServerRequest* request) {
         return;
     }
 
+    // The check runs on the pool's worker - answer 202 until a later poll finds it done
     String username;
-    if (_lichessAPI->testAccount(username)) {
-        sendJSONResponse(request, 200, "{\"username\":\"" + username + "\"}", true);
-    } else {
-        sendErrorResponse(request, 401, _lichessAPI->getLastError());
+    switch (_lichessAPI->pollAccountCheck(username)) {
+        case LichessAPI::ACCOUNT_CHECK_PENDING:
+            sendJSONResponse(request, 202, "{\"success\":true,\"status\":\"pending\"}", true);
+            break;
+        case LichessAPI::ACCOUNT_CHECK_OK:
+            sendJSONResponse(request, 200, "{\"username\":\"" + username + "\"}", true);
+            break;
+        case LichessAPI::ACCOUNT_CHECK_FAILED:
+            sendErrorResponse(request, 401, _lichessAPI->getLastError());
+            break;
     }
 }
 
@@ -92,6 +130,7 @@ void LichessWebHandler::handleCreateGame(AsyncWebServerRequest* request) {
         sendErrorResponse(request, 500, "Session manager not initialized");
         return;
     }
+    SessionManager::ReadGuard guard(_sessionManager);
 
     // Get session ID
     String sessionId = getSessionIdFromRequest(request);
@@ -116,7 +155,7 @@ void LichessWebHandler::handleCreateGame(AsyncWebServerRequest* request) {
 
     // Check if session already has active game
     if (session->gameActive) {
-        sendErrorResponse(request, 400, "Session already has active game: " + session->gameId);
+        sendErrorResponse(request, 400, "Session already has active game: " + _sessionManager->getGameId(session));
         return;
     }
 
@@ -133,34 +172,26 @@ void LichessWebHandler::handleCreateGame(AsyncWebServerRequest* request) {
     int increment = request->hasParam("increment", true) ? request->getParam("increment", true)->value().toInt() : 0;
     String color = request->hasParam("color", true) ? request->getParam("color", true)->value() : "white";
 
-    // Queue the request instead of rejecting when busy
-    if (sessionAPI->isBusy()) {
-        Serial.printf("Session %s: API busy - queueing game creation (queue size: %d)\n",
-                      sessionId.c_str(), sessionAPI->getQueueSize());
-        sessionAPI->queueCreateGame(level, timeLimit, increment, color);
-        sendJSONResponse(request, 202, "{\"status\":\"queued\",\"queueSize\":" + String(sessionAPI->getQueueSize()) + "}", true);
-        return;
-    }
-
     Serial.printf("Session %s: Creating game (level=%d, time=%d, color=%s)\n",
                   sessionId.c_str(), level, timeLimit, color.c_str());
 
-    // Store color in session for later reference
-    session->playerColor = color;
-    _sessionManager->updateActivity(sessionId);
-
-    // createAIGame now initiates async process using session-specific API
-    sessionAPI->createAIGame(level, timeLimit, increment, color.c_str());
+    // Store color in session for later reference - the game ID arrives once the game exists
+    _sessionManager->setGameId(sessionId, "", color.c_str());
 
-    // Return immediately - game will be created in background
-    sendJSONResponse(request, 202, "{\"status\":\"creating\"}", true);
+    // Queued behind anything still running - the game is created in the background
+    uint32_t commandId = sessionAPI->queueCreateGame(level, timeLimit, increment, color);
+    sendCommandResponse(request, sessionAPI, commandId, "creating");
 }
 
 void LichessWebHandler::handleMakeMove(AsyncWebServerRequest* request) {
+    // Start of the move's trace - validation below is part of its queue time
+    unsigned long receivedAt = millis();
+
     if (!_sessionManager) {
         sendErrorResponse(request, 500, "Session manager not initialized");
         return;
     }
+    SessionManager::ReadGuard guard(_sessionManager);
 
     // Get session ID
     String sessionId = getSessionIdFromRequest(request);
@@ -188,26 +219,51 @@ void LichessWebHandler::handleMakeMove(AsyncWebServerRequest* request) {
         return;
     }
 
-    // Check if API is busy with another operation
-    if (sessionAPI->isBusy()) {
-        sendErrorResponse(request, 503, "API busy, try again");
-        return;
+    String move = request->getParam("move", true)->value();
+
+    // Checked on a copy - parsing makes and unmakes moves, and loop() keeps the
+    // session's board in step with the game stream meanwhile
+    std::unique_ptr<ChessEngine> board(_sessionManager->copyBoard(session));
+
+    // A move made before the opponent has replied (or behind moves still
+    // queued) is a premove: it can only be checked once its position exists,
+    // so it must already be UCI and Lichess has the final say on legality
+    bool premove = board && (!isPlayersTurn(session, board.get()) || sessionAPI->hasQueuedMove());
+    if (premove) {
+        Move parsed = board->parseMove(move.c_str());
+        if (!parsed.isValid()) {
+            sendErrorResponse(request, 400, "Premoves must be in UCI notation");
+            return;
+        }
+        char uci[CHESS_UCI_MAX];
+        ChessEngine::formatUCI(parsed, uci, sizeof(uci));
+        move = uci;
+    } else if (board) {
+        // Reject illegal moves locally instead of spending a Lichess round trip on them.
+        // SAN is accepted too and converted, since the Board API only takes UCI.
+        Move parsed = board->parseMove(move.c_str());
+        if (!parsed.isValid()) {
+            parsed = board->parseSAN(move.c_str());
+        }
+        Move legal;
+        if (!board->findLegalMove(parsed, legal)) {
+            sendErrorResponse(request, 400, "Illegal move");
+            return;
+        }
+        char uci[CHESS_UCI_MAX];
+        ChessEngine::formatUCI(legal, uci, sizeof(uci));
+        move = uci;
     }
 
-    String move = request->getParam("move", true)->value();
-    Serial.printf("Session %s: Making move %s on game %s\n",
-                  sessionId.c_str(), move.c_str(), session->gameId.c_str());
+    String gameId = _sessionManager->getGameId(session);
+    Serial.printf("Session %s: %s %s on game %s\n", sessionId.c_str(), premove ? "Premove" : "Making move",
+                  move.c_str(), gameId.c_str());
 
     _sessionManager->updateActivity(sessionId);
 
-    // makeMove now returns immediately and processes asynchronously
-    if (sessionAPI->makeMove(session->gameId, move)) {
-        // Move initiated successfully - will complete in background
-        sendJSONResponse(request, 202, "{\"success\":true,\"status\":\"processing\"}", true);
-    } else {
-        // Failed to initiate move
-        sendErrorResponse(request, 400, sessionAPI->getLastError());
-    }
+    // Queued rather than rejected while another command runs; progress is pushed over SSE
+    uint32_t commandId = sessionAPI->queueMove(gameId, move, receivedAt);
+    sendCommandResponse(request, sessionAPI, commandId, "processing");
 }
 
 void LichessWebHandler::handleResignGame(AsyncWebServerRequest* request) {
@@ -215,6 +271,7 @@ void LichessWebHandler::handleResignGame(AsyncWebServerRequest* request) {
         sendErrorResponse(request, 500, "Session manager not initialized");
         return;
     }
+    SessionManager::ReadGuard guard(_sessionManager);
 
     // Get session ID
     String sessionId = getSessionIdFromRequest(request);
@@ -237,23 +294,55 @@ void LichessWebHandler::handleResignGame(AsyncWebServerRequest* request) {
         return;
     }
 
-    // Check if API is busy with another operation
-    if (sessionAPI->isBusy()) {
-        sendErrorResponse(request, 503, "API busy, try again");
+    String gameId = _sessionManager->getGameId(session);
+    Serial.printf("Session %s: Resigning game %s\n", sessionId.c_str(), gameId.c_str());
+
+    _sessionManager->updateActivity(sessionId);
+
+    // Cancels any moves still queued for the game
+    uint32_t commandId = sessionAPI->queueResign(gameId);
+    sendCommandResponse(request, sessionAPI, commandId, "resigning");
+}
+
+void LichessWebHandler::handleOfferDraw(AsyncWebServerRequest* request) {
+    if (!_sessionManager) {
+        sendErrorResponse(request, 500, "Session manager not initialized");
         return;
     }
+    SessionManager::ReadGuard guard(_sessionManager);
 
-    Serial.printf("Session %s: Resigning game %s\n", sessionId.c_str(), session->gameId.c_str());
+    // Get session ID
+    String sessionId = getSessionIdFromRequest(request);
+    if (sessionId.length() == 0) {
+        sendErrorResponse(request, 400, "Missing session ID");
+        return;
+    }
 
-    _sessionManager->updateActivity(sessionId);
+    // Validate session exists
+    Session* session = _sessionManager->getSession(sessionId);
+    if (!session || !session->gameActive) {
+        sendErrorResponse(request, 400, "No active game for this session");
+        return;
+    }
 
-    // resignGame now initiates async process
-    if (sessionAPI->resignGame(session->gameId)) {
-        // Resign initiated - will complete in background
-        sendJSONResponse(request, 202, "{\"success\":true,\"status\":\"resigning\"}", true);
-    } else {
-        sendErrorResponse(request, 400, sessionAPI->getLastError());
+    // Use session-specific API instance
+    LichessAPI* sessionAPI = session->lichessAPI;
+    if (!sessionAPI) {
+        sendErrorResponse(request, 500, "Session API not initialized");
+        return;
     }
+
+    // accept=no declines the opponent's offer; anything else offers or accepts
+    bool accept = !(request->hasParam("accept", true) && request->getParam("accept", true)->value() == "no");
+
+    String gameId = _sessionManager->getGameId(session);
+    Serial.printf("Session %s: Draw %s on game %s\n", sessionId.c_str(), accept ? "offer" : "decline",
+                  gameId.c_str());
+
+    _sessionManager->updateActivity(sessionId);
+
+    uint32_t commandId = sessionAPI->queueDrawOffer(gameId, accept);
+    sendCommandResponse(request, sessionAPI, commandId, "processing");
 }
 
 void LichessWebHandler::handleGetGameStatus(AsyncWebServerRequest* request) {
@@ -261,6 +350,7 @@ void LichessWebHandler::handleGetGameStatus(AsyncWebServerRequest* request) {
         sendErrorResponse(request, 500, "Session manager not initialized");
         return;
     }
+    SessionManager::ReadGuard guard(_sessionManager);
 
     // Get session ID
     String sessionId = getSessionIdFromRequest(request);
@@ -277,11 +367,64 @@ void LichessWebHandler::handleGetGameStatus(AsyncWebServerRequest* request) {
     }
 
     JsonDocument doc;
-    doc["gameActive"] = session->gameActive;
-    doc["gameId"] = session->gameId;
+    doc["gameActive"] = session->gameActive.load();
+    doc["gameId"] = _sessionManager->getGameId(session);
     doc["playerColor"] = session->playerColor;
-    doc["streaming"] = _lichessAPI ? _lichessAPI->isStreaming() : false;
+    doc["streaming"] = session->lichessAPI ? session->lichessAPI->isStreaming() : false;
     doc["sessionId"] = sessionId;
+    if (session->whiteTimeMs >= 0) {
+        doc["wtime"] = session->whiteTimeMs;
+        doc["btime"] = session->blackTimeMs;
+    }
+
+    // Move round-trip latency as measured by this session's API instance
+    if (session->lichessAPI) {
+        JsonObject moveLatency = doc["moveLatency"].to<JsonObject>();
+        moveLatency["lastMs"] = session->lichessAPI->getLastMoveLatency();
+        moveLatency["avgMs"] = session->lichessAPI->getAverageMoveLatency();
+        moveLatency["count"] = session->lichessAPI->getMovesTimed();
+        moveLatency["dualConnection"] = session->lichessAPI->wasLastMoveDual();
+
+        JsonObject tls = doc["tls"].to<JsonObject>();
+        tls["handshakes"] = session->lichessAPI->getHandshakeCount();
+        tls["lastHandshakeMs"] = session->lichessAPI->getLastHandshakeTime();
+        tls["avgHandshakeMs"] = session->lichessAPI->getAverageHandshakeTime();
+        tls["reused"] = session->lichessAPI->getReusedConnectionCount();
+
+        JsonObject stream = doc["stream"].to<JsonObject>();
+        stream["silenceMs"] = session->lichessAPI->getStreamSilence();
+        stream["reconnects"] = session->lichessAPI->getStreamReconnectCount();
+        stream["recovering"] = session->lichessAPI->isStreamRecovering();
+    }
+
+    // Breakers are shared by every session - an open one means Lichess calls
+    // of that class fail at once until retryInMs has passed
+    LichessConnectionPool* pool = _sessionManager->getConnectionPool();
+    JsonObject breakers = doc["breakers"].to<JsonObject>();
+    for (int i = 0; i < LichessConnectionPool::ENDPOINT_COUNT; i++) {
+        LichessConnectionPool::Endpoint endpoint = (LichessConnectionPool::Endpoint)i;
+        LichessConnectionPool::BreakerStatus status = pool->getBreakerStatus(endpoint);
+        JsonObject breaker = breakers[LichessConnectionPool::endpointName(endpoint)].to<JsonObject>();
+        breaker["state"] = LichessConnectionPool::breakerStateName(status.state);
+        breaker["failures"] = status.failures;
+        breaker["retryInMs"] = status.retryIn;
+        breaker["trips"] = status.trips;
+        breaker["lastFailureCode"] = status.lastFailureCode;
+    }
+
+    // Shared rate limit budgets - throttled requests waited for a token before going out
+    JsonObject rateLimit = doc["rateLimit"].to<JsonObject>();
+    for (int i = 0; i < LichessConnectionPool::ENDPOINT_COUNT; i++) {
+        LichessConnectionPool::Endpoint endpoint = (LichessConnectionPool::Endpoint)i;
+        LichessConnectionPool::RateStatus status = pool->getRateStatus(endpoint);
+        rateLimit["globalTokens"] = status.globalTokens;
+        JsonObject budget = rateLimit[LichessConnectionPool::endpointName(endpoint)].to<JsonObject>();
+        budget["tokens"] = status.tokens;
+        budget["granted"] = status.counters.granted;
+        budget["throttled"] = status.counters.throttled;
+        budget["avgDelayMs"] = status.counters.throttled > 0 ? status.counters.totalDelay / status.counters.throttled : 0;
+        budget["maxDelayMs"] = status.counters.maxDelay;
+    }
 
     _sessionManager->updateActivity(sessionId);
 
@@ -292,38 +435,377 @@ void LichessWebHandler::handleGetGameStatus(AsyncWebServerRequest* request) {
 }
 
 void LichessWebHandler::forwardLichessEvents() {
-    if (!_sessionManager || !_eventSource) {
+    if (!_sessionManager) {
         return;
     }
 
+    closeStaleChannels();
+    routeAccountEvents();
+    forwardCommandUpdates();
+
     // Process stream events from ALL sessions
-    for (auto& pair : _sessionManager->getAllSessions()) {
-        Session* session = &pair.second;
+    for (int slot = 0; slot < MAX_SESSIONS; slot++) {
+        Session* session = _sessionManager->getSessionAt(slot);
         if (!session || !session->lichessAPI) continue;
 
         LichessAPI* api = session->lichessAPI;
         if (!api->isStreaming()) continue;
 
-        String eventJson;
-        if (api->processStreamEvents(eventJson)) {
+        char* eventJson;
+        size_t length;
+        if (api->processStreamEvents(eventJson, length)) {
             // Validate JSON before forwarding
-            if (eventJson.length() > 2 && (eventJson.startsWith("{") || eventJson.startsWith("["))) {
-                // Wrap event with sessionId so browsers can filter
-                String wrappedEvent = "{\"sessionId\":\"" + session->sessionId + "\",\"event\":" + eventJson + "}";
-
-                // Forward wrapped event to all connected SSE clients
-                _eventSource->send(wrappedEvent.c_str(), "lichess-event", millis());
-                Serial.println("Forwarded valid event: " + eventJson.substring(0, 100));
+            if (length > 2 && (eventJson[0] == '{' || eventJson[0] == '[')) {
+                int pliesBefore = session->board ? session->board->getPly() : 0;
+                bool positionEvent = syncSessionBoard(session, eventJson, length);
+                if (positionEvent) {
+                    if (session->gameActive) {
+                        api->setPlayerToMove(isPlayersTurn(session, session->board));
+                    } else {
+                        api->endGame(session->gameId, "Game over");
+                    }
+                    api->traceStreamPly(session->board->getPly());
+                }
+
+                // Forward to the session's SSE clients straight from the stream buffer
+                sendSessionEvent(session, eventJson, length);
+                Serial.printf("Forwarded valid event: %.100s\n", eventJson);
+
+                // First position after the watchdog reopened a dead stream - the
+                // board has caught up on whatever the opponent played meanwhile
+                if (positionEvent && api->takeStreamRecovered()) {
+                    sendStreamRecovered(session, session->board->getPly() - pliesBefore);
+                }
+
+                // Game over - nothing more comes on this stream, and the watchdog
+                // must not keep reopening it
+                if (positionEvent && !session->gameActive) {
+                    api->stopStream();
+                    continue;
+                }
+
+                // Nothing more arrives on the game stream until the player moves, so park
+                // it; makeMove() reopens it and the account stream reports a game ending meanwhile.
+                // A queued premove is about to go out, so the stream stays open for it.
+                if (positionEvent && isPlayersTurn(session, session->board) && !api->isBusy() && !api->hasQueuedMove()) {
+                    Serial.printf("Session %s: Player to move - parking game stream\n", session->sessionId);
+                    api->stopStream();
+                }
             } else {
-                // Lichess sends periodic heartbeat/keepalive messages (single chars like "1", "\n")
-                // to keep the HTTP stream connection alive. These are normal and expected.
-                // They are silently ignored here to avoid log spam.
-                // Serial.println("Lichess heartbeat: [" + eventJson + "]");  // Uncomment for debugging
+                // Lichess sends periodic heartbeat/keepalive messages to keep the HTTP
+                // stream connection alive. Empty lines are counted by the framer; anything
+                // else that is not JSON is silently ignored here to avoid log spam.
+                // Serial.printf("Lichess heartbeat: [%s]\n", eventJson);  // Uncomment for debugging
             }
         }
     }
 }
 
+// Keep the session's board in step with the game stream. gameFull carries the
+// move list under "state", gameState at the top level; only new moves are applied.
+// Returns true if the board now reflects the event's position.
+bool LichessWebHandler::syncSessionBoard(Session* session, const char* eventJson, size_t length) {
+    if (!session->board) {
+        return false;
+    }
+
+    // Only the fields the device acts on are kept - the rest of the event
+    // (player names, ratings, chat) is skipped by the parser
+    static JsonDocument filter;
+    if (filter.isNull()) {
+        const char* fields[] = {"moves", "status", "wtime", "btime"};
+        filter["type"] = true;
+        for (const char* field : fields) {
+            filter[field] = true;
+            filter["state"][field] = true;
+        }
+    }
+
+    JsonDocument doc;
+    if (deserializeJson(doc, eventJson, length, DeserializationOption::Filter(filter))) {
+        return false;
+    }
+
+    const char* type = doc["type"] | "";
+    JsonVariant state;
+    if (strcmp(type, "gameFull") == 0) {
+        state = doc["state"];
+    } else if (strcmp(type, "gameState") == 0) {
+        state = doc.as<JsonVariant>();
+    } else {
+        return false;
+    }
+
+    const char* moves = state["moves"] | "";
+    session->whiteTimeMs = state["wtime"] | session->whiteTimeMs;
+    session->blackTimeMs = state["btime"] | session->blackTimeMs;
+
+    // Any status past "started" means the game is over (mate, resign, outoftime, ...)
+    const char* status = state["status"] | "started";
+    if (strcmp(status, "started") != 0 && strcmp(status, "created") != 0) {
+        session->gameActive = false;
+    }
+
+    _sessionManager->lockBoards();
+    int synced = session->board->syncMoveList(moves);
+    _sessionManager->unlockBoards();
+    if (synced < 0) {
+        Serial.printf("Session %s: Board out of sync with stream (moves: %s)\n",
+                      session->sessionId, moves);
+        return false;
+    }
+    return true;
+}
+
+// board is the session's own (loop() only) or a copy of it
+bool LichessWebHandler::isPlayersTurn(const Session* session, const ChessEngine* board) const {
+    if (!board || !session->gameActive) {
+        return false;
+    }
+    bool playerIsWhite = strcmp(session->playerColor, "black") != 0;
+    return (board->getCurrentPlayer() == WHITE) == playerIsWhite;
+}
+
+// One account-level stream replaces a long-lived stream per game: it reports
+// games starting and finishing, and per-game streams open only while a game
+// waits for the opponent's move
+void LichessWebHandler::routeAccountEvents() {
+    bool anyGameActive = false;
+    for (int slot = 0; slot < MAX_SESSIONS; slot++) {
+        const Session* session = _sessionManager->getSessionAt(slot);
+        if (session && session->gameActive && session->gameId[0] != '\0') {
+            anyGameActive = true;
+            break;
+        }
+    }
+    _accountEvents.setActive(anyGameActive);
+
+    char* eventJson;
+    size_t length;
+    if (!_accountEvents.processEvents(eventJson, length)) {
+        return;
+    }
+
+    JsonDocument filter;
+    filter["type"] = true;
+    filter["game"]["gameId"] = true;
+    filter["game"]["id"] = true;
+    filter["game"]["isMyTurn"] = true;
+
+    JsonDocument doc;
+    if (deserializeJson(doc, eventJson, length, DeserializationOption::Filter(filter))) {
+        return;
+    }
+
+    const char* type = doc["type"] | "";
+    String gameId = doc["game"]["gameId"] | "";
+    if (gameId.length() == 0) {
+        gameId = doc["game"]["id"] | "";
+    }
+
+    // Challenges and games this device is not playing have no session to go to
+    Session* session = _sessionManager->getSessionForGame(gameId);
+    if (!session || !session->lichessAPI) {
+        return;
+    }
+    String sessionId = session->sessionId;
+    LichessAPI* api = session->lichessAPI;
+
+    if (strcmp(type, "gameStart") == 0) {
+        bool isMyTurn = doc["game"]["isMyTurn"] | false;
+        if (!isMyTurn && !api->isStreaming() && !api->isBusy()) {
+            Serial.printf("Session %s: Opponent to move in %s - opening game stream\n", sessionId.c_str(), gameId.c_str());
+            api->startStream(gameId);
+        }
+    } else if (strcmp(type, "gameFinish") == 0) {
+        Serial.printf("Session %s: Game %s finished\n", sessionId.c_str(), gameId.c_str());
+        session->gameActive = false;
+        api->endGame(gameId, "Game over");
+
+        // A parked game gets its final state from one last game stream connection
+        if (!api->isStreaming() && !api->isBusy()) {
+            api->startStream(gameId);
+        }
+
+        sendSessionEvent(session, eventJson, length);
+    }
+}
+
+void LichessWebHandler::sendStreamRecovered(const Session* session, int missedPlies) {
+    Serial.printf("Session %s: Game stream recovered, %d missed move(s) applied\n", session->sessionId, missedPlies);
+
+    char event[192];
+    snprintf(event, sizeof(event),
+             "{\"sessionId\":\"%s\",\"event\":{\"type\":\"connectionRecovered\",\"missedMoves\":%d,"
+             "\"message\":\"Game stream reconnected\"}}",
+             session->sessionId, missedPlies);
+    sendEvent(session, event, "lichess-event");
+}
+
+// Wrap an event with its sessionId, formatting into one static buffer rather than building the wrapper up in Strings per event
+void LichessWebHandler::sendSessionEvent(const Session* session, const char* eventJson, size_t length) {
+    static char wrapped[NDJSON_BUFFER_SIZE + 64];
+    int written = snprintf(wrapped, sizeof(wrapped), "{\"sessionId\":\"%s\",\"event\":%.*s}",
+                           session->sessionId, (int)length, eventJson);
+    if (written < 0 || written >= (int)sizeof(wrapped)) {
+        Serial.printf("Session %s: Event too large to forward (%u bytes)\n", session->sessionId, (unsigned)length);
+        return;
+    }
+    sendEvent(session, wrapped, "lichess-event");
+}
+
+// To the session's own clients. A channel with no clients is skipped before
+// the library formats the message for it, but the event is kept for replay
+// either way - no clients is what a reconnecting browser looks like. event
+// must be a string literal. session may be nullptr for a session deleted
+// meanwhile, whose event has nowhere to go.
+void LichessWebHandler::sendEvent(const Session* session, const char* message, const char* event) {
+    if (!session) {
+        return;
+    }
+    int slot = _sessionManager->getSessionSlot(session);
+    closeStaleChannel(slot);
+
+    xSemaphoreTake(_replayLock, portMAX_DELAY);
+    if (!_replay[slot]) {
+        _replay[slot] = new EventReplayBuffer();
+    }
+    uint32_t id = _replay[slot]->add(event, message);
+    xSemaphoreGive(_replayLock);
+
+    AsyncEventSource* channel = _sessionChannels[slot];
+    if (channel && channel->count() > 0) {
+        channel->send(message, event, id);
+    }
+}
+
+// AsyncTCP task, as a session channel client connects. A reconnecting
+// EventSource sends Last-Event-ID; a fresh one (ID 0) starts from now. An
+// event sent while this runs may reach the client twice - game events carry
+// the whole position, so applying one again is harmless.
+void LichessWebHandler::replayEvents(int slot, AsyncEventSourceClient* client) {
+    uint32_t lastId = client->lastId();
+    if (lastId == 0) {
+        return;
+    }
+
+    xSemaphoreTake(_replayLock, portMAX_DELAY);
+    // The events kept are the session's only once loop() has bound the slot to it
+    const Session* session = _sessionManager->getSessionAt(slot);
+    EventReplayBuffer* replay = _replay[slot];
+    if (session && replay && strcmp(_channelSessionIds[slot], session->sessionId) == 0 &&
+        lastId < replay->getLastId()) {
+        if (lastId + 1 < replay->getFirstId()) {
+            char event[192];
+            snprintf(event, sizeof(event),
+                     "{\"sessionId\":\"%s\",\"event\":{\"type\":\"eventsMissed\",\"lastEventId\":%lu,"
+                     "\"message\":\"Missed events no longer kept - resync game state\"}}",
+                     session->sessionId, (unsigned long)lastId);
+            client->send(event, "lichess-event", 0);
+        }
+
+        int replayed = 0;
+        for (int i = 0; i < replay->getCount(); i++) {
+            uint32_t id;
+            const char* event;
+            const char* message;
+            replay->get(i, id, event, message);
+            if (id > lastId) {
+                client->send(message, event, id);
+                replayed++;
+            }
+        }
+        Serial.printf("Session %s: Replayed %d event(s) after %lu to reconnected client\n",
+                      session->sessionId, replayed, (unsigned long)lastId);
+    }
+    xSemaphoreGive(_replayLock);
+}
+
+// Request filter for the session channels: slot of the session the SSE request
+// names, -1 for none or one that is not live (so an old ID is not let in)
+int LichessWebHandler::getRequestSlot(AsyncWebServerRequest* request) {
+    if (!_sessionManager) {
+        return -1;
+    }
+    Session* session = _sessionManager->getSession(getSessionIdFromRequest(request));
+    return session ? _sessionManager->getSessionSlot(session) : -1;
+}
+
+void LichessWebHandler::closeStaleChannels() {
+    for (int slot = 0; slot < MAX_SESSIONS; slot++) {
+        closeStaleChannel(slot);
+    }
+}
+
+// A slot's clients belong to the session they connected for. Once that session
+// is gone, or the slot holds a newer one, they are closed rather than left to
+// receive someone else's events; a browser that reconnects with a live ID
+// gets back in. One that connected for a brand new session before this ran
+// is closed once too, and reconnects the same way. The new session's events
+// are numbered from 1 again.
+void LichessWebHandler::closeStaleChannel(int slot) {
+    const Session* session = _sessionManager->getSessionAt(slot);
+    const char* sessionId = session ? session->sessionId : "";
+    if (strcmp(_channelSessionIds[slot], sessionId) == 0) {
+        return;
+    }
+    if (_sessionChannels[slot] && _sessionChannels[slot]->count() > 0) {
+        Serial.printf("Closing SSE clients of ended session %s\n", _channelSessionIds[slot]);
+        _sessionChannels[slot]->close();
+    }
+    xSemaphoreTake(_replayLock, portMAX_DELAY);
+    if (_replay[slot]) {
+        _replay[slot]->clear();
+    }
+    strlcpy(_channelSessionIds[slot], sessionId, sizeof(_channelSessionIds[slot]));
+    xSemaphoreGive(_replayLock);
+}
+
+// 202 with the command's ID, or 429 when the session's command queue is full.
+// startedStatus is reported when nothing is ahead of the command.
+void LichessWebHandler::sendCommandResponse(AsyncWebServerRequest* request, LichessAPI* api, uint32_t commandId,
+                                            const char* startedStatus) {
+    if (commandId == 0) {
+        sendErrorResponse(request, 429, "Command queue full");
+        return;
+    }
+
+    bool startsNow = !api->isBusy() && api->getQueueSize() <= 1;
+
+    JsonDocument doc;
+    doc["success"] = true;
+    doc["status"] = startsNow ? startedStatus : "queued";
+    doc["commandId"] = commandId;
+    doc["queueSize"] = api->getQueueSize();
+
+    String response;
+    serializeJson(doc, response);
+    request->send(202, "application/json", response);
+}
+
+// Push each session's command status changes to the browsers
+void LichessWebHandler::forwardCommandUpdates() {
+    for (int slot = 0; slot < MAX_SESSIONS; slot++) {
+        Session* session = _sessionManager->getSessionAt(slot);
+        if (!session || !session->lichessAPI) continue;
+        LichessAPI* api = session->lichessAPI;
+
+        LichessAPI::CommandUpdate update;
+        while (api->popCommandUpdate(update)) {
+            JsonDocument doc;
+            doc["sessionId"] = session->sessionId;
+            doc["commandId"] = update.id;
+            doc["command"] = LichessAPI::commandTypeName(update.type);
+            doc["status"] = LichessAPI::commandStatusName(update.status);
+            doc["detail"] = update.detail;
+
+            String eventData;
+            serializeJson(doc, eventData);
+            sendEvent(session, eventData.c_str(), "lichess-command");
+        }
+    }
+}
+
 void LichessWebHandler::sendJSONResponse(AsyncWebServerRequest* request, int code, const String& json, bool success) {
     request->send(code, "application/json", json);
 }
@@ -350,8 +832,8 @@ void LichessWebHandler::processAsyncResults() {
     std::vector<std::pair<String, String>> failedGames;     // sessionId, error
     std::vector<std::pair<String, String>> recoveredGames;  // sessionId, gameId (timeout recovery)
 
-    for (auto& pair : _sessionManager->getAllSessions()) {
-        Session* session = &pair.second;
+    for (int slot = 0; slot < MAX_SESSIONS; slot++) {
+        Session* session = _sessionManager->getSessionAt(slot);
         if (!session || !session->lichessAPI) continue;
 
         LichessAPI* api = session->lichessAPI;
@@ -360,10 +842,10 @@ void LichessWebHandler::processAsyncResults() {
         // Check for timeout recovery (error message contains "timeout" and stream is active)
         // This should only trigger once, so we must clear the error immediately
         String lastError = api->getLastError();
-        if (lastError.indexOf("timeout") >= 0 && api->isStreaming() && session->gameId.length() > 0) {
+        if (lastError.indexOf("timeout") >= 0 && api->isStreaming() && session->gameId[0] != '\0') {
             Serial.printf("Timeout recovery detected for session %s (game: %s)\n",
-                         session->sessionId.c_str(), session->gameId.c_str());
-            recoveredGames.push_back({session->sessionId, session->gameId});
+                         session->sessionId, session->gameId);
+            recoveredGames.push_back({session->sessionId, String(session->gameId)});
 
             // CRITICAL: Clear the error immediately to prevent infinite loop
             // The error persists until cleared, causing this check to trigger repeatedly
@@ -397,18 +879,17 @@ void LichessWebHandler::processAsyncResults() {
         // Update session state
         Session* session = _sessionManager->getSession(sessionId);
         if (session) {
-            session->gameId = gameId;
+            _sessionManager->setGameId(sessionId, gameId);
             session->gameActive = true;
+            _sessionManager->resetBoard(sessionId);
             Serial.printf("Session %s: Game state updated (gameId=%s, color=%s)\n",
-                          sessionId.c_str(), gameId.c_str(), session->playerColor.c_str());
+                          sessionId.c_str(), gameId.c_str(), session->playerColor);
         }
 
-        // Send SSE event to notify all browsers
-        if (_eventSource) {
-            String eventData = "{\"type\":\"gameCreated\",\"gameId\":\"" + gameId + "\"}";
-            _eventSource->send(eventData.c_str(), "game-created", millis());
-            Serial.printf("Sent game-created SSE event: %s\n", eventData.c_str());
-        }
+        // Send SSE event to notify the session's browsers
+        String eventData = "{\"type\":\"gameCreated\",\"sessionId\":\"" + sessionId + "\",\"gameId\":\"" + gameId + "\"}";
+        sendEvent(session, eventData.c_str(), "game-created");
+        Serial.printf("Sent game-created SSE event: %s\n", eventData.c_str());
     }
 
     // Process failed games
@@ -419,12 +900,15 @@ void LichessWebHandler::processAsyncResults() {
         Serial.printf("Async game creation failed for session %s: %s\n",
                       sessionId.c_str(), error.c_str());
 
-        // Send SSE event to notify all browsers of failure
-        if (_eventSource) {
-            String eventData = "{\"type\":\"gameCreationFailed\",\"error\":\"" + error + "\"}";
-            _eventSource->send(eventData.c_str(), "game-error", millis());
-            Serial.printf("Sent game-error SSE event: %s\n", eventData.c_str());
-        }
+        // Send SSE event to notify the session's browsers of failure
+        JsonDocument doc;
+        doc["type"] = "gameCreationFailed";
+        doc["sessionId"] = sessionId;
+        doc["error"] = error;
+        String eventData;
+        serializeJson(doc, eventData);
+        sendEvent(_sessionManager->getSession(sessionId), eventData.c_str(), "game-error");
+        Serial.printf("Sent game-error SSE event: %s\n", eventData.c_str());
     }
 
     // Process recovered games (timeout recovery)
@@ -436,11 +920,9 @@ void LichessWebHandler::processAsyncResults() {
                       sessionId.c_str(), gameId.c_str());
 
         // Send SSE event to notify browser of recovery
-        if (_eventSource) {
-            String wrappedEvent = "{\"sessionId\":\"" + sessionId + "\",\"event\":{\"type\":\"connectionRecovered\",\"message\":\"Connection timeout recovered - game stream restored\"}}";
-            _eventSource->send(wrappedEvent.c_str(), "lichess-event", millis());
-            Serial.printf("Sent connection-recovered SSE event for session %s\n", sessionId.c_str());
-        }
+        String wrappedEvent = "{\"sessionId\":\"" + sessionId + "\",\"event\":{\"type\":\"connectionRecovered\",\"message\":\"Connection timeout recovered - game stream restored\"}}";
+        sendEvent(_sessionManager->getSession(sessionId), wrappedEvent.c_str(), "lichess-event");
+        Serial.printf("Sent connection-recovered SSE event for session %s\n", sessionId.c_str());
     }
 }
 
@@ -451,6 +933,7 @@ void LichessWebHandler::handleReset(AsyncWebServerRequest* request) {
         sendErrorResponse(request, 500, "Session manager not initialized");
         return;
     }
+    SessionManager::ReadGuard guard(_sessionManager);
 
     // Get session ID
     String sessionId = getSessionIdFromRequest(request);
@@ -466,10 +949,12 @@ void LichessWebHandler::handleReset(AsyncWebServerRequest* request) {
         return;
     }
 
-    // Clear this session's game state
+    // Clear this session's game state - and the premoves and draw offers queued for it
     session->gameActive = false;
-    session->gameId = "";
-    session->playerColor = "white";
+    if (session->lichessAPI) {
+        session->lichessAPI->endGame("", "Reset");
+    }
+    _sessionManager->setGameId(sessionId, "", "white");
 
     Serial.printf("Session %s: Reset complete\n", sessionId.c_str());
 
@@ -559,6 +1044,61 @@ void LichessWebHandler::handleGetSessions(AsyncWebServerRequest* request) {
     request->send(200, "application/json", json);
 }
 
+// Handler: Move latency histograms, for the device and per session (see MoveTrace.h)
+void LichessWebHandler::handleGetMetrics(AsyncWebServerRequest* request) {
+    if (!_sessionManager) {
+        sendErrorResponse(request, 500, "Session manager not initialized");
+        return;
+    }
+    SessionManager::ReadGuard guard(_sessionManager);
+
+    JsonDocument doc;
+    JsonArray bounds = doc["bucketBoundsMs"].to<JsonArray>();
+    for (unsigned long bound : LatencyHistogram::BUCKET_BOUNDS) {
+        bounds.add(bound);
+    }
+
+    writeMoveMetrics(doc["moves"].to<JsonObject>(), _sessionManager->getMoveMetrics());
+
+    JsonArray sessions = doc["sessions"].to<JsonArray>();
+    for (int slot = 0; slot < MAX_SESSIONS; slot++) {
+        const Session* session = _sessionManager->getSessionAt(slot);
+        if (!session || !session->lichessAPI) continue;
+
+        JsonObject entry = sessions.add<JsonObject>();
+        entry["sessionId"] = session->sessionId;
+        entry["gameId"] = _sessionManager->getGameId(session);
+        writeMoveMetrics(entry["moves"].to<JsonObject>(), session->lichessAPI->getMoveMetrics());
+    }
+
+    String response;
+    serializeJson(doc, response);
+    request->send(200, "application/json", response);
+}
+
+// Percentiles are bucket upper bounds, so they never understate a span
+void LichessWebHandler::writeMoveMetrics(JsonObject json, const MoveMetrics& metrics) {
+    json["traced"] = metrics.getTraced();
+    json["failed"] = metrics.getFailed();
+    json["lostEchoes"] = metrics.getLostEchoes();
+
+    JsonObject spans = json["spans"].to<JsonObject>();
+    for (int i = 0; i < SPAN_COUNT; i++) {
+        const LatencyHistogram& histogram = metrics.getSpan((MoveSpan)i);
+        JsonObject span = spans[MoveMetrics::spanName((MoveSpan)i)].to<JsonObject>();
+        span["count"] = histogram.getCount();
+        span["avgMs"] = histogram.getAverage();
+        span["p50Ms"] = histogram.getPercentile(50);
+        span["p90Ms"] = histogram.getPercentile(90);
+        span["p99Ms"] = histogram.getPercentile(99);
+        span["maxMs"] = histogram.getMax();
+        JsonArray buckets = span["buckets"].to<JsonArray>();
+        for (int bucket = 0; bucket < MOVE_LATENCY_BUCKETS; bucket++) {
+            buckets.add(histogram.getBucket(bucket));
+        }
+    }
+}
+
 // Session cleanup (call from main loop)
 void LichessWebHandler::cleanupSessions() {
     if (_sessionManager) {
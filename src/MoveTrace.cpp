@@ -0,0 +1,131 @@
+#include "MoveTrace.h"
+
+const unsigned long LatencyHistogram::BUCKET_BOUNDS[MOVE_LATENCY_BUCKETS - 1] = {
+    10, 25, 50, 100, 250, 500, 1000, 2500, 5000, 10000, 30000
+};
+
+void LatencyHistogram::reset() {
+    for (int i = 0; i < MOVE_LATENCY_BUCKETS; i++) {
+        _buckets[i] = 0;
+    }
+    _count = 0;
+    _sum = 0;
+    _max = 0;
+}
+
+void LatencyHistogram::record(unsigned long ms) {
+    int bucket = 0;
+    while (bucket < MOVE_LATENCY_BUCKETS - 1 && ms > BUCKET_BOUNDS[bucket]) {
+        bucket++;
+    }
+    _buckets[bucket]++;
+    _count++;
+    _sum += ms;
+    if (ms > _max) {
+        _max = ms;
+    }
+}
+
+unsigned long LatencyHistogram::getPercentile(uint8_t percent) const {
+    if (_count == 0) {
+        return 0;
+    }
+
+    // Nearest rank: the smallest sample with at least percent% of samples at or below it
+    unsigned long rank = ((unsigned long long)_count * percent + 99) / 100;
+    if (rank == 0) {
+        rank = 1;
+    }
+    unsigned long seen = 0;
+    for (int i = 0; i < MOVE_LATENCY_BUCKETS - 1; i++) {
+        seen += _buckets[i];
+        if (seen >= rank) {
+            return min(BUCKET_BOUNDS[i], _max);
+        }
+    }
+    return _max;
+}
+
+void MoveTrace::clear() {
+    move = "";
+    ply = -1;
+    received = 0;
+    started = 0;
+    submitted = 0;
+    sent = 0;
+    handshake = 0;
+    answered = 0;
+    accepted = 0;
+    resumed = 0;
+    echoed = 0;
+}
+
+bool MoveTrace::getSpan(MoveSpan span, unsigned long& ms) const {
+    // The echo can beat process() to the answer while the stream stays open
+    unsigned long settled = max(accepted, resumed);
+    unsigned long from = 0;
+    unsigned long to = 0;
+    switch (span) {
+        case SPAN_QUEUE:         from = received;  to = started;   break;
+        case SPAN_PREPARE:       from = started;   to = submitted; break;
+        case SPAN_POOL_WAIT:     from = submitted; to = sent;      break;
+        case SPAN_TLS_CONNECT:
+            ms = handshake;
+            return handshake > 0;
+        case SPAN_POST:
+            // Worker stamps both ends, so the handshake is inside them
+            ms = answered - sent - handshake;
+            return sent > 0 && answered >= sent + handshake;
+        case SPAN_RESPONSE:      from = answered;  to = accepted;  break;
+        case SPAN_STREAM_RESUME:
+            if (resumed == 0) {
+                return false;
+            }
+            from = accepted;
+            to = resumed;
+            break;
+        case SPAN_ECHO:
+            ms = echoed > settled ? echoed - settled : 0;
+            return echoed > 0;
+        case SPAN_TOTAL:         from = received;  to = echoed;    break;
+        default:
+            return false;
+    }
+    if (from == 0 || to == 0) {
+        return false;
+    }
+    ms = (long)(to - from) > 0 ? to - from : 0;
+    return true;
+}
+
+void MoveMetrics::reset() {
+    for (int i = 0; i < SPAN_COUNT; i++) {
+        _spans[i].reset();
+    }
+    _failed = 0;
+    _lostEchoes = 0;
+}
+
+void MoveMetrics::record(const MoveTrace& trace) {
+    for (int i = 0; i < SPAN_COUNT; i++) {
+        unsigned long ms;
+        if (trace.getSpan((MoveSpan)i, ms)) {
+            _spans[i].record(ms);
+        }
+    }
+}
+
+const char* MoveMetrics::spanName(MoveSpan span) {
+    switch (span) {
+        case SPAN_QUEUE:         return "queue";
+        case SPAN_PREPARE:       return "prepare";
+        case SPAN_POOL_WAIT:     return "poolWait";
+        case SPAN_TLS_CONNECT:   return "tlsConnect";
+        case SPAN_POST:          return "post";
+        case SPAN_RESPONSE:      return "response";
+        case SPAN_STREAM_RESUME: return "streamResume";
+        case SPAN_ECHO:          return "echo";
+        case SPAN_TOTAL:         return "total";
+        default:                 return "unknown";
+    }
+}
@@ -0,0 +1,75 @@
+#include "NdjsonFramer.h"
+
+void NdjsonFramer::reset() {
+    _start = 0;
+    _scan = 0;
+    _end = 0;
+    _discarding = false;
+    _heartbeats = 0;
+    _lastHeartbeat = 0;
+    _lastRead = 0;
+    _overflows = 0;
+}
+
+bool NdjsonFramer::next(WiFiClient* client, char*& line, size_t& length) {
+    while (true) {
+        // Hand out the next whole line already in the buffer
+        char* newline = (char*)memchr(_buffer + _scan, '\n', _end - _scan);
+        if (newline) {
+            size_t lineEnd = newline - _buffer;
+            size_t lineStart = _start;
+            bool dropped = _discarding;
+            _start = _scan = lineEnd + 1;
+            _discarding = false;
+
+            if (dropped) continue;
+
+            size_t lineLength = lineEnd - lineStart;
+            if (lineLength > 0 && _buffer[lineEnd - 1] == '\r') {
+                lineLength--;
+            }
+            if (lineLength == 0) {
+                _heartbeats++;
+                _lastHeartbeat = millis();
+                continue;
+            }
+
+            _buffer[lineStart + lineLength] = '\0';
+            line = _buffer + lineStart;
+            length = lineLength;
+            return true;
+        }
+        _scan = _end;
+
+        if (!client) return false;
+        int available = client->available();
+        if (available <= 0) return false;
+
+        // Everything handed out - start over at the front for free
+        if (_start == _end) {
+            _start = _scan = _end = 0;
+        }
+
+        // Make room: move the partial line to the front, or give up on it if it fills the buffer
+        if (_end == NDJSON_BUFFER_SIZE) {
+            if (_start > 0) {
+                memmove(_buffer, _buffer + _start, _end - _start);
+                _end -= _start;
+                _scan = _end;
+                _start = 0;
+            } else {
+                _overflows++;
+                _discarding = true;
+                _start = _scan = _end = 0;
+            }
+        }
+        if (_discarding) {
+            _start = _scan = _end = 0;
+        }
+
+        int bytesRead = client->read((uint8_t*)_buffer + _end, min((size_t)available, NDJSON_BUFFER_SIZE - _end));
+        if (bytesRead <= 0) return false;
+        _end += bytesRead;
+        _lastRead = millis();
+    }
+}
@@ -1,17 +1,37 @@
 #include "SessionManager.h"
 #include "LichessAPI.h"
+#include "ChessEngine.h"
 #include "SDLogger.h"
 #include <ArduinoJson.h>
 #include <SD.h>
+#include <new>
 
-SessionManager::SessionManager() : _lastCleanup(0), _apiToken("") {
+SessionManager::SessionManager() : _readers(0), _gameMux(portMUX_INITIALIZER_UNLOCKED), _gameIndexSeq(0), _lastCleanup(0), _apiToken("") {
+    for (int i = 0; i < SESSION_GAME_INDEX_SIZE; i++) {
+        _gameIndex[i].store(-1);
+    }
+    for (int i = 0; i < MAX_SESSIONS; i++) {
+        _boards[i] = nullptr;
+        _slotState[i].store(SLOT_FREE);
+        _slotKey[i].store(0);
+        _slotSeq[i].store(0);
+        _slotGeneration[i] = 0;
+    }
+    _writeLock = xSemaphoreCreateMutex();
+    _boardLock = xSemaphoreCreateMutex();
     Serial.println("SessionManager initialized");
 }
 
 SessionManager::~SessionManager() {
-    // Clean up all LichessAPI instances
-    for (auto& pair : _sessions) {
-        destroyLichessAPIForSession(&pair.second);
+    // The slots' LichessAPI instances go with _apis
+    for (int i = 0; i < MAX_SESSIONS; i++) {
+        delete _boards[i];
+    }
+    if (_writeLock) {
+        vSemaphoreDelete(_writeLock);
+    }
+    if (_boardLock) {
+        vSemaphoreDelete(_boardLock);
     }
 }
 
@@ -20,175 +40,374 @@ void SessionManager::setAPIToken(const char* token) {
     Serial.printf("API token set for all sessions (length: %d)\n", _apiToken.length());
 }
 
-void SessionManager::createLichessAPIForSession(Session* session) {
-    if (!session) return;
-
-    if (session->lichessAPI) {
-        Serial.printf("Session %s: LichessAPI already exists\n", session->sessionId.c_str());
-        return;
-    }
-
-    session->lichessAPI = new LichessAPI();
+// Writer lock held - the slot's API is configured for its new session
+void SessionManager::createLichessAPIForSession(int slot) {
+    LichessAPI* api = &_apis[slot];
+    api->setConnectionPool(&_connectionPool);
+    api->setMoveMetrics(&_moveMetrics);
     if (_apiToken.length() > 0) {
-        session->lichessAPI->begin(_apiToken.c_str());
+        api->begin(_apiToken.c_str());
     }
-    Serial.printf("Session %s: LichessAPI instance created\n", session->sessionId.c_str());
+    _sessions[slot].lichessAPI = api;
 }
 
-void SessionManager::destroyLichessAPIForSession(Session* session) {
-    if (!session) return;
-
-    if (session->lichessAPI) {
-        delete session->lichessAPI;
-        session->lichessAPI = nullptr;
-        Serial.printf("Session %s: LichessAPI instance destroyed\n", session->sessionId.c_str());
-    }
-}
-
-// Generate a simple unique session ID based on time and random value
-String SessionManager::generateSessionId() {
-    char sessionId[17];
-    unsigned long timestamp = millis();
-    int randomValue = random(0, 65536);
-    snprintf(sessionId, sizeof(sessionId), "%08lx%04x", timestamp, randomValue);
-    return String(sessionId);
+// Writer lock held - closes the old session's stream and drops its requests,
+// leaving the API as good as new for the slot's next session. The new API has
+// the old one's address, which is how the pool knows its stream lease; the
+// destructor gives up the lease (an open in flight goes to the pool), and the
+// pool never hands back a connection that is still opening.
+void SessionManager::resetLichessAPIForSession(int slot) {
+    _apis[slot].~LichessAPI();
+    new (&_apis[slot]) LichessAPI();
+    _sessions[slot].lichessAPI = nullptr;
 }
 
 // Check if session has expired based on last activity
 bool SessionManager::isSessionExpired(const Session& session) const {
     unsigned long now = millis();
+    unsigned long lastActivity = session.lastActivity.load();
     // Handle millis() rollover (occurs every ~49 days)
-    if (now < session.lastActivity) {
+    if (now < lastActivity) {
         return false; // Don't expire during rollover
     }
-    return (now - session.lastActivity) > SESSION_TIMEOUT_MS;
+    return (now - lastActivity) > SESSION_TIMEOUT_MS;
 }
 
-// Create new session
-String SessionManager::createSession(const String& ipAddress) {
-    // Check for existing sessions from the same IP with pendingRefresh flag
-    std::vector<String> sessionsToDelete;
-    for (auto& pair : _sessions) {
-        if (pair.second.ipAddress == ipAddress && pair.second.pendingRefresh) {
-            sessionsToDelete.push_back(pair.first);
-            Serial.printf("Marking old session %s for deletion (pending refresh from %s)\n",
-                         pair.first.c_str(), ipAddress.c_str());
-        }
-    }
+void SessionManager::lockWrites() {
+    xSemaphoreTake(_writeLock, portMAX_DELAY);
+}
 
-    // Delete old sessions from the same IP that were flagged for refresh
-    // Use safe iteration to avoid issues during deletion
-    for (const String& oldSessionId : sessionsToDelete) {
-        // Double-check session still exists before deleting (safety check)
-        if (hasSession(oldSessionId)) {
-            bool deleted = deleteSession(oldSessionId);
-            if (deleted) {
-                Serial.printf("Successfully deleted old session %s (refresh cleanup)\n", oldSessionId.c_str());
-            } else {
-                Serial.printf("WARNING: Failed to delete session %s during refresh cleanup\n", oldSessionId.c_str());
-            }
+void SessionManager::unlockWrites() {
+    xSemaphoreGive(_writeLock);
+}
+
+// Writer side of the slot's sequence counter - odd from begin to end
+void SessionManager::beginSlotWrite(int slot) {
+    _slotSeq[slot].fetch_add(1, std::memory_order_acq_rel);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+void SessionManager::endSlotWrite(int slot) {
+    _slotSeq[slot].fetch_add(1, std::memory_order_release);
+}
+
+// 4 hex digits of slot, then 8 of key
+bool SessionManager::parseSessionId(const String& sessionId, int& slot, uint32_t& key) {
+    if (sessionId.length() != SESSION_ID_LENGTH) {
+        return false;
+    }
+    uint32_t slotValue = 0;
+    key = 0;
+    for (int i = 0; i < SESSION_ID_LENGTH; i++) {
+        char c = sessionId[i];
+        uint32_t digit;
+        if (c >= '0' && c <= '9') digit = c - '0';
+        else if (c >= 'a' && c <= 'f') digit = c - 'a' + 10;
+        else return false;
+        if (i < 4) {
+            slotValue = (slotValue << 4) | digit;
         } else {
-            Serial.printf("WARNING: Session %s already deleted, skipping\n", oldSessionId.c_str());
+            key = (key << 4) | digit;
         }
     }
+    if (slotValue >= MAX_SESSIONS) {
+        return false;
+    }
+    slot = slotValue;
+    return true;
+}
+
+// Lock-free: the ID names the slot, and the key tells this session from
+// earlier ones in the same slot
+int SessionManager::findSlot(const String& sessionId) const {
+    int slot;
+    uint32_t key;
+    if (!parseSessionId(sessionId, slot, key)) {
+        return -1;
+    }
+    if (_slotState[slot].load() != SLOT_LIVE || _slotKey[slot].load() != key) {
+        return -1;
+    }
+    return slot;
+}
 
-    // Check if we've hit the session limit
-    if (_sessions.size() >= MAX_SESSIONS) {
-        // Try cleaning up expired sessions first
-        cleanupExpiredSessions();
+Session* SessionManager::getSessionAt(int slot) {
+    if (slot < 0 || slot >= MAX_SESSIONS || _slotState[slot].load() != SLOT_LIVE) {
+        return nullptr;
+    }
+    return &_sessions[slot];
+}
 
-        // Still at limit? Fail
-        if (_sessions.size() >= MAX_SESSIONS) {
-            Serial.printf("ERROR: Maximum session limit reached (%d sessions)\n", MAX_SESSIONS);
-            return "";
-        }
+const Session* SessionManager::getSessionAt(int slot) const {
+    if (slot < 0 || slot >= MAX_SESSIONS || _slotState[slot].load() != SLOT_LIVE) {
+        return nullptr;
     }
+    return &_sessions[slot];
+}
 
-    // Generate unique session ID
-    String sessionId = generateSessionId();
+// Create new session
+String SessionManager::createSession(const String& ipAddress) {
+    lockWrites();
+
+    // Retire old sessions from the same IP that an admin flagged for refresh
+    for (int i = 0; i < MAX_SESSIONS; i++) {
+        Session* old = getSessionAt(i);
+        if (old && ipAddress == old->ipAddress && old->pendingRefresh) {
+            Serial.printf("Deleting old session %s (pending refresh from %s)\n",
+                          old->sessionId, ipAddress.c_str());
+            retireSlot(i);
+        }
+    }
 
-    // Ensure it's truly unique (handle collision)
-    while (_sessions.find(sessionId) != _sessions.end()) {
-        sessionId = generateSessionId();
+    // Retired slots only come back once loop() has freed them
+    int slot = -1;
+    for (int pass = 0; pass < 2 && slot < 0; pass++) {
+        if (pass == 1) {
+            retireExpiredSessions();  // Make room for next time
+        }
+        for (int i = 0; i < MAX_SESSIONS; i++) {
+            if (_slotState[i].load() == SLOT_FREE) {
+                slot = i;
+                break;
+            }
+        }
+    }
+    if (slot < 0) {
+        unlockWrites();
+        Serial.printf("ERROR: Maximum session limit reached (%d sessions)\n", MAX_SESSIONS);
+        return "";
     }
 
-    // Create new session
-    Session session;
-    session.sessionId = sessionId;
-    session.ipAddress = ipAddress;
-    session.gameActive = false;
+    // New generation for the slot, so IDs of its earlier sessions no longer
+    // match; the random tag keeps IDs from being guessed
+    _slotGeneration[slot]++;
+    uint32_t key = ((uint32_t)_slotGeneration[slot] << 16) | (uint32_t)random(0, 65536);
+    char sessionId[SESSION_ID_LENGTH + 1];
+    snprintf(sessionId, sizeof(sessionId), "%04x%08lx", slot, (unsigned long)key);
+
+    // Nothing reads a free slot, so it is filled in before being made visible
+    beginSlotWrite(slot);
+    Session& session = _sessions[slot];
+    session.reset();
+    strlcpy(session.sessionId, sessionId, sizeof(session.sessionId));
+    strlcpy(session.ipAddress, ipAddress.c_str(), sizeof(session.ipAddress));
     session.createdAt = millis();
     session.lastActivity = millis();
-    session.lichessAPI = nullptr;
 
     // Enable debug logging by default for IPs NOT in the 192.168.1.x range
     if (!ipAddress.startsWith("192.168.1.")) {
         session.debugLogEnabled = true;
-        Serial.printf("Session %s: Debug logging enabled (external IP: %s)\n", sessionId.c_str(), ipAddress.c_str());
+        Serial.printf("Session %s: Debug logging enabled (external IP: %s)\n", sessionId, ipAddress.c_str());
     } else {
         session.debugLogEnabled = false;
     }
 
-    _sessions[sessionId] = session;
+    createLichessAPIForSession(slot);
+    endSlotWrite(slot);
+    _slotKey[slot].store(key);
+    _slotState[slot].store(SLOT_LIVE);
 
-    // Create LichessAPI instance for this session
-    createLichessAPIForSession(&_sessions[sessionId]);
+    unlockWrites();
 
     Serial.printf("Session created: %s from IP %s (total sessions: %d)\n",
-                  sessionId.c_str(), ipAddress.c_str(), _sessions.size());
+                  sessionId, ipAddress.c_str(), getActiveSessionCount());
 
-    return sessionId;
+    return String(sessionId);
 }
 
 // Check if session exists
 bool SessionManager::hasSession(const String& sessionId) const {
-    return _sessions.find(sessionId) != _sessions.end();
+    return findSlot(sessionId) >= 0;
 }
 
 // Get session pointer (returns nullptr if not found)
 Session* SessionManager::getSession(const String& sessionId) {
-    auto it = _sessions.find(sessionId);
-    if (it != _sessions.end()) {
-        return &(it->second);
-    }
-    return nullptr;
+    int slot = findSlot(sessionId);
+    return slot >= 0 ? &_sessions[slot] : nullptr;
 }
 
-// Delete session
+// Delete session - it disappears from lookups at once, its API is reset in cleanupExpiredSessions()
 bool SessionManager::deleteSession(const String& sessionId) {
-    auto it = _sessions.find(sessionId);
-    if (it != _sessions.end()) {
-        // Safety check: ensure session ID matches (paranoid validation)
-        if (it->second.sessionId.isEmpty() || it->second.sessionId != sessionId) {
-            Serial.printf("WARNING: Session ID mismatch during deletion (expected: %s, got: %s)\n",
-                         sessionId.c_str(), it->second.sessionId.c_str());
-        }
+    lockWrites();
+    int slot = findSlot(sessionId);
+    if (slot >= 0) {
+        retireSlot(slot);
+    }
+    unlockWrites();
+
+    if (slot < 0) {
+        Serial.printf("WARNING: Attempted to delete non-existent session: %s\n", sessionId.c_str());
+        return false;
+    }
+    return true;
+}
+
+// Writer lock held
+void SessionManager::retireSlot(int slot) {
+    Session& session = _sessions[slot];
+    Serial.printf("Session deleted: %s (IP: %s, game: %s)\n",
+                  session.sessionId, session.ipAddress, session.gameId);
+
+    // Events for its game stop finding it along with everything else
+    portENTER_CRITICAL(&_gameMux);
+    unindexGame(slot);
+    _slotState[slot].store(SLOT_RETIRED);
+    portEXIT_CRITICAL(&_gameMux);
+}
+
+// Game IDs are read without the lock under a sequence counter, and may be
+// mid-change while they are; relaxed atomic byte copies keep that defined
+static void storeGameText(char* dst, const char* src, size_t size) {
+    size_t i = 0;
+    for (; i + 1 < size && src[i]; i++) {
+        __atomic_store_n(&dst[i], src[i], __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&dst[i], '\0', __ATOMIC_RELAXED);
+}
+
+static void loadGameText(char* dst, const char* src, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        dst[i] = __atomic_load_n(&src[i], __ATOMIC_RELAXED);
+    }
+    dst[size - 1] = '\0';
+}
+
+// FNV-1a
+uint32_t SessionManager::hashGameId(const char* gameId) {
+    uint32_t hash = 2166136261u;
+    while (*gameId) {
+        hash ^= (uint8_t)*gameId++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Writer lock and _gameMux held, slot's game ID already set
+void SessionManager::indexGame(int slot) {
+    if (_sessions[slot].gameId[0] == '\0') {
+        return;
+    }
+    uint32_t bucket = hashGameId(_sessions[slot].gameId) & (SESSION_GAME_INDEX_SIZE - 1);
+    while (_gameIndex[bucket].load(std::memory_order_relaxed) >= 0) {
+        bucket = (bucket + 1) & (SESSION_GAME_INDEX_SIZE - 1);
+    }
+    _gameIndexSeq.fetch_add(1, std::memory_order_acq_rel);
+    std::atomic_thread_fence(std::memory_order_release);
+    _gameIndex[bucket].store(slot, std::memory_order_relaxed);
+    _gameIndexSeq.fetch_add(1, std::memory_order_release);
+}
 
-        Serial.printf("Session deleted: %s (IP: %s, game: %s)\n",
-                      sessionId.c_str(),
-                      it->second.ipAddress.c_str(),
-                      it->second.gameId.c_str());
+// Writer lock and _gameMux held, slot's game ID not yet changed. Entries
+// after the removed one move back, so probes still stop at the first gap.
+void SessionManager::unindexGame(int slot) {
+    int hole = -1;
+    for (int i = 0; i < SESSION_GAME_INDEX_SIZE; i++) {
+        if (_gameIndex[i].load(std::memory_order_relaxed) == slot) {
+            hole = i;
+            break;
+        }
+    }
+    if (hole < 0) {
+        return;
+    }
 
-        // Destroy LichessAPI instance for this session (handles nullptr safely)
-        destroyLichessAPIForSession(&it->second);
+    _gameIndexSeq.fetch_add(1, std::memory_order_acq_rel);
+    std::atomic_thread_fence(std::memory_order_release);
+    _gameIndex[hole].store(-1, std::memory_order_relaxed);
+    int next = hole;
+    for (;;) {
+        next = (next + 1) & (SESSION_GAME_INDEX_SIZE - 1);
+        int8_t moved = _gameIndex[next].load(std::memory_order_relaxed);
+        if (moved < 0) {
+            break;
+        }
+        // An entry whose home bucket lies after the hole (up to where it sits) stays put
+        int home = hashGameId(_sessions[moved].gameId) & (SESSION_GAME_INDEX_SIZE - 1);
+        bool stays = hole <= next ? (hole < home && home <= next) : (hole < home || home <= next);
+        if (!stays) {
+            _gameIndex[hole].store(moved, std::memory_order_relaxed);
+            _gameIndex[next].store(-1, std::memory_order_relaxed);
+            hole = next;
+        }
+    }
+    _gameIndexSeq.fetch_add(1, std::memory_order_release);
+}
 
-        // Erase session from map
-        _sessions.erase(it);
+// Lock-free: probes from the game's home bucket, retried if the index or a
+// game ID changed meanwhile. Writers hold _gameMux, so the wait is short.
+int SessionManager::findGameSlot(const String& gameId) const {
+    if (gameId.length() == 0) {
+        return -1;
+    }
+    uint32_t home = hashGameId(gameId.c_str()) & (SESSION_GAME_INDEX_SIZE - 1);
+    for (;;) {
+        uint32_t seq = _gameIndexSeq.load(std::memory_order_acquire);
+        if (seq & 1) {
+            continue;
+        }
+        int found = -1;
+        for (int i = 0; i < SESSION_GAME_INDEX_SIZE; i++) {
+            int8_t slot = _gameIndex[(home + i) & (SESSION_GAME_INDEX_SIZE - 1)].load(std::memory_order_relaxed);
+            if (slot < 0) {
+                break;
+            }
+            char slotGameId[SESSION_GAME_ID_MAX];
+            loadGameText(slotGameId, _sessions[slot].gameId, sizeof(slotGameId));
+            if (strcmp(slotGameId, gameId.c_str()) == 0) {
+                found = slot;
+                break;
+            }
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (_gameIndexSeq.load(std::memory_order_relaxed) == seq) {
+            return found >= 0 && _slotState[found].load() == SLOT_LIVE ? found : -1;
+        }
+    }
+}
 
-        // Verify deletion
-        if (_sessions.find(sessionId) != _sessions.end()) {
-            Serial.printf("ERROR: Session %s still exists after erase!\n", sessionId.c_str());
-            return false;
+// Writer lock held
+void SessionManager::retireExpiredSessions() {
+    for (int i = 0; i < MAX_SESSIONS; i++) {
+        Session* session = getSessionAt(i);
+        if (session && isSessionExpired(*session)) {
+            Serial.printf("Cleaning up expired session: %s\n", session->sessionId);
+            retireSlot(i);
         }
+    }
+}
 
-        return true;
+// Free retired sessions once no request handler can still be using one. A
+// handler that starts after a slot was retired cannot find it, so a moment
+// with no ReadGuard held is enough for the slots retired before it.
+void SessionManager::reclaimRetiredSessions() {
+    bool retired[MAX_SESSIONS];
+    bool anyRetired = false;
+    for (int i = 0; i < MAX_SESSIONS; i++) {
+        retired[i] = _slotState[i].load() == SLOT_RETIRED;
+        anyRetired = anyRetired || retired[i];
     }
-    Serial.printf("WARNING: Attempted to delete non-existent session: %s\n", sessionId.c_str());
-    return false;
+    if (!anyRetired || _readers.load() != 0) {
+        return;
+    }
+
+    lockWrites();
+    for (int i = 0; i < MAX_SESSIONS; i++) {
+        if (!retired[i]) {
+            continue;
+        }
+        beginSlotWrite(i);
+        resetLichessAPIForSession(i);
+        _sessions[i].reset();
+        endSlotWrite(i);
+        _slotState[i].store(SLOT_FREE);
+    }
+    unlockWrites();
 }
 
 // Clean up expired sessions
 void SessionManager::cleanupExpiredSessions() {
+    reclaimRetiredSessions();
+
     unsigned long now = millis();
 
     // Only cleanup every 60 seconds to avoid overhead
@@ -198,38 +417,58 @@ void SessionManager::cleanupExpiredSessions() {
 
     _lastCleanup = now;
 
-    std::vector<String> expiredSessions;
+    lockWrites();
+    retireExpiredSessions();
+    unlockWrites();
+}
 
-    // Find expired sessions
-    for (auto& pair : _sessions) {
-        if (isSessionExpired(pair.second)) {
-            expiredSessions.push_back(pair.first);
-        }
+// Set game ID (and color, unless nullptr) for session
+bool SessionManager::setGameId(const String& sessionId, const String& gameId, const char* color) {
+    lockWrites();
+    int slot = findSlot(sessionId);
+    if (slot < 0) {
+        unlockWrites();
+        return false;
     }
 
-    // Delete expired sessions
-    for (const String& sessionId : expiredSessions) {
-        Serial.printf("Cleaning up expired session: %s\n", sessionId.c_str());
-        deleteSession(sessionId);
+    // The index moves with the game ID: out under the old one, in under the new
+    Session& session = _sessions[slot];
+    portENTER_CRITICAL(&_gameMux);
+    unindexGame(slot);
+    beginSlotWrite(slot);
+    _gameIndexSeq.fetch_add(1, std::memory_order_acq_rel);
+    storeGameText(session.gameId, gameId.c_str(), sizeof(session.gameId));
+    if (color) {
+        strlcpy(session.playerColor, color, sizeof(session.playerColor));
     }
+    _gameIndexSeq.fetch_add(1, std::memory_order_release);
+    endSlotWrite(slot);
+    indexGame(slot);
+    portEXIT_CRITICAL(&_gameMux);
+    session.lastActivity = millis();
+    unlockWrites();
+
+    Serial.printf("Session %s: game set to %s (color: %s)\n",
+                  sessionId.c_str(), gameId.c_str(), session.playerColor);
+    return true;
 }
 
-// Set game ID and color for session
-bool SessionManager::setGameId(const String& sessionId, const String& gameId, const String& color) {
-    Session* session = getSession(sessionId);
-    if (session) {
-        session->gameId = gameId;
-        session->playerColor = color;
-        session->lastActivity = millis();
-        Serial.printf("Session %s: game set to %s (color: %s)\n",
-                      sessionId.c_str(), gameId.c_str(), color.c_str());
-        return true;
-    }
-    return false;
+// Copied under the slot's sequence counter - retried if setGameId() ran meanwhile
+String SessionManager::getGameId(const Session* session) const {
+    int slot = session - _sessions;
+    char gameId[SESSION_GAME_ID_MAX];
+    uint32_t seq;
+    do {
+        seq = _slotSeq[slot].load(std::memory_order_acquire);
+        loadGameText(gameId, session->gameId, sizeof(gameId));
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while ((seq & 1) || seq != _slotSeq[slot].load(std::memory_order_relaxed));
+    return String(gameId);
 }
 
 // Set game active status
 bool SessionManager::setGameActive(const String& sessionId, bool active) {
+    ReadGuard guard(this);
     Session* session = getSession(sessionId);
     if (session) {
         session->gameActive = active;
@@ -241,8 +480,44 @@ bool SessionManager::setGameActive(const String& sessionId, bool active) {
     return false;
 }
 
+// Put the session's board back to the start position for a new game. The
+// slot keeps its board for later sessions, so it is allocated at most once.
+ChessEngine* SessionManager::resetBoard(const String& sessionId) {
+    int slot = findSlot(sessionId);
+    if (slot < 0) {
+        return nullptr;
+    }
+
+    if (!_boards[slot]) {
+        _boards[slot] = new ChessEngine();
+        Serial.printf("Session %s: Board created\n", sessionId.c_str());
+    }
+    lockBoards();
+    _boards[slot]->resetGame();
+    _sessions[slot].board = _boards[slot];
+    unlockBoards();
+    return _boards[slot];
+}
+
+// ~5KB on the heap rather than a request handler's stack
+ChessEngine* SessionManager::copyBoard(const Session* session) {
+    lockBoards();
+    ChessEngine* copy = session->board ? new ChessEngine(*session->board) : nullptr;
+    unlockBoards();
+    return copy;
+}
+
+void SessionManager::lockBoards() {
+    xSemaphoreTake(_boardLock, portMAX_DELAY);
+}
+
+void SessionManager::unlockBoards() {
+    xSemaphoreGive(_boardLock);
+}
+
 // Update last activity timestamp
 bool SessionManager::updateActivity(const String& sessionId) {
+    ReadGuard guard(this);
     Session* session = getSession(sessionId);
     if (session) {
         session->lastActivity = millis();
@@ -253,34 +528,42 @@ bool SessionManager::updateActivity(const String& sessionId) {
 
 // Process all session API instances (call from main loop)
 void SessionManager::processAllSessions() {
-    for (auto& pair : _sessions) {
-        if (pair.second.lichessAPI) {
-            pair.second.lichessAPI->process();
+    for (int i = 0; i < MAX_SESSIONS; i++) {
+        Session* session = getSessionAt(i);
+        if (session && session->lichessAPI) {
+            session->lichessAPI->process();
         }
     }
 }
 
 // Get count of active sessions
 int SessionManager::getActiveSessionCount() const {
-    return _sessions.size();
+    int count = 0;
+    for (int i = 0; i < MAX_SESSIONS; i++) {
+        if (getSessionAt(i)) {
+            count++;
+        }
+    }
+    return count;
 }
 
 // Find session by game ID
 String SessionManager::getSessionByGameId(const String& gameId) const {
-    for (const auto& pair : _sessions) {
-        if (pair.second.gameId == gameId) {
-            return pair.first;
-        }
-    }
-    return "";
+    int slot = findGameSlot(gameId);
+    return slot >= 0 ? String(_sessions[slot].sessionId) : String("");
+}
+
+Session* SessionManager::getSessionForGame(const String& gameId) {
+    return getSessionAt(findGameSlot(gameId));
 }
 
 // Get all sessions from specific IP
 std::vector<String> SessionManager::getSessionsByIP(const String& ipAddress) const {
     std::vector<String> sessions;
-    for (const auto& pair : _sessions) {
-        if (pair.second.ipAddress == ipAddress) {
-            sessions.push_back(pair.first);
+    for (int i = 0; i < MAX_SESSIONS; i++) {
+        const Session* session = getSessionAt(i);
+        if (session && ipAddress == session->ipAddress) {
+            sessions.push_back(String(session->sessionId));
         }
     }
     return sessions;
@@ -372,43 +655,50 @@ bool SessionManager::loadAdminIPsFromSD() {
 
 // Print active sessions for debugging
 void SessionManager::printActiveSessions() const {
-    Serial.printf("=== Active Sessions (%d) ===\n", _sessions.size());
-    for (const auto& pair : _sessions) {
-        const Session& s = pair.second;
-        Serial.printf("  Session: %s\n", s.sessionId.c_str());
-        Serial.printf("    IP: %s\n", s.ipAddress.c_str());
-        Serial.printf("    Game: %s (%s)\n", s.gameId.c_str(), s.playerColor.c_str());
-        Serial.printf("    Active: %s\n", s.gameActive ? "Yes" : "No");
-        unsigned long age = (millis() - s.createdAt) / 1000;
+    ReadGuard guard(this);
+    Serial.printf("=== Active Sessions (%d) ===\n", getActiveSessionCount());
+    for (int i = 0; i < MAX_SESSIONS; i++) {
+        const Session* s = getSessionAt(i);
+        if (!s) continue;
+        Serial.printf("  Session: %s\n", s->sessionId);
+        Serial.printf("    IP: %s\n", s->ipAddress);
+        Serial.printf("    Game: %s (%s)\n", getGameId(s).c_str(), s->playerColor);
+        Serial.printf("    Active: %s\n", s->gameActive.load() ? "Yes" : "No");
+        unsigned long age = (millis() - s->createdAt) / 1000;
         Serial.printf("    Age: %lu seconds\n", age);
     }
 }
 
 // Get sessions as JSON
 String SessionManager::getSessionsJSON() const {
+    ReadGuard guard(this);
     JsonDocument doc;
     JsonArray sessionsArray = doc["sessions"].to<JsonArray>();
 
-    for (const auto& pair : _sessions) {
-        const Session& s = pair.second;
+    int count = 0;
+    for (int i = 0; i < MAX_SESSIONS; i++) {
+        const Session* s = getSessionAt(i);
+        if (!s) continue;
+        count++;
+
         JsonObject sessionObj = sessionsArray.add<JsonObject>();
-        sessionObj["sessionId"] = s.sessionId;
-        sessionObj["ipAddress"] = s.ipAddress;
-        sessionObj["gameId"] = s.gameId;
-        sessionObj["playerColor"] = s.playerColor;
-        sessionObj["gameActive"] = s.gameActive;
-        sessionObj["loggingEnabled"] = s.loggingEnabled;
-        sessionObj["debugLogEnabled"] = s.debugLogEnabled;
-        sessionObj["messageCount"] = s.messageCount;
-        sessionObj["createdAt"] = s.createdAt;
-        sessionObj["lastActivity"] = s.lastActivity;
+        sessionObj["sessionId"] = s->sessionId;
+        sessionObj["ipAddress"] = s->ipAddress;
+        sessionObj["gameId"] = getGameId(s);
+        sessionObj["playerColor"] = s->playerColor;
+        sessionObj["gameActive"] = s->gameActive.load();
+        sessionObj["loggingEnabled"] = s->loggingEnabled;
+        sessionObj["debugLogEnabled"] = s->debugLogEnabled;
+        sessionObj["messageCount"] = s->messageCount.load();
+        sessionObj["createdAt"] = s->createdAt;
+        sessionObj["lastActivity"] = s->lastActivity.load();
 
         // Calculate session age in seconds
-        unsigned long ageSeconds = (millis() - s.createdAt) / 1000;
+        unsigned long ageSeconds = (millis() - s->createdAt) / 1000;
         sessionObj["ageSeconds"] = ageSeconds;
     }
 
-    doc["count"] = _sessions.size();
+    doc["count"] = count;
     doc["maxSessions"] = MAX_SESSIONS;
 
     String json;
@@ -418,35 +708,38 @@ String SessionManager::getSessionsJSON() const {
 
 // Set logging enabled for a session
 bool SessionManager::setLoggingEnabled(const String& sessionId, bool enabled) {
-    auto it = _sessions.find(sessionId);
-    if (it == _sessions.end()) {
+    ReadGuard guard(this);
+    Session* session = getSession(sessionId);
+    if (!session) {
         return false;
     }
 
-    it->second.loggingEnabled = enabled;
+    session->loggingEnabled = enabled;
     Serial.printf("Session %s: Logging %s\n", sessionId.c_str(), enabled ? "enabled" : "disabled");
     return true;
 }
 
 // Set debug log enabled for a session
 bool SessionManager::setDebugLogEnabled(const String& sessionId, bool enabled) {
-    auto it = _sessions.find(sessionId);
-    if (it == _sessions.end()) {
+    ReadGuard guard(this);
+    Session* session = getSession(sessionId);
+    if (!session) {
         return false;
     }
 
-    it->second.debugLogEnabled = enabled;
+    session->debugLogEnabled = enabled;
     Serial.printf("Session %s: Debug log %s\n", sessionId.c_str(), enabled ? "enabled" : "disabled");
     return true;
 }
 
 // Increment message count for a session
 bool SessionManager::incrementMessageCount(const String& sessionId) {
-    auto it = _sessions.find(sessionId);
-    if (it == _sessions.end()) {
+    ReadGuard guard(this);
+    Session* session = getSession(sessionId);
+    if (!session) {
         return false;
     }
 
-    it->second.messageCount++;
+    session->messageCount++;
     return true;
 }
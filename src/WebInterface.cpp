@@ -1,4 +1,5 @@
 #include "WebInterface.h"
+#include "BoardJson.h"
 #include "GameController.h"
 #include "GeminiAPI.h"
 #include "SessionManager.h"
@@ -11,6 +12,36 @@
 // Global serial log event source
 AsyncEventSource* g_serialLogEventSource = nullptr;
 
+// Binary board format (format=bin): magic, flags, epoch and version (little endian),
+// then 64 piece codes for a full board or a count plus (square, piece) pairs for a delta
+#define BOARD_BINARY_MAGIC 0x42
+#define BOARD_BINARY_FLAG_FULL 0x01
+
+// Engine self-test suite (GET/POST /api/engine/bench). Published perft node
+// counts covering castling, en passant pins and discovered checks, and
+// promotions. Each case runs inside one loop() pass, so depth stays at 3: at most
+// ~100k nodes and 3 move lists (1KB each) on the loop task's stack. The deeper
+// counts run on the host (pio test -e native).
+struct BenchPerftCase {
+  const char* name;
+  const char* fen;
+  int depth;
+  uint64_t expected;
+};
+
+static const BenchPerftCase BENCH_PERFT_SUITE[] = {
+  {"start", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 3, 8902},
+  {"kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 3, 97862},
+  {"enPassant", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 3, 2812},
+  {"promotion", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 3, 9467},
+  {"promotionCheck", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 3, 62379}
+};
+
+// Timed hot paths, reported as ns/op
+static const char* const BENCH_TIMING_NAMES[] = {
+  "generateMoves", "validateMove", "gameResult", "statusJSON", "boardJSON"
+};
+
 WebInterface::WebInterface() {
   server = nullptr;
   gameController = nullptr;
@@ -18,13 +49,19 @@ WebInterface::WebInterface() {
   sessionManager = nullptr;
   boardInitialized = false;
   processingMove = false;
-  isWhiteTurn = true; // White starts
 
-  // Initialize special move flags
-  resetSpecialMoveFlags();
+  // Board versioning - the first noteBoardChange() records the whole start position
+  boardEventSource = nullptr;
+  boardEpoch = 0;
+  boardVersion = 0;
+  memset(lastBoard, 0, sizeof(lastBoard));
+  memset(changeMasks, 0, sizeof(changeMasks));
 
-  // Initialize move history
-  initializeMoveHistory();
+  benchState = BENCH_IDLE;
+  benchStep = 0;
+  benchEngine = nullptr;
+  memset(benchPerft, 0, sizeof(benchPerft));
+  memset(benchTiming, 0, sizeof(benchTiming));
 
   // Initialize chess board to starting position
   initializeBoard();
@@ -38,6 +75,11 @@ void WebInterface::begin(AsyncWebServer* webServer, SessionManager* sessMgr) {
   g_serialLogEventSource = new AsyncEventSource("/api/serial-stream");
   server->addHandler(g_serialLogEventSource);
 
+  // Board delta SSE - clients apply pushed changes, and re-fetch /api/board?since= after a gap
+  boardEventSource = new AsyncEventSource("/api/board/events");
+  server->addHandler(boardEventSource);
+  boardEpoch = (uint32_t)random(1, 0x7FFFFFFF);
+
   // Serve main chess app from SD card with chunked streaming
   server->on("/", HTTP_GET, [this](AsyncWebServerRequest* request) {
     serveFileFromSD(request, HTML_FILE_PATH);
@@ -146,6 +188,22 @@ void WebInterface::begin(AsyncWebServer* webServer, SessionManager* sessMgr) {
     handleGetStatus(request);
   });
 
+  server->on("/api/engine/bench", HTTP_GET, [this](AsyncWebServerRequest* request) {
+    handleGetBench(request);
+  });
+
+  server->on("/api/engine/bench", HTTP_POST, [this](AsyncWebServerRequest* request) {
+    handleStartBench(request);
+  });
+
+  server->on("/api/position", HTTP_GET, [this](AsyncWebServerRequest* request) {
+    handleGetPosition(request);
+  });
+
+  server->on("/api/position", HTTP_PUT, [this](AsyncWebServerRequest* request) {
+    handleSetPosition(request);
+  });
+
   server->on("/api/newgame", HTTP_POST, [this](AsyncWebServerRequest* request) {
     handleNewGame(request);
   });
@@ -253,6 +311,7 @@ void WebInterface::begin(AsyncWebServer* webServer, SessionManager* sessMgr) {
     }
 
     String sessionId = request->getParam("sessionId", true)->value();
+    SessionManager::ReadGuard guard(sessionManager);
     Session* session = sessionManager->getSession(sessionId);
 
     if (!session) {
@@ -280,6 +339,7 @@ void WebInterface::begin(AsyncWebServer* webServer, SessionManager* sessMgr) {
     }
 
     String sessionId = request->getParam("sessionId")->value();
+    SessionManager::ReadGuard guard(sessionManager);
     Session* session = sessionManager->getSession(sessionId);
 
     if (!session) {
@@ -322,6 +382,7 @@ void WebInterface::begin(AsyncWebServer* webServer, SessionManager* sessMgr) {
       return;
     }
 
+    SessionManager::ReadGuard guard(sessionManager);
     Session* session = sessionManager->getSession(sessionId);
 
     if (!session) {
@@ -331,16 +392,16 @@ void WebInterface::begin(AsyncWebServer* webServer, SessionManager* sessMgr) {
     }
 
     // Verify session pointer is valid before modifying
-    if (session->sessionId.isEmpty() || session->sessionId != sessionId) {
+    if (session->sessionId[0] == '\0' || sessionId != session->sessionId) {
       Serial.printf("ERROR: Session pointer validation failed (expected: %s, got: %s)\n",
-                   sessionId.c_str(), session->sessionId.c_str());
+                   sessionId.c_str(), session->sessionId);
       request->send(500, "application/json", "{\"success\":false,\"error\":\"Session validation failed\"}");
       return;
     }
 
     // Safety check: prevent refreshing yourself (could cause issues)
     String requestIP = request->client()->remoteIP().toString();
-    if (session->ipAddress == requestIP) {
+    if (requestIP == session->ipAddress) {
       Serial.printf("WARNING: Admin tried to refresh their own session %s (IP: %s) - ignoring\n",
                    sessionId.c_str(), requestIP.c_str());
       request->send(400, "application/json", "{\"success\":false,\"error\":\"Cannot refresh your own session\"}");
@@ -351,7 +412,7 @@ void WebInterface::begin(AsyncWebServer* webServer, SessionManager* sessMgr) {
     session->pendingRefresh = true;
 
     Serial.printf("Refresh command flagged for session %s (IP: %s)\n",
-                 sessionId.c_str(), session->ipAddress.c_str());
+                 sessionId.c_str(), session->ipAddress);
 
     String json = "{\"success\":true,\"sessionId\":\"" + sessionId + "\"}";
     request->send(200, "application/json", json);
@@ -496,29 +557,89 @@ void WebInterface::begin(AsyncWebServer* webServer, SessionManager* sessMgr) {
 
 void WebInterface::initializeBoard() {
   // Set up starting chess position
-  for (int row = 0; row < 8; row++) {
-    for (int col = 0; col < 8; col++) {
-      currentBoard[row][col] = "";
+  engine.resetGame();
+  boardInitialized = true;
+  noteBoardChange();
+}
+
+// Two-character piece code used by the web client ("wp", "bk", ...), empty for no piece
+String WebInterface::getPieceCode(int row, int col) {
+  return pieceCodeText(engine.getPieceCode(row * 8 + col));
+}
+
+// Compare the engine board with the last versioned copy. Any difference becomes
+// a new version, and its changed squares are pushed to SSE clients.
+void WebInterface::noteBoardChange() {
+  uint64_t changed = 0;
+  for (int square = 0; square < 64; square++) {
+    uint8_t piece = engine.getPieceCode(square);
+    if (piece != lastBoard[square]) {
+      changed |= 1ULL << square;
+      lastBoard[square] = piece;
     }
   }
+  if (!changed) {
+    return;
+  }
+
+  boardVersion++;
+  changeMasks[boardVersion % BOARD_DELTA_HISTORY] = changed;
 
-  // Black pieces (top of board)
-  currentBoard[0][0] = "br"; currentBoard[0][1] = "bn"; currentBoard[0][2] = "bb"; currentBoard[0][3] = "bq";
-  currentBoard[0][4] = "bk"; currentBoard[0][5] = "bb"; currentBoard[0][6] = "bn"; currentBoard[0][7] = "br";
-  for (int col = 0; col < 8; col++) {
-    currentBoard[1][col] = "bp";
+  if (boardEventSource && boardEventSource->count() > 0) {
+    char json[768];
+    buildBoardDeltaJSON(json, sizeof(json), changed);
+    boardEventSource->send(json, "board", boardVersion);
   }
+}
 
-  // White pieces (bottom of board)
-  for (int col = 0; col < 8; col++) {
-    currentBoard[6][col] = "wp";
+// Squares changed after sinceVersion. Sets full when the client is too far
+// behind (or ahead, after a reboot) for a delta to be meaningful.
+uint64_t WebInterface::getChangesSince(uint32_t sinceVersion, bool& full) {
+  full = sinceVersion == 0 || sinceVersion > boardVersion ||
+         boardVersion - sinceVersion > BOARD_DELTA_HISTORY;
+  if (full) {
+    return ~0ULL;
   }
-  currentBoard[7][0] = "wr"; currentBoard[7][1] = "wn"; currentBoard[7][2] = "wb"; currentBoard[7][3] = "wq";
-  currentBoard[7][4] = "wk"; currentBoard[7][5] = "wb"; currentBoard[7][6] = "wn"; currentBoard[7][7] = "wr";
 
-  boardInitialized = true;
-  isWhiteTurn = true; // White always starts
-  resetSpecialMoveFlags();
+  uint64_t changed = 0;
+  for (uint32_t version = sinceVersion + 1; version <= boardVersion; version++) {
+    changed |= changeMasks[version % BOARD_DELTA_HISTORY];
+  }
+  return changed;
+}
+
+size_t WebInterface::buildBoardDeltaJSON(char* buffer, size_t size, uint64_t changed) {
+  return ::buildBoardDeltaJSON(buffer, size, lastBoard, boardEpoch, boardVersion, changed);
+}
+
+void WebInterface::sendBoardBinary(AsyncWebServerRequest* request, bool full, uint64_t changed) {
+  uint8_t data[10 + 1 + 64 * 2];
+  size_t len = 0;
+  data[len++] = BOARD_BINARY_MAGIC;
+  data[len++] = full ? BOARD_BINARY_FLAG_FULL : 0;
+  for (int i = 0; i < 4; i++) data[len++] = (boardEpoch >> (i * 8)) & 0xFF;
+  for (int i = 0; i < 4; i++) data[len++] = (boardVersion >> (i * 8)) & 0xFF;
+
+  if (full) {
+    memcpy(data + len, lastBoard, 64);
+    len += 64;
+  } else {
+    size_t countIndex = len++;
+    uint8_t count = 0;
+    for (int square = 0; square < 64; square++) {
+      if (changed & (1ULL << square)) {
+        data[len++] = square;
+        data[len++] = lastBoard[square];
+        count++;
+      }
+    }
+    data[countIndex] = count;
+  }
+
+  AsyncResponseStream* response = request->beginResponseStream("application/octet-stream");
+  response->write(data, len);
+  response->addHeader("Access-Control-Allow-Origin", "*");
+  request->send(response);
 }
 
 void WebInterface::serveImageFile(AsyncWebServerRequest* request, const char* filename) {
@@ -547,20 +668,7 @@ size_t WebInterface::generateHTMLChunk(uint8_t *buffer, size_t maxLen, size_t in
 // REMOVED: All remaining embedded HTML/CSS content
 
 String WebInterface::generateBoardJSON() {
-  String json = "{\"board\":[";
-
-  for (int row = 0; row < 8; row++) {
-    if (row > 0) json += ",";
-    json += "[";
-    for (int col = 0; col < 8; col++) {
-      if (col > 0) json += ",";
-      json += "\"" + currentBoard[row][col] + "\"";
-    }
-    json += "]";
-  }
-
-  json += "]}";
-  return json;
+  return buildBoardJSON(lastBoard, boardEpoch, boardVersion);
 }
 
 String WebInterface::generateChessBoard() {
@@ -570,7 +678,7 @@ String WebInterface::generateChessBoard() {
     html += "<div class=\"row\">";
     for (int col = 0; col < 8; col++) {
       bool isLight = (row + col) % 2 == 0;
-      String piece = currentBoard[row][col];
+      String piece = getPieceCode(row, col);
       html += "<div class=\"square " + String(isLight ? "light" : "dark") + "\">";
       if (piece.length() > 0) {
         html += "<div class=\"piece\">" + piece + "</div>";
@@ -612,910 +720,385 @@ String WebInterface::getMinimalFallbackHTML() {
 
 // Board state management functions
 
+// GET /api/board[?since=<version>&epoch=<epoch>][&format=bin]
+// Without "since" (or with a stale epoch/version) the whole board is returned,
+// otherwise only the squares changed since that version.
 void WebInterface::handleGetBoard(AsyncWebServerRequest* request) {
-  String boardJson = generateBoardJSON();
-  AsyncWebServerResponse *response = request->beginResponse(200, "application/json", boardJson);
-  response->addHeader("Connection", "close");
-  response->addHeader("Access-Control-Allow-Origin", "*");
-  request->send(response);
-}
-
-void WebInterface::handleGetStatus(AsyncWebServerRequest* request) {
-  String status = "{";
-  status += "\"currentPlayer\":\"" + String(isWhiteTurn ? "White" : "Black") + "\",";
-  status += "\"gameActive\":true,";
-  status += "\"moveCount\":0,";
-  status += "\"status\":\"ready\",";
-
-  // Check if either king is in check
-  bool whiteInCheck = isKingInCheck(true);
-  bool blackInCheck = isKingInCheck(false);
-
-  status += "\"whiteInCheck\":" + String(whiteInCheck ? "true" : "false") + ",";
-  status += "\"blackInCheck\":" + String(blackInCheck ? "true" : "false") + ",";
-
-  // Check for checkmate/stalemate
-  bool whiteCheckmate = false;
-  bool blackCheckmate = false;
-  bool stalemate = false;
-
-  if (!hasLegalMoves(true)) {
-    if (whiteInCheck) {
-      whiteCheckmate = true;
-    } else {
-      stalemate = true;
-    }
-  }
+  // Pick up changes made directly on the shared engine
+  noteBoardChange();
 
-  if (!hasLegalMoves(false)) {
-    if (blackInCheck) {
-      blackCheckmate = true;
-    } else {
-      stalemate = true;
-    }
+  uint32_t sinceVersion = 0;
+  if (request->hasParam("since")) {
+    sinceVersion = strtoul(request->getParam("since")->value().c_str(), nullptr, 10);
   }
-
-  status += "\"whiteCheckmate\":" + String(whiteCheckmate ? "true" : "false") + ",";
-  status += "\"blackCheckmate\":" + String(blackCheckmate ? "true" : "false") + ",";
-  status += "\"stalemate\":" + String(stalemate ? "true" : "false") + ",";
-  status += "\"checkMessage\":\"\"";
-
-  status += "}";
-
-  request->send(200, "application/json", status);
-}
-
-void WebInterface::handleNewGame(AsyncWebServerRequest* request) {
-  initializeBoard();
-  request->send(200, "application/json", "{\"status\":\"new_game_started\"}");
-}
-
-void WebInterface::handleResetGame(AsyncWebServerRequest* request) {
-  initializeBoard();
-  request->send(200, "application/json", "{\"status\":\"game_reset\"}");
-}
-
-void WebInterface::handleUserMove(AsyncWebServerRequest* request) {
-
-  // Check for move parameter
-  if (request->hasParam("move", true)) {
-    String move = request->getParam("move", true)->value();
-
-    // Apply the move to the board
-    if (applyMoveToBoard(move)) {
-
-      // Switch turns
-      isWhiteTurn = !isWhiteTurn;
-
-      request->send(200, "application/json", "{\"status\":\"move_accepted\",\"move\":\"" + move + "\"}");
-
-      // AI move will be triggered by client after animation delay via /api/request-ai-move
-    } else {
-      request->send(400, "application/json", "{\"status\":\"invalid_move\",\"move\":\"" + move + "\"}");
-    }
-  } else {
-    request->send(400, "application/json", "{\"status\":\"missing_move_parameter\"}");
+  if (request->hasParam("epoch") &&
+      strtoul(request->getParam("epoch")->value().c_str(), nullptr, 10) != boardEpoch) {
+    sinceVersion = 0;
   }
-}
 
-void WebInterface::handleRequestAIMove(AsyncWebServerRequest* request) {
+  bool full;
+  uint64_t changed = getChangesSince(sinceVersion, full);
 
-  // Only process AI move if it's AI's turn (black)
-  if (isWhiteTurn) {
-    request->send(400, "application/json", "{\"status\":\"error\",\"message\":\"Not AI turn\"}");
+  if (request->hasParam("format") && request->getParam("format")->value() == "bin") {
+    sendBoardBinary(request, full, changed);
     return;
   }
 
-  // Trigger AI move
-  triggerAIMove();
-
-  // Send success response
-  request->send(200, "application/json", "{\"status\":\"ai_move_triggered\"}");
-}
-
-
-// REMOVED: Duplicate function definitions
-
-// REMOVED: Duplicate getPieceImageName function
-
-// REMOVED: Duplicate initializeBoard function
-
-void WebInterface::setGameController(GameController* controller) {
-  gameController = controller;
-}
-
-void WebInterface::setGeminiAPI(GeminiAPI* api) {
-  geminiAPI = api;
+  String boardJson;
+  if (full) {
+    boardJson = generateBoardJSON();
+  } else {
+    char json[768];
+    buildBoardDeltaJSON(json, sizeof(json), changed);
+    boardJson = json;
+  }
+  AsyncWebServerResponse *response = request->beginResponse(200, "application/json", boardJson);
+  response->addHeader("Connection", "close");
+  response->addHeader("Access-Control-Allow-Origin", "*");
+  request->send(response);
 }
 
-// REMOVED: Floating HTML code
-
-// REMOVED: getIndexHTML() function - all content now served from SD card
-
-// REMOVED: getIndexHTML() function - all content now served from SD card
+// Position snapshot as FEN, serialized straight into a stack buffer
+void WebInterface::handleGetPosition(AsyncWebServerRequest* request) {
+  char fen[CHESS_FEN_MAX];
+  engine.getFEN(fen, sizeof(fen));
 
+  char json[CHESS_FEN_MAX + 48];
+  snprintf(json, sizeof(json), "{\"fen\":\"%s\",\"ply\":%d}", fen, engine.getPly());
 
-void WebInterface::applyMove(const String& move, bool isWhite) {
-  // For v2.0 skeleton, just log the move - actual chess logic will be implemented later
+  AsyncWebServerResponse *response = request->beginResponse(200, "application/json", json);
+  response->addHeader("Connection", "close");
+  response->addHeader("Access-Control-Allow-Origin", "*");
+  request->send(response);
 }
 
-bool WebInterface::applyMoveToBoard(const String& move) {
-  // Parse coordinate move like "e2e4" or "6,4,4,4"
-  int fromRow, fromCol, toRow, toCol;
-
-  if (!parseMove(move, fromRow, fromCol, toRow, toCol)) {
-    return false;
-  }
-
-  // Check if there's a piece at the from position
-  if (currentBoard[fromRow][fromCol] == "") {
-    return false;
-  }
-
-  // Validate the move according to chess rules
-  if (!isValidMove(fromRow, fromCol, toRow, toCol)) {
-    return false;
-  }
-
-  // Check if this move would leave the king in check
-  if (wouldMoveLeaveKingInCheck(fromRow, fromCol, toRow, toCol)) {
-    return false;
-  }
-
-  // Get piece info before moving
-  String piece = currentBoard[fromRow][fromCol];
-  bool isWhite = isPieceWhite(piece);
-
-  // Save board state before white move for undo functionality
-  if (isWhite) {
-    saveCurrentBoardState();
+// Load a position from a "fen" form or query parameter. Clears the move history.
+void WebInterface::handleSetPosition(AsyncWebServerRequest* request) {
+  AsyncWebParameter* param = request->getParam("fen", true);
+  if (!param) {
+    param = request->getParam("fen");
   }
-
-  // If the current player's king is in check, they MUST get out of check
-  if (isKingInCheck(isWhite)) {
-    // Player is in check - they can only make moves that get them out of check
-    // We already validated above that this move doesn't leave king in check
-    // So if king is currently in check and this move doesn't leave king in check,
-    // then this move successfully gets out of check - allow it
-  }
-
-  //            " to " + String(toRow) + "," + String(toCol));
-
-  // Handle special moves
-  char pieceType = getPieceType(piece);
-
-  if (pieceType == 'k' && isCastlingMove(fromRow, fromCol, toRow, toCol)) {
-    // Castling
-    bool kingside = toCol > fromCol;
-    performCastle(isWhite, kingside);
-  } else if (pieceType == 'p' && isEnPassantCapture(fromRow, fromCol, toRow, toCol)) {
-    // En passant
-    performEnPassant(fromRow, fromCol, toRow, toCol);
-  } else if (pieceType == 'p' && isPawnPromotion(fromRow, fromCol, toRow, toCol)) {
-    // Pawn promotion (default to Queen for now - could be enhanced for user choice)
-    currentBoard[toRow][toCol] = piece;
-    currentBoard[fromRow][fromCol] = "";
-    promotePawn(toRow, toCol, 'q', isWhite);
-  } else {
-    // Normal move
-    currentBoard[toRow][toCol] = piece;
-    currentBoard[fromRow][fromCol] = "";
-  }
-
-  // Update special move tracking
-  updateSpecialMoveTracking(fromRow, fromCol, toRow, toCol);
-
-  // Save after-move state for redo functionality (only for white moves)
-  if (isWhite) {
-    saveAfterMoveState();
+  if (!param) {
+    request->send(400, "application/json", "{\"success\":false,\"message\":\"Missing fen parameter\"}");
+    return;
   }
 
-  // Check if this move puts the opponent in check
-  bool opponentInCheck = isKingInCheck(!isWhite);
-
-  if (opponentInCheck) {
-    String checkMsg = !isWhite ? "WHITE KING IN CHECK!" : "BLACK KING IN CHECK!";
+  if (!engine.setFEN(param->value().c_str())) {
+    request->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid FEN\"}");
+    return;
   }
+  noteBoardChange();
 
-  return true;
+  char fen[CHESS_FEN_MAX];
+  engine.getFEN(fen, sizeof(fen));
+  char json[CHESS_FEN_MAX + 32];
+  snprintf(json, sizeof(json), "{\"success\":true,\"fen\":\"%s\"}", fen);
+  request->send(200, "application/json", json);
 }
 
-bool WebInterface::parseMove(const String& move, int& fromRow, int& fromCol, int& toRow, int& toCol) {
-  // Handle coordinate notation like "6,4,4,4" (fromRow,fromCol,toRow,toCol)
-  if (move.indexOf(',') >= 0) {
-    int commaPos1 = move.indexOf(',');
-    int commaPos2 = move.indexOf(',', commaPos1 + 1);
-    int commaPos3 = move.indexOf(',', commaPos2 + 1);
-
-    if (commaPos1 >= 0 && commaPos2 >= 0 && commaPos3 >= 0) {
-      fromRow = move.substring(0, commaPos1).toInt();
-      fromCol = move.substring(commaPos1 + 1, commaPos2).toInt();
-      toRow = move.substring(commaPos2 + 1, commaPos3).toInt();
-      toCol = move.substring(commaPos3 + 1).toInt();
-      return true;
-    }
-  }
-
-  // Handle castling moves
-  if (move == "O-O" || move == "0-0") {
-    // Kingside castling - find the king and move 2 squares right
-    bool isWhite = isWhiteTurn;
-    int kingRow = isWhite ? 7 : 0;
-    fromRow = kingRow;
-    fromCol = 4;
-    toRow = kingRow;
-    toCol = 6;
-    return true;
-  }
-  if (move == "O-O-O" || move == "0-0-0") {
-    // Queenside castling - find the king and move 2 squares left
-    bool isWhite = isWhiteTurn;
-    int kingRow = isWhite ? 7 : 0;
-    fromRow = kingRow;
-    fromCol = 4;
-    toRow = kingRow;
-    toCol = 2;
-    return true;
-  }
-
-  // Handle full algebraic notation like "e2e4"
-  if (move.length() == 4 && move.charAt(0) >= 'a' && move.charAt(0) <= 'h' &&
-      move.charAt(1) >= '1' && move.charAt(1) <= '8') {
-    char fromFile = move.charAt(0);
-    char fromRank = move.charAt(1);
-    char toFile = move.charAt(2);
-    char toRank = move.charAt(3);
-
-    // Convert to board coordinates (a1 = 7,0)
-    fromCol = fromFile - 'a';
-    fromRow = 8 - (fromRank - '0');
-    toCol = toFile - 'a';
-    toRow = 8 - (toRank - '0');
-
-    // Validate coordinates
-    if (fromRow >= 0 && fromRow < 8 && fromCol >= 0 && fromCol < 8 &&
-        toRow >= 0 && toRow < 8 && toCol >= 0 && toCol < 8) {
-      return true;
-    }
-  }
+void WebInterface::handleGetStatus(AsyncWebServerRequest* request) {
+  request->send(200, "application/json", generateStatusJSON());
+}
 
-  // Handle standard algebraic notation like "d5", "Nc6", "Bxf7+"
-  String cleanMove = move;
-  cleanMove.trim();
+String WebInterface::generateStatusJSON() {
+  return buildStatusJSON(engine);
+}
 
-  // Remove check/checkmate indicators
-  if (cleanMove.endsWith("+") || cleanMove.endsWith("#")) {
-    cleanMove = cleanMove.substring(0, cleanMove.length() - 1);
-  }
-
-  // Extract destination square (always the last 2 characters)
-  if (cleanMove.length() >= 2) {
-    String destSquare = cleanMove.substring(cleanMove.length() - 2);
-    if (destSquare.charAt(0) >= 'a' && destSquare.charAt(0) <= 'h' &&
-        destSquare.charAt(1) >= '1' && destSquare.charAt(1) <= '8') {
-
-      toCol = destSquare.charAt(0) - 'a';
-      toRow = 8 - (destSquare.charAt(1) - '0');
-
-      // For simple pawn moves like "d5", "e6"
-      if (cleanMove.length() == 2) {
-        // Look for a pawn that can move to this square
-        for (int r = 0; r < 8; r++) {
-          for (int c = 0; c < 8; c++) {
-            String piece = currentBoard[r][c];
-            if (!piece.isEmpty() && isPieceWhite(piece) == isWhiteTurn && getPieceType(piece) == 'p') {
-              if (isPawnMoveValid(r, c, toRow, toCol, isPieceWhite(piece))) {
-                fromRow = r;
-                fromCol = c;
-                return true;
-              }
-            }
-          }
-        }
-      }
+// ========================================
+// Engine benchmark
+// ========================================
 
-      // For piece moves like "Nc6", "Bb5"
-      if (cleanMove.length() >= 3) {
-        char pieceType = tolower(cleanMove.charAt(0));
-        if (pieceType == 'n' || pieceType == 'b' || pieceType == 'r' ||
-            pieceType == 'q' || pieceType == 'k') {
-
-          // Look for the piece that can move to this square
-          for (int r = 0; r < 8; r++) {
-            for (int c = 0; c < 8; c++) {
-              String piece = currentBoard[r][c];
-              if (!piece.isEmpty() && isPieceWhite(piece) == isWhiteTurn &&
-                  tolower(getPieceType(piece)) == pieceType) {
-                if (isValidMove(r, c, toRow, toCol)) {
-                  fromRow = r;
-                  fromCol = c;
-                  return true;
-                }
-              }
-            }
-          }
-        }
-      }
-    }
+// POST /api/engine/bench - queue a run; the results fill in as loop() works through it
+void WebInterface::handleStartBench(AsyncWebServerRequest* request) {
+  if (benchState == BENCH_PENDING || benchState == BENCH_RUNNING) {
+    request->send(409, "application/json", "{\"success\":false,\"message\":\"Benchmark already running\"}");
+    return;
   }
 
-  return false;
+  memset(benchPerft, 0, sizeof(benchPerft));
+  memset(benchTiming, 0, sizeof(benchTiming));
+  benchStep = 0;
+  benchState = BENCH_PENDING;
+  request->send(202, "application/json", "{\"success\":true,\"state\":\"pending\"}");
 }
 
-// Chess rule validation helper functions
+// GET /api/engine/bench - progress and results of the last run
+void WebInterface::handleGetBench(AsyncWebServerRequest* request) {
+  static const char* const STATE_NAMES[] = {"idle", "pending", "running", "done"};
 
-bool WebInterface::isValidMove(int fromRow, int fromCol, int toRow, int toCol) {
-  // Check bounds
-  if (fromRow < 0 || fromRow >= 8 || fromCol < 0 || fromCol >= 8 ||
-      toRow < 0 || toRow >= 8 || toCol < 0 || toCol >= 8) {
-    return false;
-  }
+  char json[1536];
+  size_t len = snprintf(json, sizeof(json), "{\"state\":\"%s\",\"step\":%d,\"steps\":%d,\"perft\":[",
+                        STATE_NAMES[benchState], benchStep, BENCH_PERFT_CASES + BENCH_TIMING_CASES);
 
-  // Can't move to same position
-  if (fromRow == toRow && fromCol == toCol) {
-    return false;
+  bool passed = true;
+  int completed = benchState == BENCH_DONE ? BENCH_PERFT_CASES + BENCH_TIMING_CASES : benchStep;
+  for (int i = 0; i < BENCH_PERFT_CASES && i < completed; i++) {
+    const BenchPerftCase& test = BENCH_PERFT_SUITE[i];
+    const BenchPerftResult& result = benchPerft[i];
+    bool ok = result.nodes == test.expected;
+    passed = passed && ok;
+    uint32_t nodesPerSec = result.elapsedUs ? (uint32_t)(result.nodes * 1000000ULL / result.elapsedUs) : 0;
+    len += snprintf(json + len, sizeof(json) - len,
+                    "%s{\"name\":\"%s\",\"depth\":%d,\"nodes\":%llu,\"expected\":%llu,\"ok\":%s,\"ms\":%lu,\"nps\":%lu}",
+                    i > 0 ? "," : "", test.name, test.depth, (unsigned long long)result.nodes,
+                    (unsigned long long)test.expected, ok ? "true" : "false",
+                    (unsigned long)(result.elapsedUs / 1000), (unsigned long)nodesPerSec);
   }
 
-  String movingPiece = currentBoard[fromRow][fromCol];
-  String targetPiece = currentBoard[toRow][toCol];
-
-  // Can't capture own piece
-  if (!targetPiece.isEmpty() && isPieceWhite(movingPiece) == isPieceWhite(targetPiece)) {
-    return false;
+  len += snprintf(json + len, sizeof(json) - len, "],\"timing\":[");
+  for (int i = 0; i < BENCH_TIMING_CASES && BENCH_PERFT_CASES + i < completed; i++) {
+    const BenchTimingResult& result = benchTiming[i];
+    uint32_t nsPerOp = result.iterations ? (uint32_t)((uint64_t)result.elapsedUs * 1000 / result.iterations) : 0;
+    len += snprintf(json + len, sizeof(json) - len, "%s{\"name\":\"%s\",\"iterations\":%lu,\"nsPerOp\":%lu}",
+                    i > 0 ? "," : "", BENCH_TIMING_NAMES[i], (unsigned long)result.iterations,
+                    (unsigned long)nsPerOp);
   }
 
-  char pieceType = getPieceType(movingPiece);
-  bool isWhite = isPieceWhite(movingPiece);
-
-  // Check for special moves first
-  if (pieceType == 'k' && isCastlingMove(fromRow, fromCol, toRow, toCol)) {
-    bool kingside = toCol > fromCol;
-    return canCastle(isWhite, kingside);
-  }
+  snprintf(json + len, sizeof(json) - len, "],\"passed\":%s,\"freeHeap\":%lu}",
+           passed ? "true" : "false", (unsigned long)ESP.getFreeHeap());
 
-  if (pieceType == 'p' && isEnPassantCapture(fromRow, fromCol, toRow, toCol)) {
-    return true;
-  }
-
-  // Check piece-specific movement rules
-  switch (pieceType) {
-    case 'p': return isPawnMoveValid(fromRow, fromCol, toRow, toCol, isWhite);
-    case 'r': return isRookMoveValid(fromRow, fromCol, toRow, toCol);
-    case 'b': return isBishopMoveValid(fromRow, fromCol, toRow, toCol);
-    case 'n': return isKnightMoveValid(fromRow, fromCol, toRow, toCol);
-    case 'q': return isQueenMoveValid(fromRow, fromCol, toRow, toCol);
-    case 'k': return isKingMoveValid(fromRow, fromCol, toRow, toCol);
-    default: return false;
-  }
+  AsyncWebServerResponse *response = request->beginResponse(200, "application/json", json);
+  response->addHeader("Cache-Control", "no-store");
+  request->send(response);
 }
 
-bool WebInterface::isPawnMoveValid(int fromRow, int fromCol, int toRow, int toCol, bool isWhite) {
-  int direction = isWhite ? -1 : 1; // White moves up (decreasing row), black moves down
-  int startRow = isWhite ? 6 : 1;   // Starting row for pawns
-
-  // Forward movement
-  if (fromCol == toCol) {
-    // Must be empty square ahead
-    if (!currentBoard[toRow][toCol].isEmpty()) {
-      return false;
-    }
-
-    // One square forward
-    if (toRow == fromRow + direction) {
-      return true;
-    }
-
-    // Two squares forward from starting position
-    if (fromRow == startRow && toRow == fromRow + 2 * direction) {
-      return true;
-    }
-
-    return false;
-  }
-
-  // Diagonal capture
-  if (abs(fromCol - toCol) == 1 && toRow == fromRow + direction) {
-    // Must be an enemy piece to capture
-    return !currentBoard[toRow][toCol].isEmpty() &&
-           isPieceWhite(currentBoard[toRow][toCol]) != isWhite;
+void WebInterface::processBenchmark() {
+  if (benchState == BENCH_PENDING) {
+    // Private engine so perft never disturbs the game being played
+    benchEngine = new ChessEngine();
+    benchEngine->begin();
+    benchState = BENCH_RUNNING;
+    Serial.println("Engine benchmark started");
+    return;
   }
+  if (benchState != BENCH_RUNNING) return;
 
-  return false;
-}
-
-bool WebInterface::isRookMoveValid(int fromRow, int fromCol, int toRow, int toCol) {
-  // Rook moves horizontally or vertically
-  if (fromRow != toRow && fromCol != toCol) {
-    return false;
+  if (benchStep < BENCH_PERFT_CASES) {
+    runBenchPerft(benchStep);
+  } else {
+    runBenchTiming(benchStep - BENCH_PERFT_CASES);
   }
+  benchStep++;
 
-  // Check if path is clear
-  return isPathClear(fromRow, fromCol, toRow, toCol);
-}
-
-bool WebInterface::isBishopMoveValid(int fromRow, int fromCol, int toRow, int toCol) {
-  // Bishop moves diagonally
-  if (abs(fromRow - toRow) != abs(fromCol - toCol)) {
-    return false;
+  if (benchStep >= BENCH_PERFT_CASES + BENCH_TIMING_CASES) {
+    delete benchEngine;
+    benchEngine = nullptr;
+    benchState = BENCH_DONE;
+    Serial.println("Engine benchmark finished");
   }
-
-  // Check if path is clear
-  return isPathClear(fromRow, fromCol, toRow, toCol);
 }
 
-bool WebInterface::isKnightMoveValid(int fromRow, int fromCol, int toRow, int toCol) {
-  int rowDiff = abs(fromRow - toRow);
-  int colDiff = abs(fromCol - toCol);
+void WebInterface::runBenchPerft(int index) {
+  const BenchPerftCase& test = BENCH_PERFT_SUITE[index];
+  benchEngine->setFEN(test.fen);
 
-  // Knight moves in L-shape: 2+1 or 1+2
-  return (rowDiff == 2 && colDiff == 1) || (rowDiff == 1 && colDiff == 2);
-}
-
-bool WebInterface::isQueenMoveValid(int fromRow, int fromCol, int toRow, int toCol) {
-  // Queen combines rook and bishop movement
-  return isRookMoveValid(fromRow, fromCol, toRow, toCol) ||
-         isBishopMoveValid(fromRow, fromCol, toRow, toCol);
-}
+  unsigned long start = micros();
+  uint64_t nodes = benchEngine->perft(test.depth);
+  benchPerft[index].elapsedUs = micros() - start;
+  benchPerft[index].nodes = nodes;
 
-bool WebInterface::isKingMoveValid(int fromRow, int fromCol, int toRow, int toCol) {
-  int rowDiff = abs(fromRow - toRow);
-  int colDiff = abs(fromCol - toCol);
-
-  // King moves one square in any direction
-  return rowDiff <= 1 && colDiff <= 1;
+  Serial.printf("Perft %s depth %d: %llu nodes (expected %llu) %s in %lu ms\n", test.name, test.depth,
+                (unsigned long long)nodes, (unsigned long long)test.expected,
+                nodes == test.expected ? "OK" : "MISMATCH", (unsigned long)(benchPerft[index].elapsedUs / 1000));
 }
 
-bool WebInterface::isPathClear(int fromRow, int fromCol, int toRow, int toCol) {
-  int rowStep = (toRow > fromRow) ? 1 : (toRow < fromRow) ? -1 : 0;
-  int colStep = (toCol > fromCol) ? 1 : (toCol < fromCol) ? -1 : 0;
-
-  int checkRow = fromRow + rowStep;
-  int checkCol = fromCol + colStep;
-
-  // Check each square along the path (excluding destination)
-  while (checkRow != toRow || checkCol != toCol) {
-    if (!currentBoard[checkRow][checkCol].isEmpty()) {
-      return false; // Path is blocked
-    }
-    checkRow += rowStep;
-    checkCol += colStep;
-  }
-
-  return true;
-}
+// Engine paths run on Kiwipete (48 legal moves, every move type available);
+// the JSON builders run on the live board exactly as the handlers call them
+void WebInterface::runBenchTiming(int index) {
+  benchEngine->setFEN(BENCH_PERFT_SUITE[1].fen);
+  Move moves[CHESS_MAX_MOVES];
+  int count = benchEngine->generateLegalMoves(moves);
 
-bool WebInterface::isPieceWhite(const String& piece) {
-  if (piece.isEmpty()) return false;
-  return piece.charAt(0) == 'w';
-}
-
-char WebInterface::getPieceType(const String& piece) {
-  if (piece.isEmpty()) return ' ';
-  return piece.charAt(1);
-}
-
-// Check detection functions
-
-bool WebInterface::hasLegalMoves(bool isWhite) {
-  // Check if the player has any legal moves
-  for (int fromR = 0; fromR < 8; fromR++) {
-    for (int fromC = 0; fromC < 8; fromC++) {
-      String piece = currentBoard[fromR][fromC];
-      if (piece.isEmpty() || isPieceWhite(piece) != isWhite) {
-        continue; // Not our piece
+  uint32_t iterations = 0;
+  unsigned long start = micros();
+  switch (index) {
+    case 0:
+      for (iterations = 0; iterations < 500; iterations++) {
+        benchEngine->generateLegalMoves(moves);
       }
-
-      // Check all possible destination squares
-      for (int toR = 0; toR < 8; toR++) {
-        for (int toC = 0; toC < 8; toC++) {
-          if (isValidMove(fromR, fromC, toR, toC) &&
-              !wouldMoveLeaveKingInCheck(fromR, fromC, toR, toC)) {
-            return true; // Found a legal move
-          }
+      break;
+
+    case 1: {
+      // Text in, legal move out - the path every submitted move takes
+      char uci[CHESS_UCI_MAX];
+      Move legal;
+      for (int round = 0; round < 20; round++) {
+        for (int i = 0; i < count; i++) {
+          ChessEngine::formatUCI(moves[i], uci, sizeof(uci));
+          benchEngine->findLegalMove(benchEngine->parseMove(uci), legal);
+          iterations++;
         }
       }
+      break;
     }
-  }
-  return false; // No legal moves found
-}
-
-bool WebInterface::isKingInCheck(bool isWhiteKing) {
-  int kingRow, kingCol;
-  findKing(isWhiteKing, kingRow, kingCol);
-
-  if (kingRow == -1 || kingCol == -1) {
-    return false; // King not found (shouldn't happen)
-  }
 
-  return isSquareAttackedBy(kingRow, kingCol, !isWhiteKing);
-}
-
-bool WebInterface::wouldMoveLeaveKingInCheck(int fromRow, int fromCol, int toRow, int toCol) {
-  // Make a temporary move
-  String movingPiece = currentBoard[fromRow][fromCol];
-  String capturedPiece = currentBoard[toRow][toCol];
-  bool isWhite = isPieceWhite(movingPiece);
-
-  // Apply the move temporarily
-  currentBoard[toRow][toCol] = movingPiece;
-  currentBoard[fromRow][fromCol] = "";
-
-  // Check if our king would be in check after this move
-  bool wouldBeInCheck = isKingInCheck(isWhite);
-
-  // Restore the board
-  currentBoard[fromRow][fromCol] = movingPiece;
-  currentBoard[toRow][toCol] = capturedPiece;
-
-  return wouldBeInCheck;
-}
-
-bool WebInterface::isSquareAttackedBy(int row, int col, bool byWhite) {
-  // Check all squares for enemy pieces that can attack this square
-  for (int r = 0; r < 8; r++) {
-    for (int c = 0; c < 8; c++) {
-      String piece = currentBoard[r][c];
-      if (!piece.isEmpty() && isPieceWhite(piece) == byWhite) {
-        if (canPieceAttackSquare(r, c, row, col)) {
-          return true;
-        }
+    case 2:
+      for (iterations = 0; iterations < 500; iterations++) {
+        benchEngine->getGameResult();
       }
-    }
-  }
-  return false;
-}
+      break;
 
-void WebInterface::findKing(bool isWhite, int& kingRow, int& kingCol) {
-  String targetKing = isWhite ? "wk" : "bk";
+    case 3:
+      for (iterations = 0; iterations < 100; iterations++) {
+        generateStatusJSON();
+      }
+      break;
 
-  for (int r = 0; r < 8; r++) {
-    for (int c = 0; c < 8; c++) {
-      if (currentBoard[r][c] == targetKing) {
-        kingRow = r;
-        kingCol = c;
-        return;
+    case 4:
+      for (iterations = 0; iterations < 100; iterations++) {
+        generateBoardJSON();
       }
-    }
+      break;
   }
+  benchTiming[index].elapsedUs = micros() - start;
+  benchTiming[index].iterations = iterations;
 
-  // King not found
-  kingRow = -1;
-  kingCol = -1;
+  Serial.printf("Bench %s: %lu ns/op over %lu iterations\n", BENCH_TIMING_NAMES[index],
+                (unsigned long)((uint64_t)benchTiming[index].elapsedUs * 1000 / (iterations ? iterations : 1)),
+                (unsigned long)iterations);
 }
 
-bool WebInterface::canPieceAttackSquare(int pieceRow, int pieceCol, int targetRow, int targetCol) {
-  String piece = currentBoard[pieceRow][pieceCol];
-  if (piece.isEmpty()) return false;
-
-  char pieceType = getPieceType(piece);
-  bool isWhite = isPieceWhite(piece);
-
-  // Check if piece can attack the target square based on its movement rules
-  switch (pieceType) {
-    case 'p': // Pawn attacks diagonally
-      {
-        int direction = isWhite ? -1 : 1;
-        return (targetRow == pieceRow + direction) &&
-               (abs(targetCol - pieceCol) == 1);
-      }
-    case 'r': // Rook
-      return isRookMoveValid(pieceRow, pieceCol, targetRow, targetCol);
-    case 'b': // Bishop
-      return isBishopMoveValid(pieceRow, pieceCol, targetRow, targetCol);
-    case 'n': // Knight
-      return isKnightMoveValid(pieceRow, pieceCol, targetRow, targetCol);
-    case 'q': // Queen
-      return isQueenMoveValid(pieceRow, pieceCol, targetRow, targetCol);
-    case 'k': // King
-      return isKingMoveValid(pieceRow, pieceCol, targetRow, targetCol);
-    default:
-      return false;
-  }
+void WebInterface::handleNewGame(AsyncWebServerRequest* request) {
+  initializeBoard();
+  request->send(200, "application/json", "{\"status\":\"new_game_started\"}");
 }
 
-// Special move implementations
-
-void WebInterface::resetSpecialMoveFlags() {
-  whiteKingMoved = false;
-  blackKingMoved = false;
-  whiteKingsideRookMoved = false;
-  whiteQueensideRookMoved = false;
-  blackKingsideRookMoved = false;
-  blackQueensideRookMoved = false;
-  enPassantColumn = -1;
-  enPassantIsWhite = false;
+void WebInterface::handleResetGame(AsyncWebServerRequest* request) {
+  initializeBoard();
+  request->send(200, "application/json", "{\"status\":\"game_reset\"}");
 }
 
-bool WebInterface::isCastlingMove(int fromRow, int fromCol, int toRow, int toCol) {
-  // Check if it's a king move of 2 squares horizontally
-  if (fromRow != toRow || abs(fromCol - toCol) != 2) {
-    return false;
-  }
-
-  String piece = currentBoard[fromRow][fromCol];
-  char pieceType = getPieceType(piece);
+void WebInterface::handleUserMove(AsyncWebServerRequest* request) {
 
-  return pieceType == 'k';
-}
+  // Check for move parameter
+  if (request->hasParam("move", true)) {
+    String move = request->getParam("move", true)->value();
 
-bool WebInterface::canCastle(bool isWhite, bool kingside) {
-  int kingRow = isWhite ? 7 : 0;
-  int rookCol = kingside ? 7 : 0;
+    // Apply the move to the board
+    String san;
+    if (applyMoveToBoard(move, &san)) {
+      request->send(200, "application/json", "{\"status\":\"move_accepted\",\"move\":\"" + move + "\",\"san\":\"" + san + "\"}");
 
-  // Check if king or rook has moved
-  if (isWhite) {
-    if (whiteKingMoved || (kingside ? whiteKingsideRookMoved : whiteQueensideRookMoved)) {
-      return false;
+      // AI move will be triggered by client after animation delay via /api/request-ai-move
+    } else {
+      request->send(400, "application/json", "{\"status\":\"invalid_move\",\"move\":\"" + move + "\"}");
     }
   } else {
-    if (blackKingMoved || (kingside ? blackKingsideRookMoved : blackQueensideRookMoved)) {
-      return false;
-    }
-  }
-
-  // Check if king is in check
-  if (isKingInCheck(isWhite)) {
-    return false;
-  }
-
-  // Check if squares between king and rook are empty
-  int startCol = kingside ? 5 : 1;
-  int endCol = kingside ? 6 : 3;
-
-  for (int col = startCol; col <= endCol; col++) {
-    if (!currentBoard[kingRow][col].isEmpty()) {
-      return false;
-    }
-  }
-
-  // Check if king would pass through or land on attacked squares
-  int kingDestCol = kingside ? 6 : 2;
-  if (isSquareAttackedBy(kingRow, 5, !isWhite) ||
-      isSquareAttackedBy(kingRow, kingDestCol, !isWhite)) {
-    return false;
+    request->send(400, "application/json", "{\"status\":\"missing_move_parameter\"}");
   }
-
-  return true;
 }
 
-void WebInterface::performCastle(bool isWhite, bool kingside) {
-  int row = isWhite ? 7 : 0;
-  int rookFromCol = kingside ? 7 : 0;
-  int rookToCol = kingside ? 5 : 3;
-  int kingToCol = kingside ? 6 : 2;
+void WebInterface::handleRequestAIMove(AsyncWebServerRequest* request) {
 
-  String king = currentBoard[row][4];
-  String rook = currentBoard[row][rookFromCol];
+  // Only process AI move if it's AI's turn (black)
+  if (engine.getCurrentPlayer() == WHITE) {
+    request->send(400, "application/json", "{\"status\":\"error\",\"message\":\"Not AI turn\"}");
+    return;
+  }
 
-  // Move pieces
-  currentBoard[row][kingToCol] = king;
-  currentBoard[row][rookToCol] = rook;
-  currentBoard[row][4] = "";
-  currentBoard[row][rookFromCol] = "";
+  // Trigger AI move
+  triggerAIMove();
 
-  //             " " + String(kingside ? "kingside" : "queenside"));
+  // Send success response
+  request->send(200, "application/json", "{\"status\":\"ai_move_triggered\"}");
 }
 
-bool WebInterface::isEnPassantCapture(int fromRow, int fromCol, int toRow, int toCol) {
-  String piece = currentBoard[fromRow][fromCol];
-  char pieceType = getPieceType(piece);
-  bool isWhite = isPieceWhite(piece);
 
-  // Must be a pawn
-  if (pieceType != 'p') {
-    return false;
-  }
-
-  // Must be diagonal move
-  if (abs(fromCol - toCol) != 1 || abs(fromRow - toRow) != 1) {
-    return false;
-  }
+// REMOVED: Duplicate function definitions
 
-  // Destination must be empty
-  if (!currentBoard[toRow][toCol].isEmpty()) {
-    return false;
-  }
+// REMOVED: Duplicate getPieceImageName function
 
-  // Must be capturing en passant pawn
-  if (enPassantColumn == toCol && enPassantIsWhite != isWhite) {
-    int capturedPawnRow = isWhite ? 3 : 4;
-    if (fromRow == capturedPawnRow && toRow == (isWhite ? 2 : 5)) {
-      return true;
-    }
-  }
+// REMOVED: Duplicate initializeBoard function
 
-  return false;
+void WebInterface::setGameController(GameController* controller) {
+  gameController = controller;
 }
 
-void WebInterface::performEnPassant(int fromRow, int fromCol, int toRow, int toCol) {
-  String piece = currentBoard[fromRow][fromCol];
-  bool isWhite = isPieceWhite(piece);
-  int capturedPawnRow = isWhite ? 3 : 4;
-
-  // Move pawn
-  currentBoard[toRow][toCol] = piece;
-  currentBoard[fromRow][fromCol] = "";
-
-  // Remove captured pawn
-  currentBoard[capturedPawnRow][toCol] = "";
-
+void WebInterface::setGeminiAPI(GeminiAPI* api) {
+  geminiAPI = api;
 }
 
-bool WebInterface::isPawnPromotion(int fromRow, int fromCol, int toRow, int toCol) {
-  String piece = currentBoard[fromRow][fromCol];
-  char pieceType = getPieceType(piece);
-  bool isWhite = isPieceWhite(piece);
+// REMOVED: Floating HTML code
 
-  // Must be a pawn
-  if (pieceType != 'p') {
-    return false;
-  }
+// REMOVED: getIndexHTML() function - all content now served from SD card
 
-  // Must reach promotion rank
-  int promotionRank = isWhite ? 0 : 7;
-  return toRow == promotionRank;
-}
+// REMOVED: getIndexHTML() function - all content now served from SD card
 
-void WebInterface::promotePawn(int row, int col, char promoteTo, bool isWhite) {
-  String newPiece = String(isWhite ? 'w' : 'b') + String(promoteTo);
-  currentBoard[row][col] = newPiece;
 
+void WebInterface::applyMove(const String& move, bool isWhite) {
+  // Board state lives in the shared engine - callers that play moves on it
+  // directly (GameController) only need the change versioned and pushed
+  noteBoardChange();
 }
 
-void WebInterface::updateSpecialMoveTracking(int fromRow, int fromCol, int toRow, int toCol) {
-  String piece = currentBoard[toRow][toCol];
-  char pieceType = getPieceType(piece);
-  bool isWhite = isPieceWhite(piece);
-
-  // Track king moves
-  if (pieceType == 'k') {
-    if (isWhite) {
-      whiteKingMoved = true;
-    } else {
-      blackKingMoved = true;
-    }
+bool WebInterface::applyMoveToBoard(const String& move, String* san) {
+  // Parse coordinate move like "e2e4", "6,4,4,4" or SAN like "Nf3"
+  Move parsed;
+  if (!parseMove(move, parsed)) {
+    return false;
   }
 
-  // Track rook moves
-  if (pieceType == 'r') {
-    if (isWhite) {
-      if (fromRow == 7 && fromCol == 0) whiteQueensideRookMoved = true;
-      if (fromRow == 7 && fromCol == 7) whiteKingsideRookMoved = true;
-    } else {
-      if (fromRow == 0 && fromCol == 0) blackQueensideRookMoved = true;
-      if (fromRow == 0 && fromCol == 7) blackKingsideRookMoved = true;
+  // SAN has to be formatted before the move changes the position
+  if (san) {
+    char sanText[CHESS_SAN_MAX];
+    if (!engine.formatSAN(parsed, sanText, sizeof(sanText))) {
+      return false;
     }
+    *san = sanText;
   }
 
-  // Reset en passant flag
-  enPassantColumn = -1;
-
-  // Set en passant flag for pawn double moves
-  if (pieceType == 'p' && abs(fromRow - toRow) == 2) {
-    enPassantColumn = fromCol;
-    enPassantIsWhite = !isWhite; // Opponent can capture en passant
+  // The engine rejects moves that break the rules or leave the king in check
+  // and promotes to a queen unless another piece was requested
+  if (!engine.playMove(parsed)) {
+    return false;
   }
+  noteBoardChange();
+  return true;
 }
 
-// Move history implementation
-
-void WebInterface::initializeMoveHistory() {
-  historyCount = 0;
-  currentHistoryIndex = -1;
-}
-
-void WebInterface::saveCurrentBoardState() {
-  // When undo/redo operations happen, don't create new entries
-  if (currentHistoryIndex < historyCount - 1) {
-    // We're in the middle of history, truncate future moves
-    historyCount = currentHistoryIndex + 1;
-  }
-
-  // Only save if we have space or shift history
-  if (historyCount < 20) {
-    currentHistoryIndex = historyCount;
-  } else {
-    // Shift history array left
-    for (int i = 0; i < 19; i++) {
-      moveHistory[i] = moveHistory[i + 1];
-    }
-    currentHistoryIndex = 19;
-    historyCount = 20;
-  }
+bool WebInterface::parseMove(const String& move, Move& parsed) {
+  String cleanMove = move;
+  cleanMove.trim();
 
-  // Save current board state as "before" state
-  for (int row = 0; row < 8; row++) {
-    for (int col = 0; col < 8; col++) {
-      moveHistory[currentHistoryIndex].beforeState[row][col] = currentBoard[row][col];
-    }
+  // Coordinate notation "6,4,4,4" (fromRow,fromCol,toRow,toCol) and UCI "e2e4", "e7e8n"
+  parsed = engine.parseMove(cleanMove.c_str());
+  if (parsed.isValid()) {
+    return true;
   }
 
-  // Save current special move flags as "before" state
-  moveHistory[currentHistoryIndex].beforeWhiteKingMoved = whiteKingMoved;
-  moveHistory[currentHistoryIndex].beforeBlackKingMoved = blackKingMoved;
-  moveHistory[currentHistoryIndex].beforeWhiteKingsideRookMoved = whiteKingsideRookMoved;
-  moveHistory[currentHistoryIndex].beforeWhiteQueensideRookMoved = whiteQueensideRookMoved;
-  moveHistory[currentHistoryIndex].beforeBlackKingsideRookMoved = blackKingsideRookMoved;
-  moveHistory[currentHistoryIndex].beforeBlackQueensideRookMoved = blackQueensideRookMoved;
-  moveHistory[currentHistoryIndex].beforeEnPassantColumn = enPassantColumn;
-  moveHistory[currentHistoryIndex].beforeEnPassantIsWhite = enPassantIsWhite;
-
+  // Standard algebraic notation like "d5", "Nbd7", "exd8=N+", "O-O"
+  parsed = engine.parseSAN(cleanMove.c_str());
+  return parsed.isValid();
 }
 
-void WebInterface::saveAfterMoveState() {
-  // Save current board state as "after" state for the current move
-  for (int row = 0; row < 8; row++) {
-    for (int col = 0; col < 8; col++) {
-      moveHistory[currentHistoryIndex].afterState[row][col] = currentBoard[row][col];
-    }
-  }
-
-  // Save current special move flags as "after" state
-  moveHistory[currentHistoryIndex].afterWhiteKingMoved = whiteKingMoved;
-  moveHistory[currentHistoryIndex].afterBlackKingMoved = blackKingMoved;
-  moveHistory[currentHistoryIndex].afterWhiteKingsideRookMoved = whiteKingsideRookMoved;
-  moveHistory[currentHistoryIndex].afterWhiteQueensideRookMoved = whiteQueensideRookMoved;
-  moveHistory[currentHistoryIndex].afterBlackKingsideRookMoved = blackKingsideRookMoved;
-  moveHistory[currentHistoryIndex].afterBlackQueensideRookMoved = blackQueensideRookMoved;
-  moveHistory[currentHistoryIndex].afterEnPassantColumn = enPassantColumn;
-  moveHistory[currentHistoryIndex].afterEnPassantIsWhite = enPassantIsWhite;
-
-  // Increment history count after completing the move
-  historyCount = currentHistoryIndex + 1;
-
-}
+// Move history - undo/redo steps by whole turns of the human (white) player
 
 bool WebInterface::undoLastWhiteMove() {
-  if (currentHistoryIndex >= 0 && currentHistoryIndex < historyCount) {
-    // Restore board state to "before" state
-    for (int row = 0; row < 8; row++) {
-      for (int col = 0; col < 8; col++) {
-        currentBoard[row][col] = moveHistory[currentHistoryIndex].beforeState[row][col];
-      }
-    }
+  if (engine.getUndoDepth() == 0) {
+    return false;
+  }
 
-    // Restore special move flags to "before" state
-    whiteKingMoved = moveHistory[currentHistoryIndex].beforeWhiteKingMoved;
-    blackKingMoved = moveHistory[currentHistoryIndex].beforeBlackKingMoved;
-    whiteKingsideRookMoved = moveHistory[currentHistoryIndex].beforeWhiteKingsideRookMoved;
-    whiteQueensideRookMoved = moveHistory[currentHistoryIndex].beforeWhiteQueensideRookMoved;
-    blackKingsideRookMoved = moveHistory[currentHistoryIndex].beforeBlackKingsideRookMoved;
-    blackQueensideRookMoved = moveHistory[currentHistoryIndex].beforeBlackQueensideRookMoved;
-    enPassantColumn = moveHistory[currentHistoryIndex].beforeEnPassantColumn;
-    enPassantIsWhite = moveHistory[currentHistoryIndex].beforeEnPassantIsWhite;
-
-    currentHistoryIndex--;
-    return true;
+  // Undo plies until the last white move is reversed (taking back the AI reply too)
+  while (engine.undoMove() && engine.getCurrentPlayer() != WHITE) {
   }
 
-  return false;
+  noteBoardChange();
+  return true;
 }
 
 bool WebInterface::redoLastWhiteMove() {
-  if (currentHistoryIndex + 1 < historyCount) {
-    currentHistoryIndex++;
-
-    // Restore board state to "after" state
-    for (int row = 0; row < 8; row++) {
-      for (int col = 0; col < 8; col++) {
-        currentBoard[row][col] = moveHistory[currentHistoryIndex].afterState[row][col];
-      }
-    }
-
-    // Restore special move flags to "after" state
-    whiteKingMoved = moveHistory[currentHistoryIndex].afterWhiteKingMoved;
-    blackKingMoved = moveHistory[currentHistoryIndex].afterBlackKingMoved;
-    whiteKingsideRookMoved = moveHistory[currentHistoryIndex].afterWhiteKingsideRookMoved;
-    whiteQueensideRookMoved = moveHistory[currentHistoryIndex].afterWhiteQueensideRookMoved;
-    blackKingsideRookMoved = moveHistory[currentHistoryIndex].afterBlackKingsideRookMoved;
-    blackQueensideRookMoved = moveHistory[currentHistoryIndex].afterBlackQueensideRookMoved;
-    enPassantColumn = moveHistory[currentHistoryIndex].afterEnPassantColumn;
-    enPassantIsWhite = moveHistory[currentHistoryIndex].afterEnPassantIsWhite;
+  if (engine.getRedoDepth() == 0) {
+    return false;
+  }
 
-    return true;
+  // Redo the next white move plus the reply that followed it, if one was recorded
+  engine.redoMove();
+  if (engine.getCurrentPlayer() == BLACK) {
+    engine.redoMove();
   }
 
-  return false;
+  noteBoardChange();
+  return true;
 }
 
 void WebInterface::handleUndoMove(AsyncWebServerRequest* request) {
@@ -1567,7 +1150,6 @@ void WebInterface::triggerAIMove() {
   bool moveApplied = false;
   if (!aiMove.isEmpty()) {
     if (applyMoveToBoard(aiMove)) {
-      isWhiteTurn = true;
       moveApplied = true;
     }
   }
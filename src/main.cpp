@@ -340,6 +340,9 @@ void loop() {
   // Process WebRTC signaling cleanup
   webrtcHandler.processCleanup();
 
+  // Run the next step of a requested engine benchmark
+  webInterface.processBenchmark();
+
   // Handle reset button
   if (digitalRead(RESET_BUTTON_PIN) == LOW) {
     delay(50); // Debounce
@@ -609,8 +612,8 @@ void setupWebServer() {
   // Initialize Gemini API
   geminiAPI.begin();
 
-  // Initialize GameController
-  gameController.begin(nullptr, &geminiAPI, nullptr);
+  // Initialize GameController - shares the web board's rules engine
+  gameController.begin(webInterface.getChessEngine(), &geminiAPI, nullptr);
 
   // Initialize WebInterface
   webInterface.setGeminiAPI(&geminiAPI);
@@ -620,7 +623,10 @@ void setupWebServer() {
   // Connect GameController to WebInterface for board updates
   gameController.setWebInterface(&webInterface);
 
-  // Initialize Lichess Web Handler with SessionManager
+  // Initialize Lichess Web Handler with SessionManager - account checks share the sessions' connections
+  // and the pool's worker task, which runs every HTTPS call off the loop task
+  sessionManager.getConnectionPool()->begin();
+  lichessAPI.setConnectionPool(sessionManager.getConnectionPool());
   lichessWebHandler.begin(&server, &lichessAPI, &sessionManager);
 
   // Initialize WebRTC Handler
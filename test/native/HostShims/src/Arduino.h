@@ -0,0 +1,144 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+// Host stand-in for the Arduino-ESP32 core: String over std::string, Print
+// that formats into write(), and a monotonic millis()
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <ctype.h>
+#include <algorithm>
+#include <string>
+#include "freertos/FreeRTOS.h"
+
+using std::min;
+using std::max;
+
+class String {
+public:
+    String() {}
+    String(const char* value) : _value(value ? value : "") {}
+    String(const std::string& value) : _value(value) {}
+    explicit String(char value) : _value(1, value) {}
+    explicit String(int value) : _value(std::to_string(value)) {}
+    explicit String(unsigned int value) : _value(std::to_string(value)) {}
+    explicit String(long value) : _value(std::to_string(value)) {}
+    explicit String(unsigned long value) : _value(std::to_string(value)) {}
+    explicit String(long long value) : _value(std::to_string(value)) {}
+    explicit String(unsigned long long value) : _value(std::to_string(value)) {}
+    explicit String(double value, unsigned int decimals = 2);
+
+    unsigned int length() const { return _value.size(); }
+    const char* c_str() const { return _value.c_str(); }
+    bool isEmpty() const { return _value.empty(); }
+    bool reserve(unsigned int size) { _value.reserve(size); return true; }
+
+    char charAt(unsigned int index) const { return index < _value.size() ? _value[index] : 0; }
+    char operator[](unsigned int index) const { return charAt(index); }
+    char& operator[](unsigned int index) { return _value[index]; }
+
+    int indexOf(char c, unsigned int from = 0) const { return position(_value.find(c, from)); }
+    int indexOf(const String& s, unsigned int from = 0) const { return position(_value.find(s._value, from)); }
+    int lastIndexOf(char c) const { return position(_value.rfind(c)); }
+    String substring(unsigned int from) const { return from < _value.size() ? String(_value.substr(from)) : String(); }
+    String substring(unsigned int from, unsigned int to) const;
+    bool startsWith(const String& prefix) const { return _value.compare(0, prefix._value.size(), prefix._value) == 0; }
+    bool endsWith(const String& suffix) const;
+    bool equals(const String& other) const { return _value == other._value; }
+    long toInt() const { return atol(_value.c_str()); }
+    void trim();
+
+    bool concat(const String& s) { _value += s._value; return true; }
+    bool concat(const char* s) { _value += s ? s : ""; return true; }
+    bool concat(const char* s, unsigned int length) { _value.append(s, length); return true; }
+    bool concat(char c) { _value += c; return true; }
+    String& operator+=(const String& s) { concat(s); return *this; }
+    String& operator+=(const char* s) { concat(s); return *this; }
+    String& operator+=(char c) { concat(c); return *this; }
+    String& operator+=(int value) { _value += std::to_string(value); return *this; }
+    String& operator+=(unsigned long value) { _value += std::to_string(value); return *this; }
+
+    bool operator==(const String& other) const { return _value == other._value; }
+    bool operator==(const char* other) const { return _value == (other ? other : ""); }
+    bool operator!=(const String& other) const { return !(*this == other); }
+    bool operator!=(const char* other) const { return !(*this == other); }
+    bool operator<(const String& other) const { return _value < other._value; }
+
+private:
+    std::string _value;
+
+    static int position(size_t found) { return found == std::string::npos ? -1 : (int)found; }
+};
+
+inline String operator+(const String& a, const String& b) { String s(a); s += b; return s; }
+inline String operator+(const String& a, const char* b) { String s(a); s += b; return s; }
+inline String operator+(const char* a, const String& b) { String s(a); s += b; return s; }
+inline String operator+(const String& a, char b) { String s(a); s += b; return s; }
+inline String operator+(const String& a, int b) { String s(a); s += b; return s; }
+inline String operator+(const String& a, unsigned long b) { String s(a); s += b; return s; }
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size);
+    size_t write(const char* s) { return write((const uint8_t*)s, strlen(s)); }
+
+    size_t print(const String& s) { return write(s.c_str()); }
+    size_t print(const char* s) { return write(s); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(int value) { return printf("%d", value); }
+    size_t print(unsigned int value) { return printf("%u", value); }
+    size_t print(long value) { return printf("%ld", value); }
+    size_t print(unsigned long value) { return printf("%lu", value); }
+    size_t print(double value, int decimals = 2) { return printf("%.*f", decimals, value); }
+    size_t println() { return write("\r\n"); }
+    template <class T> size_t println(const T& value) { return print(value) + println(); }
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() { return -1; }
+    virtual void flush() {}
+    void setTimeout(unsigned long timeout) { _timeout = timeout; }
+
+protected:
+    unsigned long _timeout = 1000;
+};
+
+// Output is dropped - the code under test logs a lot and tests report through Unity
+class HardwareSerial : public Stream {
+public:
+    void begin(unsigned long baud) {}
+    size_t write(uint8_t c) override { return 1; }
+    size_t write(const uint8_t* buffer, size_t size) override { return size; }
+    using Print::write;
+    int available() override { return 0; }
+    int read() override { return -1; }
+};
+
+extern HardwareSerial Serial;
+
+struct EspClass {
+    uint32_t getFreeHeap();
+    uint32_t getMaxAllocHeap();
+};
+extern EspClass ESP;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void yield();
+long random(long max);
+long random(long min, long max);
+inline bool isDigit(char c) { return isdigit((unsigned char)c); }
+size_t strlcpy(char* dst, const char* src, size_t size);
+
+#endif // HOST_ARDUINO_H
@@ -0,0 +1,12 @@
+#ifndef HOST_ESP_ASYNC_WEB_SERVER_H
+#define HOST_ESP_ASYNC_WEB_SERVER_H
+
+#include <Arduino.h>
+
+// Only what SDLogger.h needs for its serial-log mirror
+class AsyncEventSource {
+public:
+    void send(const char* message, const char* event = nullptr, uint32_t id = 0, uint32_t reconnect = 0) {}
+};
+
+#endif // HOST_ESP_ASYNC_WEB_SERVER_H
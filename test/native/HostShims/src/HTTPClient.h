@@ -0,0 +1,64 @@
+#ifndef HOST_HTTP_CLIENT_H
+#define HOST_HTTP_CLIENT_H
+
+#include <WiFiClientSecure.h>
+#include <utility>
+#include <vector>
+
+#define HTTP_CODE_OK 200
+#define HTTP_CODE_CREATED 201
+#define HTTP_CODE_TOO_MANY_REQUESTS 429
+#define HTTPC_ERROR_CONNECTION_REFUSED (-1)
+#define HTTPC_ERROR_SEND_HEADER_FAILED (-2)
+#define HTTPC_ERROR_CONNECTION_LOST (-5)
+#define HTTPC_ERROR_READ_TIMEOUT (-11)
+
+// With no hostServer set, every request gets a canned response: the ones
+// queued with hostQueueHttpResponse() first, in order, then hostHttpResponse.
+// Tests set these before submitting work.
+struct HostHttpResponse {
+    int code;
+    const char* body;
+    const char* retryAfter;  // Retry-After header, "" for none
+};
+extern HostHttpResponse hostHttpResponse;
+// Safe while the worker is sending - tests script a run of 429s with these
+void hostQueueHttpResponse(const HostHttpResponse& response);
+void hostClearHttpResponses();
+
+// With hostServer set, requests go out as HTTP/1.1 on the client's socket.
+// The response headers are read and the body left on the socket, so a stream
+// is read from getStreamPtr() as on the device.
+class HTTPClient {
+public:
+    bool begin(WiFiClient& client, const String& url);
+    void end();
+    void setReuse(bool reuse) { _reuse = reuse; }
+    void setTimeout(uint16_t timeout) { _timeout = timeout; }
+    void setConnectTimeout(int32_t timeout) {}
+    void addHeader(const String& name, const String& value) { _requestHeaders += name + ": " + value + "\r\n"; }
+    void collectHeaders(const char* headers[], size_t count) {}  // Every response header is kept
+    String header(const char* name);
+
+    int GET() { return sendRequest("GET", String()); }
+    int POST(const String& body) { return sendRequest("POST", body); }
+    String getString();
+    WiFiClient* getStreamPtr() { return _client; }
+    static String errorToString(int code) { return String("host error ") + code; }
+
+private:
+    int sendRequest(const char* method, const String& body);
+    bool readLine(String& line);
+
+    WiFiClient* _client = nullptr;
+    String _path;
+    String _requestHeaders;
+    bool _reuse = true;
+    uint16_t _timeout = 5000;      // ms, as on the device
+    bool _keepAlive = false;       // Server left the connection open
+    long _contentLength = -1;      // -1: body runs until the server closes
+    HostHttpResponse _canned = {0, "", ""};
+    std::vector<std::pair<String, String>> _responseHeaders;
+};
+
+#endif // HOST_HTTP_CLIENT_H
@@ -0,0 +1,456 @@
+#include <Arduino.h>
+#include <HTTPClient.h>
+#include <SD.h>
+#include <ESPAsyncWebServer.h>
+#include <freertos/FreeRTOS.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <strings.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+HardwareSerial Serial;
+EspClass ESP;
+WiFiClass WiFi;
+SDFS SD;
+HostHttpResponse hostHttpResponse = {HTTP_CODE_OK, "{}", ""};
+HostServer hostServer = {nullptr, 0};
+
+// Firmware globals from main.cpp and WebInterface.cpp, which the host build leaves out
+class SDLogger* sdLogger = nullptr;
+AsyncEventSource* g_serialLogEventSource = nullptr;
+
+static const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+// Starts at 1 like the device's clock does after boot, so 0 can mean "never"
+unsigned long millis() {
+    return 1 + std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - startTime).count();
+}
+
+unsigned long micros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - startTime).count();
+}
+
+void delay(unsigned long ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void yield() {
+    std::this_thread::yield();
+}
+
+long random(long max) {
+    return max > 0 ? rand() % max : 0;
+}
+
+long random(long min, long max) {
+    return min < max ? min + rand() % (max - min) : min;
+}
+
+size_t strlcpy(char* dst, const char* src, size_t size) {
+    size_t length = strlen(src);
+    if (size > 0) {
+        size_t copied = length < size - 1 ? length : size - 1;
+        memcpy(dst, src, copied);
+        dst[copied] = '\0';
+    }
+    return length;
+}
+
+uint32_t EspClass::getFreeHeap() {
+    return 200000;
+}
+
+uint32_t EspClass::getMaxAllocHeap() {
+    return 100000;
+}
+
+String::String(double value, unsigned int decimals) {
+    char buffer[48];
+    snprintf(buffer, sizeof(buffer), "%.*f", (int)decimals, value);
+    _value = buffer;
+}
+
+String String::substring(unsigned int from, unsigned int to) const {
+    if (from > to) {
+        std::swap(from, to);
+    }
+    if (from >= _value.size()) {
+        return String();
+    }
+    return String(_value.substr(from, to - from));
+}
+
+bool String::endsWith(const String& suffix) const {
+    return _value.size() >= suffix._value.size() &&
+           _value.compare(_value.size() - suffix._value.size(), suffix._value.size(), suffix._value) == 0;
+}
+
+void String::trim() {
+    size_t start = 0;
+    while (start < _value.size() && isspace((unsigned char)_value[start])) {
+        start++;
+    }
+    size_t end = _value.size();
+    while (end > start && isspace((unsigned char)_value[end - 1])) {
+        end--;
+    }
+    _value = _value.substr(start, end - start);
+}
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+    size_t written = 0;
+    while (size--) {
+        written += write(*buffer++);
+    }
+    return written;
+}
+
+size_t Print::printf(const char* format, ...) {
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    if (length < 0) {
+        return 0;
+    }
+    if ((size_t)length < sizeof(buffer)) {
+        return write((const uint8_t*)buffer, length);
+    }
+    std::vector<char> large(length + 1);
+    va_start(args, format);
+    vsnprintf(large.data(), large.size(), format, args);
+    va_end(args);
+    return write((const uint8_t*)large.data(), length);
+}
+
+// --- Network ---
+
+int WiFiClient::connect(const char* host, uint16_t port) {
+    stop();
+    if (!hostServer.host) {
+        return 1;  // Canned responses - nothing to connect to
+    }
+
+    addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* address = nullptr;
+    if (getaddrinfo(hostServer.host, std::to_string(hostServer.port).c_str(), &hints, &address) != 0) {
+        return 0;
+    }
+    _socket = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+    bool connectedNow = _socket >= 0 && ::connect(_socket, address->ai_addr, address->ai_addrlen) == 0;
+    freeaddrinfo(address);
+    if (!connectedNow) {
+        stop();
+        return 0;
+    }
+    int noDelay = 1;
+    setsockopt(_socket, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+    return 1;
+}
+
+// Like the device: still connected while unread data is buffered, even if the server has closed
+uint8_t WiFiClient::connected() {
+    if (_socket < 0) {
+        return 0;
+    }
+    char probe;
+    ssize_t peeked = recv(_socket, &probe, 1, MSG_PEEK | MSG_DONTWAIT);
+    if (peeked > 0 || (peeked < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))) {
+        return 1;
+    }
+    stop();
+    return 0;
+}
+
+void WiFiClient::stop() {
+    if (_socket >= 0) {
+        close(_socket);
+        _socket = -1;
+    }
+}
+
+size_t WiFiClient::write(const uint8_t* buffer, size_t size) {
+    if (_socket < 0) {
+        return size;  // Canned responses - the request goes nowhere
+    }
+    size_t written = 0;
+    while (written < size) {
+        ssize_t sent = send(_socket, buffer + written, size - written, MSG_NOSIGNAL);
+        if (sent <= 0) {
+            break;
+        }
+        written += sent;
+    }
+    return written;
+}
+
+int WiFiClient::available() {
+    int bytes = 0;
+    if (_socket < 0 || ioctl(_socket, FIONREAD, &bytes) != 0) {
+        return 0;
+    }
+    return bytes;
+}
+
+int WiFiClient::read() {
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+}
+
+int WiFiClient::read(uint8_t* buffer, size_t size) {
+    if (_socket < 0) {
+        return 0;
+    }
+    ssize_t received = recv(_socket, buffer, size, MSG_DONTWAIT);
+    return received > 0 ? (int)received : 0;
+}
+
+bool WiFiClient::readFully(uint8_t* buffer, size_t size, unsigned long timeout) {
+    size_t done = 0;
+    while (done < size && _socket >= 0) {
+        pollfd ready = {_socket, POLLIN, 0};
+        if (poll(&ready, 1, timeout) <= 0) {
+            return false;
+        }
+        ssize_t received = recv(_socket, buffer + done, size - done, 0);
+        if (received <= 0) {
+            return false;
+        }
+        done += received;
+    }
+    return done == size;
+}
+
+static std::mutex hostHttpLock;
+static std::deque<HostHttpResponse> hostHttpQueue;
+
+void hostQueueHttpResponse(const HostHttpResponse& response) {
+    std::lock_guard<std::mutex> guard(hostHttpLock);
+    hostHttpQueue.push_back(response);
+}
+
+void hostClearHttpResponses() {
+    std::lock_guard<std::mutex> guard(hostHttpLock);
+    hostHttpQueue.clear();
+}
+
+static HostHttpResponse nextHttpResponse() {
+    std::lock_guard<std::mutex> guard(hostHttpLock);
+    if (hostHttpQueue.empty()) {
+        return hostHttpResponse;
+    }
+    HostHttpResponse response = hostHttpQueue.front();
+    hostHttpQueue.pop_front();
+    return response;
+}
+
+bool HTTPClient::begin(WiFiClient& client, const String& url) {
+    _client = &client;
+    _requestHeaders = "";
+    _responseHeaders.clear();
+    _contentLength = -1;
+    _keepAlive = false;
+
+    // Path only - the client is already connected to hostServer, whatever the URL's host
+    int hostStart = url.indexOf("://");
+    int pathStart = url.indexOf('/', hostStart < 0 ? 0 : hostStart + 3);
+    _path = pathStart < 0 ? String("/") : url.substring(pathStart);
+    return true;
+}
+
+void HTTPClient::end() {
+    if (_client && _client->hasSocket() && !(_reuse && _keepAlive)) {
+        _client->stop();
+    }
+}
+
+String HTTPClient::header(const char* name) {
+    if (!_client || !_client->hasSocket()) {
+        return String(_canned.retryAfter);
+    }
+    for (const auto& header : _responseHeaders) {
+        if (strcasecmp(header.first.c_str(), name) == 0) {
+            return header.second;
+        }
+    }
+    return String();
+}
+
+// One header line, without the CRLF - read a byte at a time so the body stays on the socket
+bool HTTPClient::readLine(String& line) {
+    line = "";
+    uint8_t c;
+    while (_client->readFully(&c, 1, _timeout)) {
+        if (c == '\n') {
+            if (line.endsWith("\r")) {
+                line = line.substring(0, line.length() - 1);
+            }
+            return true;
+        }
+        line += (char)c;
+    }
+    return false;
+}
+
+int HTTPClient::sendRequest(const char* method, const String& body) {
+    if (!_client || !_client->hasSocket()) {
+        _canned = nextHttpResponse();
+        return _canned.code;
+    }
+
+    String request = String(method) + " " + _path + " HTTP/1.1\r\n";
+    request += String("Host: ") + hostServer.host + ":" + String((unsigned int)hostServer.port) + "\r\n";
+    request += String("Connection: ") + (_reuse ? "keep-alive" : "close") + "\r\n";
+    request += _requestHeaders;
+    if (strcmp(method, "POST") == 0) {
+        request += "Content-Length: " + String(body.length()) + "\r\n";
+    }
+    request += "\r\n";
+    request += body;
+    if (_client->write((const uint8_t*)request.c_str(), request.length()) != request.length()) {
+        return HTTPC_ERROR_SEND_HEADER_FAILED;
+    }
+
+    String line;
+    if (!readLine(line)) {
+        return HTTPC_ERROR_READ_TIMEOUT;
+    }
+    int space = line.indexOf(' ');
+    int code = space < 0 ? 0 : line.substring(space + 1).toInt();
+    if (code <= 0) {
+        return HTTPC_ERROR_CONNECTION_LOST;
+    }
+
+    _keepAlive = true;  // HTTP/1.1 default
+    while (readLine(line) && line.length() > 0) {
+        int colon = line.indexOf(':');
+        if (colon < 0) {
+            continue;
+        }
+        String name = line.substring(0, colon);
+        String value = line.substring(colon + 1);
+        value.trim();
+        if (strcasecmp(name.c_str(), "Content-Length") == 0) {
+            _contentLength = value.toInt();
+        } else if (strcasecmp(name.c_str(), "Connection") == 0 && strcasecmp(value.c_str(), "close") == 0) {
+            _keepAlive = false;
+        }
+        _responseHeaders.push_back({name, value});
+    }
+    if (_contentLength < 0) {
+        _keepAlive = false;  // Body runs until the server closes
+    }
+    return code;
+}
+
+String HTTPClient::getString() {
+    if (!_client || !_client->hasSocket()) {
+        return String(_canned.body);
+    }
+    std::string body;
+    if (_contentLength >= 0) {
+        body.resize(_contentLength);
+        if (!_client->readFully((uint8_t*)&body[0], body.size(), _timeout)) {
+            _keepAlive = false;
+            return String();
+        }
+    } else {
+        uint8_t c;
+        while (_client->readFully(&c, 1, _timeout)) {
+            body += (char)c;
+        }
+    }
+    return String(body);
+}
+
+// --- FreeRTOS ---
+
+void vTaskDelay(TickType_t ticks) {
+    delay(ticks);
+}
+
+// The task runs detached until the process exits, like a task that never deletes itself
+BaseType_t xTaskCreatePinnedToCore(void (*task)(void*), const char* name, uint32_t stackDepth, void* param,
+                                   UBaseType_t priority, TaskHandle_t* handle, BaseType_t core) {
+    std::thread(task, param).detach();
+    if (handle) {
+        *handle = (TaskHandle_t)task;
+    }
+    return pdPASS;
+}
+
+struct HostQueue {
+    std::mutex lock;
+    std::condition_variable ready;
+    std::deque<std::vector<uint8_t>> items;
+    size_t length;
+    size_t itemSize;
+};
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+    HostQueue* queue = new HostQueue();
+    queue->length = length;
+    queue->itemSize = itemSize;
+    return queue;
+}
+
+// Waits for a free place are not modelled - a full queue fails at once
+BaseType_t xQueueSend(QueueHandle_t handle, const void* item, TickType_t wait) {
+    HostQueue* queue = (HostQueue*)handle;
+    std::lock_guard<std::mutex> guard(queue->lock);
+    if (queue->items.size() >= queue->length) {
+        return pdFALSE;
+    }
+    const uint8_t* bytes = (const uint8_t*)item;
+    queue->items.emplace_back(bytes, bytes + queue->itemSize);
+    queue->ready.notify_one();
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t handle, void* item, TickType_t wait) {
+    HostQueue* queue = (HostQueue*)handle;
+    std::unique_lock<std::mutex> guard(queue->lock);
+    auto hasItem = [queue] { return !queue->items.empty(); };
+    if (wait == portMAX_DELAY) {
+        queue->ready.wait(guard, hasItem);
+    } else if (!queue->ready.wait_for(guard, std::chrono::milliseconds(wait), hasItem)) {
+        return pdFALSE;
+    }
+    memcpy(item, queue->items.front().data(), queue->itemSize);
+    queue->items.pop_front();
+    return pdTRUE;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+    return new std::mutex();
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t mutex, TickType_t wait) {
+    ((std::mutex*)mutex)->lock();
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t mutex) {
+    ((std::mutex*)mutex)->unlock();
+    return pdTRUE;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t mutex) {
+    delete (std::mutex*)mutex;
+}
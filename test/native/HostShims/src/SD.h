@@ -0,0 +1,38 @@
+#ifndef HOST_SD_H
+#define HOST_SD_H
+
+#include <Arduino.h>
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+
+// No card: every open fails
+class File : public Stream {
+public:
+    explicit operator bool() const { return false; }
+    size_t write(uint8_t c) override { return 0; }
+    size_t write(const uint8_t* buffer, size_t size) override { return 0; }
+    using Print::write;
+    int available() override { return 0; }
+    int read() override { return -1; }
+    size_t size() { return 0; }
+    void close() {}
+    bool isDirectory() { return false; }
+    File openNextFile() { return File(); }
+    const char* name() { return ""; }
+    const char* path() { return ""; }
+    String readStringUntil(char terminator) { return String(); }
+};
+
+struct SDFS {
+    File open(const char* path, const char* mode = FILE_READ) { return File(); }
+    File open(const String& path, const char* mode = FILE_READ) { return File(); }
+    bool exists(const char* path) { return false; }
+    bool exists(const String& path) { return false; }
+    bool remove(const char* path) { return false; }
+    bool remove(const String& path) { return false; }
+};
+extern SDFS SD;
+
+#endif // HOST_SD_H
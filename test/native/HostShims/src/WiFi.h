@@ -0,0 +1,70 @@
+#ifndef HOST_WIFI_H
+#define HOST_WIFI_H
+
+#include <Arduino.h>
+
+typedef int wl_status_t;
+enum {
+    WL_NO_SHIELD = 255,
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL,
+    WL_SCAN_COMPLETED,
+    WL_CONNECTED,
+    WL_CONNECT_FAILED,
+    WL_CONNECTION_LOST,
+    WL_DISCONNECTED
+};
+
+class IPAddress {
+public:
+    String toString() const { return String("127.0.0.1"); }
+};
+
+struct WiFiClass {
+    wl_status_t status() { return WL_CONNECTED; }
+    IPAddress localIP() { return IPAddress(); }
+    IPAddress gatewayIP() { return IPAddress(); }
+    IPAddress dnsIP() { return IPAddress(); }
+    int8_t RSSI() { return -50; }
+    bool hostByName(const char* host, IPAddress& address) { return true; }
+};
+extern WiFiClass WiFi;
+
+// Where WiFiClient::connect() really connects, whatever host the code asked
+// for. Unset (the default), a client never connects and HTTPClient hands out
+// canned responses instead. Set it to a plain HTTP server - such as
+// tools/lichess_stub_server.py --no-tls - to run requests and streams for real.
+struct HostServer {
+    const char* host;
+    uint16_t port;
+};
+extern HostServer hostServer;
+
+// A TCP socket to hostServer, or with no server set a client that never
+// connects and never has data - a stream opened against it reads as dropped
+class WiFiClient : public Stream {
+public:
+    WiFiClient() {}
+    WiFiClient(const WiFiClient&) = delete;
+    WiFiClient& operator=(const WiFiClient&) = delete;
+    virtual ~WiFiClient() { stop(); }
+
+    virtual int connect(const char* host, uint16_t port);
+    virtual uint8_t connected();
+    virtual void stop();
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+    int available() override;
+    int read() override;
+    virtual int read(uint8_t* buffer, size_t size);
+
+    // Read exactly size bytes, waiting up to timeout ms for each
+    bool readFully(uint8_t* buffer, size_t size, unsigned long timeout);
+    bool hasSocket() const { return _socket >= 0; }
+
+private:
+    int _socket = -1;
+};
+
+#endif // HOST_WIFI_H
@@ -0,0 +1,62 @@
+#include <unity.h>
+#include "ChessEngine.h"
+
+// Published perft node counts (chessprogramming.org/Perft_Results), one level
+// deeper than the on-device self-test can afford
+static ChessEngine engine;
+
+static void checkPerft(const char* fen, int depth, uint64_t expected) {
+  TEST_ASSERT_TRUE(engine.setFEN(fen));
+  TEST_ASSERT_EQUAL_UINT64(expected, engine.perft(depth));
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_perft_start() {
+  checkPerft("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 5, 4865609);
+}
+
+void test_perft_kiwipete() {
+  checkPerft("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 4, 4085603);
+}
+
+void test_perft_en_passant() {
+  checkPerft("8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 5, 674624);
+}
+
+void test_perft_promotion() {
+  checkPerft("r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 4, 422333);
+}
+
+void test_perft_promotion_check() {
+  checkPerft("rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 4, 2103487);
+}
+
+// Every square occupied (bar the en passant pawn's path), all castling rights
+// and both clocks at their maximum: the longest FEN getFEN() can produce
+void test_fen_longest_round_trips() {
+  const char* longest = "rnbqkbnr/ppp1pppp/PPP1PPPP/ppPpPppp/PPPPPPPP/pppppppp/PPPPPPPP/RNBQKBNR w KQkq d6 65535 65535";
+  TEST_ASSERT_TRUE(engine.setFEN(longest));
+  char fen[CHESS_FEN_MAX];
+  TEST_ASSERT_EQUAL(CHESS_FEN_MAX - 1, engine.getFEN(fen, sizeof(fen)));
+  TEST_ASSERT_EQUAL_STRING(longest, fen);
+}
+
+void test_fen_refuses_small_buffer() {
+  TEST_ASSERT_TRUE(engine.setFEN("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"));
+  char fen[CHESS_FEN_MAX - 1];
+  TEST_ASSERT_EQUAL(0, engine.getFEN(fen, sizeof(fen)));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_perft_start);
+  RUN_TEST(test_perft_kiwipete);
+  RUN_TEST(test_perft_en_passant);
+  RUN_TEST(test_perft_promotion);
+  RUN_TEST(test_perft_promotion_check);
+  RUN_TEST(test_fen_longest_round_trips);
+  RUN_TEST(test_fen_refuses_small_buffer);
+  return UNITY_END();
+}
@@ -0,0 +1,117 @@
+#include <unity.h>
+#include <stdio.h>
+#include "BoardJson.h"
+#include "ChessEngine.h"
+
+// Host timings for the paths the on-device benchmark (/api/engine/bench)
+// times, on the same Kiwipete position. Each case runs for at least
+// BENCH_MIN_US and reports ns/op; the assertions only check the work was
+// done. The native env builds with ASan/UBSan, so compare runs with each
+// other rather than with the device.
+
+#define BENCH_MIN_US 200000UL
+
+static const char* KIWIPETE = "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1";
+
+static ChessEngine engine;
+static Move moves[CHESS_MAX_MOVES];
+static int moveCount;
+static volatile uint32_t sink;  // Keeps the timed calls from being optimized away
+
+void setUp() {
+  TEST_ASSERT_TRUE(engine.setFEN(KIWIPETE));
+  moveCount = engine.generateLegalMoves(moves);
+  TEST_ASSERT_EQUAL(48, moveCount);
+}
+
+void tearDown() {}
+
+static void report(const char* name, uint32_t iterations, unsigned long elapsedUs) {
+  char message[96];
+  snprintf(message, sizeof(message), "%s: %lu ns/op over %lu iterations", name,
+           (unsigned long)((uint64_t)elapsedUs * 1000 / iterations), (unsigned long)iterations);
+  TEST_MESSAGE(message);
+}
+
+void test_bench_generate_legal_moves() {
+  uint32_t iterations = 0;
+  unsigned long start = micros();
+  while (micros() - start < BENCH_MIN_US) {
+    for (int i = 0; i < 100; i++, iterations++) {
+      sink = engine.generateLegalMoves(moves);
+    }
+  }
+  report("generateLegalMoves", iterations, micros() - start);
+  TEST_ASSERT_EQUAL(48, sink);
+}
+
+// Text in, legal move out - the path every submitted move takes
+void test_bench_find_legal_move() {
+  char uci[CHESS_MAX_MOVES][CHESS_UCI_MAX];
+  for (int i = 0; i < moveCount; i++) {
+    ChessEngine::formatUCI(moves[i], uci[i], sizeof(uci[i]));
+  }
+
+  uint32_t iterations = 0;
+  uint32_t found = 0;
+  Move legal;
+  unsigned long start = micros();
+  while (micros() - start < BENCH_MIN_US) {
+    for (int i = 0; i < moveCount; i++, iterations++) {
+      found += engine.findLegalMove(engine.parseMove(uci[i]), legal);
+    }
+  }
+  report("findLegalMove(parseMove)", iterations, micros() - start);
+  TEST_ASSERT_EQUAL(iterations, found);
+}
+
+void test_bench_game_result() {
+  uint32_t iterations = 0;
+  unsigned long start = micros();
+  while (micros() - start < BENCH_MIN_US) {
+    for (int i = 0; i < 100; i++, iterations++) {
+      sink = engine.getGameResult();
+    }
+  }
+  report("getGameResult", iterations, micros() - start);
+  TEST_ASSERT_EQUAL(GAME_ONGOING, sink);
+}
+
+void test_bench_status_json() {
+  uint32_t iterations = 0;
+  unsigned long start = micros();
+  while (micros() - start < BENCH_MIN_US) {
+    for (int i = 0; i < 10; i++, iterations++) {
+      sink = buildStatusJSON(engine).length();
+    }
+  }
+  report("statusJSON", iterations, micros() - start);
+  TEST_ASSERT_GREATER_THAN(200, sink);
+}
+
+void test_bench_board_json() {
+  uint8_t board[64];
+  for (int square = 0; square < 64; square++) {
+    board[square] = engine.getPieceCode(square);
+  }
+
+  uint32_t iterations = 0;
+  unsigned long start = micros();
+  while (micros() - start < BENCH_MIN_US) {
+    for (int i = 0; i < 10; i++, iterations++) {
+      sink = buildBoardJSON(board, 1, iterations).length();
+    }
+  }
+  report("boardJSON", iterations, micros() - start);
+  TEST_ASSERT_GREATER_THAN(300, sink);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_bench_generate_legal_moves);
+  RUN_TEST(test_bench_find_legal_move);
+  RUN_TEST(test_bench_game_result);
+  RUN_TEST(test_bench_status_json);
+  RUN_TEST(test_bench_board_json);
+  return UNITY_END();
+}
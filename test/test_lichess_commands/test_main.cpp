@@ -0,0 +1,76 @@
+#include <unity.h>
+#include <vector>
+#include "LichessAPI.h"
+
+// The per-session command queue on its own: what gets merged as a duplicate,
+// and what a finished game leaves behind. Nothing here reaches the worker -
+// process() is never called, so queued commands stay queued.
+
+static const char* GAME = "abcdefgh";
+
+void setUp() {}
+void tearDown() {}
+
+static std::vector<LichessAPI::CommandUpdate> drainUpdates(LichessAPI& api) {
+    std::vector<LichessAPI::CommandUpdate> updates;
+    LichessAPI::CommandUpdate update;
+    while (api.popCommandUpdate(update)) {
+        updates.push_back(update);
+    }
+    return updates;
+}
+
+// A double click is sent once, but a move repeated later in the line is a new move
+void test_repeated_premove_is_queued() {
+    LichessAPI api;
+    api.setPlayerToMove(false);
+
+    uint32_t first = api.queueMove(GAME, "g1f3");
+    TEST_ASSERT_EQUAL(first, api.queueMove(GAME, "g1f3"));
+    uint32_t back = api.queueMove(GAME, "f3g1");
+    uint32_t again = api.queueMove(GAME, "g1f3");
+
+    TEST_ASSERT_NOT_EQUAL(first, again);
+    TEST_ASSERT_NOT_EQUAL(back, again);
+    TEST_ASSERT_EQUAL(again, api.queueMove(GAME, "g1f3"));
+    TEST_ASSERT_EQUAL(3, api.getQueueSize());
+}
+
+// The premove waiting for a reply that never comes must not outlive the game
+void test_game_end_cancels_premoves() {
+    LichessAPI api;
+    api.setPlayerToMove(false);
+    api.queueMove(GAME, "e2e4");
+    api.queueDrawOffer(GAME);
+    api.queueMove("othergame", "d2d4");
+    drainUpdates(api);
+
+    api.endGame(GAME, "Game over");
+
+    TEST_ASSERT_EQUAL(1, api.getQueueSize());
+    std::vector<LichessAPI::CommandUpdate> updates = drainUpdates(api);
+    TEST_ASSERT_EQUAL(2, updates.size());
+    for (const auto& update : updates) {
+        TEST_ASSERT_EQUAL(LichessAPI::CMD_CANCELLED, update.status);
+    }
+}
+
+void test_new_game_cancels_premoves() {
+    LichessAPI api;
+    api.setPlayerToMove(false);
+    api.queueMove(GAME, "e2e4");
+    api.queueMove("othergame", "d2d4");
+
+    TEST_ASSERT_NOT_EQUAL(0, api.queueCreateGame(3, 600, 0, "white"));
+
+    TEST_ASSERT_EQUAL(1, api.getQueueSize());
+    TEST_ASSERT_FALSE(api.hasQueuedMove());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_repeated_premove_is_queued);
+    RUN_TEST(test_game_end_cancels_premoves);
+    RUN_TEST(test_new_game_cancels_premoves);
+    return UNITY_END();
+}
@@ -0,0 +1,198 @@
+#include <unity.h>
+#include <algorithm>
+#include <thread>
+#include <vector>
+#include "LichessConnectionPool.h"
+#include "LichessRateLimiter.h"
+
+// The limiter on its own (time passed in), then the pool's worker pacing a
+// burst of requests and backing off a 429 against scripted HTTPClient
+// responses in real time
+
+static const int ACCOUNT = LichessConnectionPool::ENDPOINT_ACCOUNT;
+static const int BOARD = LichessConnectionPool::ENDPOINT_BOARD;
+
+void setUp() {
+    hostHttpResponse = {HTTP_CODE_OK, "{}", ""};
+    hostClearHttpResponses();
+}
+
+// Submit and wait for the worker to finish - the caller hands the slot back
+static LichessConnectionPool::Request* runRequest(LichessConnectionPool& pool, const char* url, bool post) {
+    static int owner;
+    LichessConnectionPool::Request* request = pool.submitRequest(&owner, url, post, "", "token", false);
+    TEST_ASSERT_NOT_NULL(request);
+    while (!pool.isDone(request)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return request;
+}
+
+void tearDown() {}
+
+void test_burst_then_one_per_interval() {
+    LichessRateLimiter limiter;
+    limiter.setGlobalBudget(8, 250, 1000);
+    limiter.setBudget(BOARD, 6, 250, 0, 1000);
+
+    for (int i = 0; i < 6; i++) {
+        TEST_ASSERT_EQUAL(0, limiter.acquire(BOARD, 1000));
+    }
+    // The budget's own bucket is spent before the global one
+    TEST_ASSERT_EQUAL(250, limiter.acquire(BOARD, 1000));
+    TEST_ASSERT_EQUAL(100, limiter.acquire(BOARD, 1150));
+    TEST_ASSERT_EQUAL(0, limiter.acquire(BOARD, 1250));
+    TEST_ASSERT_EQUAL(250, limiter.acquire(BOARD, 1250));
+    TEST_ASSERT_EQUAL(7, limiter.getCounters(BOARD).granted);
+    TEST_ASSERT_EQUAL(2, limiter.getGlobalTokens(1250));
+}
+
+// Account checks stop short of the last global tokens so moves still go out
+void test_reserve_keeps_tokens_for_moves() {
+    LichessRateLimiter limiter;
+    limiter.setGlobalBudget(8, 250, 0);
+    limiter.setBudget(ACCOUNT, 8, 3000, 4, 0);
+    limiter.setBudget(BOARD, 8, 250, 0, 0);
+
+    int accountGranted = 0;
+    while (limiter.acquire(ACCOUNT, 0) == 0) {
+        accountGranted++;
+    }
+    TEST_ASSERT_EQUAL(4, accountGranted);
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_EQUAL(0, limiter.acquire(BOARD, 0));
+    }
+    TEST_ASSERT_EQUAL(0, limiter.getGlobalTokens(0));
+    TEST_ASSERT_GREATER_THAN(0, limiter.acquire(BOARD, 0));
+
+    // Refilling past the reserve is what lets account checks go again
+    TEST_ASSERT_EQUAL(1000, limiter.acquire(ACCOUNT, 250));
+    TEST_ASSERT_EQUAL(0, limiter.acquire(ACCOUNT, 1250));
+}
+
+void test_idle_time_does_not_bank_tokens() {
+    LichessRateLimiter limiter;
+    limiter.setGlobalBudget(2, 100, 0);
+    limiter.setBudget(BOARD, 10, 100, 0, 0);
+
+    TEST_ASSERT_EQUAL(0, limiter.acquire(BOARD, 0));
+    TEST_ASSERT_EQUAL(0, limiter.acquire(BOARD, 0));
+    TEST_ASSERT_EQUAL(2, limiter.getGlobalTokens(60000));
+    TEST_ASSERT_EQUAL(0, limiter.acquire(BOARD, 60000));
+    TEST_ASSERT_EQUAL(0, limiter.acquire(BOARD, 60000));
+    TEST_ASSERT_EQUAL(100, limiter.acquire(BOARD, 60000));
+}
+
+void test_counters_record_delays() {
+    LichessRateLimiter limiter;
+    limiter.recordDelay(BOARD, 250);
+    limiter.recordDelay(BOARD, 100);
+    const LichessRateLimiter::Counters& counters = limiter.getCounters(BOARD);
+    TEST_ASSERT_EQUAL(2, counters.throttled);
+    TEST_ASSERT_EQUAL(350, counters.totalDelay);
+    TEST_ASSERT_EQUAL(250, counters.maxDelay);
+    TEST_ASSERT_EQUAL(0, limiter.getCounters(ACCOUNT).throttled);
+}
+
+// Several sessions' account checks and moves submitted at once: all of them
+// complete, and never faster than the global bucket allows
+void test_pool_paces_burst() {
+    static const int ACCOUNT_CHECKS = 3;
+    static const int MOVES = 10;
+    static LichessConnectionPool pool;  // The worker task never exits
+    TEST_ASSERT_TRUE(pool.begin());
+
+    std::vector<LichessConnectionPool::Request*> requests;
+    int owner = 0;
+    for (int i = 0; i < ACCOUNT_CHECKS; i++) {
+        requests.push_back(pool.submitRequest(&owner, LICHESS_BASE_URL "/api/account", false, "", "token", false));
+    }
+    for (int i = 0; i < MOVES; i++) {
+        requests.push_back(pool.submitRequest(&owner, LICHESS_BASE_URL "/api/board/game/abcdefgh/move/e2e4",
+                                              true, "", "token", false));
+    }
+    unsigned long start = millis();
+    for (LichessConnectionPool::Request* request : requests) {
+        TEST_ASSERT_NOT_NULL(request);
+    }
+
+    std::vector<unsigned long> finished;
+    for (LichessConnectionPool::Request* request : requests) {
+        while (!pool.isDone(request)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        TEST_ASSERT_EQUAL(HTTP_CODE_OK, request->httpCode);
+        finished.push_back(request->finishedAt - start);
+        pool.finishRequest(request);
+    }
+    TEST_ASSERT_EQUAL(0, pool.getPendingRequestCount());
+
+    // The n-th request to finish needed n + 1 global tokens
+    std::sort(finished.begin(), finished.end());
+    for (size_t n = LICHESS_RATE_BURST; n < finished.size(); n++) {
+        unsigned long earliest = (n + 1 - LICHESS_RATE_BURST) * LICHESS_RATE_INTERVAL;
+        TEST_ASSERT_GREATER_OR_EQUAL(earliest - 5, finished[n]);
+    }
+    // ...and went out as soon as they were allowed to
+    unsigned long paced = (ACCOUNT_CHECKS + MOVES - LICHESS_RATE_BURST) * LICHESS_RATE_INTERVAL;
+    TEST_ASSERT_LESS_OR_EQUAL(paced + LICHESS_RATE_INTERVAL, finished.back());
+
+    LichessConnectionPool::RateStatus account = pool.getRateStatus(LichessConnectionPool::ENDPOINT_ACCOUNT);
+    LichessConnectionPool::RateStatus board = pool.getRateStatus(LichessConnectionPool::ENDPOINT_BOARD);
+    TEST_ASSERT_EQUAL(ACCOUNT_CHECKS, account.counters.granted);
+    TEST_ASSERT_EQUAL(MOVES, board.counters.granted);
+    TEST_ASSERT_GREATER_THAN(0, board.counters.throttled);
+    TEST_ASSERT_LESS_OR_EQUAL(paced + LICHESS_RATE_INTERVAL, board.counters.maxDelay);
+}
+
+// A 429 holds the endpoint off for exactly Retry-After: moves fail at once
+// without a network attempt, other endpoints carry on, and the first move
+// after it goes out as a trial that closes the breaker again
+void test_pool_holds_off_after_429() {
+    static const char* MOVE_URL = LICHESS_BASE_URL "/api/board/game/abcdefgh/move/e2e4";
+    static LichessConnectionPool pool;  // The worker task never exits
+    TEST_ASSERT_TRUE(pool.begin());
+    hostQueueHttpResponse({HTTP_CODE_TOO_MANY_REQUESTS, "{\"error\":\"Too many requests\"}", "1"});
+
+    LichessConnectionPool::Request* limited = runRequest(pool, MOVE_URL, true);
+    TEST_ASSERT_EQUAL(HTTP_CODE_TOO_MANY_REQUESTS, limited->httpCode);
+    TEST_ASSERT_EQUAL(1000, limited->retryAfter);
+    unsigned long limitedAt = limited->finishedAt;
+    pool.finishRequest(limited);
+
+    LichessConnectionPool::BreakerStatus board = pool.getBreakerStatus(LichessConnectionPool::ENDPOINT_BOARD);
+    TEST_ASSERT_EQUAL(LichessConnectionPool::BREAKER_OPEN, board.state);
+    TEST_ASSERT_LESS_OR_EQUAL(1000, board.retryIn);
+
+    for (int i = 0; i < 3; i++) {
+        LichessConnectionPool::Request* refused = runRequest(pool, MOVE_URL, true);
+        TEST_ASSERT_EQUAL(LichessConnectionPool::HTTP_CIRCUIT_OPEN, refused->httpCode);
+        TEST_ASSERT_GREATER_THAN(0, refused->retryAfter);
+        pool.finishRequest(refused);
+    }
+
+    LichessConnectionPool::Request* account = runRequest(pool, LICHESS_BASE_URL "/api/account", false);
+    TEST_ASSERT_EQUAL(HTTP_CODE_OK, account->httpCode);
+    pool.finishRequest(account);
+
+    while (pool.isCircuitOpen(LichessConnectionPool::ENDPOINT_BOARD)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    LichessConnectionPool::Request* trial = runRequest(pool, MOVE_URL, true);
+    TEST_ASSERT_EQUAL(HTTP_CODE_OK, trial->httpCode);
+    TEST_ASSERT_GREATER_OR_EQUAL(limitedAt + 1000, trial->finishedAt);
+    pool.finishRequest(trial);
+    TEST_ASSERT_EQUAL(LichessConnectionPool::BREAKER_CLOSED,
+                      pool.getBreakerStatus(LichessConnectionPool::ENDPOINT_BOARD).state);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_burst_then_one_per_interval);
+    RUN_TEST(test_reserve_keeps_tokens_for_moves);
+    RUN_TEST(test_idle_time_does_not_bank_tokens);
+    RUN_TEST(test_counters_record_delays);
+    RUN_TEST(test_pool_paces_burst);
+    RUN_TEST(test_pool_holds_off_after_429);
+    return UNITY_END();
+}
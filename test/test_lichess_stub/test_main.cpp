@@ -0,0 +1,213 @@
+#include <unity.h>
+#include <ArduinoJson.h>
+#include <signal.h>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "LichessAPI.h"
+#include "LichessConnectionPool.h"
+
+// LichessAPI and the connection pool against tools/lichess_stub_server.py,
+// over real sockets: the host HTTPClient speaks plain HTTP to the stub run
+// with --no-tls. The stub is started here and the tests are skipped if it
+// cannot be (no python3). The stub's AI replays a Ruy Lopez: e2e4 e7e5 g1f3 b8c6.
+
+static const uint16_t STUB_PORT = 18443;
+static const unsigned long STEP_TIMEOUT = 10000;
+
+static pid_t stubPid = -1;
+static bool stubUp = false;
+// Never destroyed, like the firmware's - the pool's worker runs until exit
+static LichessConnectionPool* pool;
+static LichessAPI* api;
+static String gameId;
+static String gameMoves;   // Moves of the last position the stream sent
+static String gameStatus;
+
+void setUp() {
+    if (!stubUp) {
+        TEST_IGNORE_MESSAGE("lichess_stub_server.py not running - needs python3");
+    }
+}
+
+void tearDown() {}
+
+// tools/ next to test/, whether __FILE__ is absolute or relative to the project
+static std::string stubScript() {
+    std::string file = __FILE__;
+    size_t test = file.rfind("test/test_lichess_stub/");
+    return (test == std::string::npos ? std::string() : file.substr(0, test)) + "tools/lichess_stub_server.py";
+}
+
+static bool startStub() {
+    std::string script = stubScript();
+    std::string port = std::to_string(STUB_PORT);
+    stubPid = fork();
+    if (stubPid == 0) {
+        execlp("python3", "python3", script.c_str(), "--no-tls", "--host", "127.0.0.1", "--port", port.c_str(),
+               "--ai-delay", "0.05", (char*)nullptr);
+        _exit(127);
+    }
+    if (stubPid < 0) {
+        return false;
+    }
+
+    hostServer = {"127.0.0.1", STUB_PORT};
+    WiFiClient probe;
+    for (int i = 0; i < 100; i++) {
+        if (waitpid(stubPid, nullptr, WNOHANG) == stubPid) {
+            stubPid = -1;
+            return false;
+        }
+        if (probe.connect("127.0.0.1", STUB_PORT)) {
+            return true;
+        }
+        delay(50);
+    }
+    return false;
+}
+
+static void stopStub() {
+    if (stubPid > 0) {
+        kill(stubPid, SIGTERM);
+        waitpid(stubPid, nullptr, 0);
+    }
+}
+
+// What loop() and LichessWebHandler do: run the API and follow the game stream
+static void pump() {
+    api->process();
+    char* eventJson;
+    size_t length;
+    if (!api->isStreaming() || !api->processStreamEvents(eventJson, length) || length < 2) {
+        delay(1);
+        return;
+    }
+
+    JsonDocument doc;
+    if (deserializeJson(doc, eventJson, length)) {
+        return;
+    }
+    const char* type = doc["type"] | "";
+    JsonVariant state;
+    if (strcmp(type, "gameFull") == 0) {
+        state = doc["state"];
+    } else if (strcmp(type, "gameState") == 0) {
+        state = doc.as<JsonVariant>();
+    } else {
+        return;
+    }
+    gameMoves = state["moves"] | "";
+    gameStatus = state["status"] | "";
+
+    // Playing white: our turn after an even number of plies
+    int plies = gameMoves.length() == 0 ? 0 : 1;
+    for (unsigned int i = 0; i < gameMoves.length(); i++) {
+        plies += gameMoves[i] == ' ';
+    }
+    if (gameStatus == "started") {
+        api->setPlayerToMove(plies % 2 == 0);
+    } else {
+        api->endGame(gameId, "Game over");
+    }
+}
+
+// Pump until the command reports done or failed; returns its final status
+static LichessAPI::CommandStatus waitForCommand(uint32_t commandId, String* detail = nullptr) {
+    unsigned long start = millis();
+    while (millis() - start < STEP_TIMEOUT) {
+        pump();
+        LichessAPI::CommandUpdate update;
+        while (api->popCommandUpdate(update)) {
+            if (update.id == commandId && update.status != LichessAPI::CMD_QUEUED &&
+                update.status != LichessAPI::CMD_RUNNING) {
+                if (detail) {
+                    *detail = update.detail;
+                }
+                return update.status;
+            }
+        }
+    }
+    TEST_FAIL_MESSAGE("Command did not finish");
+    return LichessAPI::CMD_FAILED;
+}
+
+static void waitForMoves(const char* moves) {
+    unsigned long start = millis();
+    while (millis() - start < STEP_TIMEOUT && gameMoves != moves) {
+        pump();
+    }
+    TEST_ASSERT_EQUAL_STRING(moves, gameMoves.c_str());
+}
+
+void test_account_check() {
+    String username;
+    LichessAPI::AccountCheck result;
+    unsigned long start = millis();
+    while ((result = api->pollAccountCheck(username)) == LichessAPI::ACCOUNT_CHECK_PENDING &&
+           millis() - start < STEP_TIMEOUT) {
+        delay(5);
+    }
+    TEST_ASSERT_EQUAL(LichessAPI::ACCOUNT_CHECK_OK, result);
+    TEST_ASSERT_EQUAL_STRING("StubUser", username.c_str());
+}
+
+void test_create_game_opens_stream() {
+    uint32_t id = api->queueCreateGame(3, 600, 0, "white");
+    TEST_ASSERT_EQUAL(LichessAPI::CMD_DONE, waitForCommand(id, &gameId));
+    TEST_ASSERT_EQUAL(8, gameId.length());
+
+    unsigned long start = millis();
+    while (millis() - start < STEP_TIMEOUT && gameStatus != "started") {
+        pump();
+    }
+    TEST_ASSERT_TRUE(api->isStreaming());
+    TEST_ASSERT_EQUAL_STRING("", gameMoves.c_str());
+}
+
+// The second move is queued at once and held until the AI's reply arrives on the stream
+void test_premove_waits_for_reply() {
+    uint32_t first = api->queueMove(gameId, "e2e4");
+    uint32_t premove = api->queueMove(gameId, "g1f3");
+    TEST_ASSERT_EQUAL(LichessAPI::CMD_DONE, waitForCommand(first));
+    TEST_ASSERT_EQUAL(LichessAPI::CMD_DONE, waitForCommand(premove));
+    waitForMoves("e2e4 e7e5 g1f3 b8c6");
+}
+
+void test_resign_ends_game() {
+    uint32_t id = api->queueResign(gameId);
+    TEST_ASSERT_EQUAL(LichessAPI::CMD_DONE, waitForCommand(id));
+
+    // Resigning closed the game stream - on the device the account stream's
+    // gameFinish reopens it for the final state
+    if (!api->isStreaming()) {
+        TEST_ASSERT_TRUE(api->startStream(gameId));
+    }
+
+    unsigned long start = millis();
+    while (millis() - start < STEP_TIMEOUT && gameStatus != "resign") {
+        pump();
+    }
+    TEST_ASSERT_EQUAL_STRING("resign", gameStatus.c_str());
+}
+
+int main() {
+    stubUp = startStub();
+    if (stubUp) {
+        pool = new LichessConnectionPool();
+        api = new LichessAPI();
+        pool->begin();
+        api->setConnectionPool(pool);
+        api->begin("stub-token");  // The stub takes any token
+    }
+
+    UNITY_BEGIN();
+    RUN_TEST(test_account_check);
+    RUN_TEST(test_create_game_opens_stream);
+    RUN_TEST(test_premove_waits_for_reply);
+    RUN_TEST(test_resign_ends_game);
+    int failures = UNITY_END();
+
+    stopStub();
+    return failures;
+}
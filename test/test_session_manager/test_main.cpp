@@ -0,0 +1,235 @@
+#include <unity.h>
+#include <atomic>
+#include <map>
+#include <random>
+#include <thread>
+#include <vector>
+#include "SessionManager.h"
+
+// Request handlers create, look up and delete sessions from AsyncTCP while
+// loop() walks the slots and retires them. Here each side is a host thread;
+// build with the native env's sanitizers to catch what the counters miss.
+
+static const int HANDLER_THREADS = 4;
+static const int STRESS_SECONDS = 2;
+
+void setUp() {}
+void tearDown() {}
+
+// Lookups must never see another session, a torn game ID, or a deleted session
+void test_concurrent_lifecycle() {
+    SessionManager sessions;
+    std::atomic<bool> stop(false);
+    std::atomic<long> created(0), deleted(0), lookups(0), walks(0), torn(0), wrong(0);
+
+    std::vector<std::thread> handlers;
+    for (int t = 0; t < HANDLER_THREADS; t++) {
+        handlers.emplace_back([&, t] {
+            // Same length, one repeated letter each - a mix of two is a torn read
+            const char* games[2] = {"AAAAAAAAAAAA", "BBBBBBBBBBBB"};
+            std::vector<String> stale;
+            int flips = 0;
+            while (!stop) {
+                String id = sessions.createSession(String("10.0.0.") + String(t));
+                if (id.length() == 0) {
+                    std::this_thread::yield();  // Table full until loop() frees a retired slot
+                    continue;
+                }
+                created++;
+                for (int i = 0; i < 50; i++) {
+                    flips++;
+                    sessions.setGameId(id, games[flips & 1], (flips & 1) ? "white" : "black");
+                    SessionManager::ReadGuard guard(&sessions);
+                    Session* session = sessions.getSession(id);
+                    lookups++;
+                    if (!session) {
+                        wrong++;
+                        break;
+                    }
+                    if (id != session->sessionId) {
+                        wrong++;
+                    }
+                    String gameId = sessions.getGameId(session);
+                    if (gameId.length() != 12) {
+                        torn++;
+                    }
+                    for (unsigned int k = 1; k < gameId.length(); k++) {
+                        if (gameId[k] != gameId[0]) {
+                            torn++;
+                            break;
+                        }
+                    }
+                    sessions.updateActivity(id);
+                    sessions.setGameActive(id, true);
+                    sessions.incrementMessageCount(id);
+                }
+                if (sessions.deleteSession(id)) {
+                    deleted++;
+                }
+                // A reused slot must not answer to the IDs it had before
+                stale.push_back(id);
+                if (stale.size() > 64) {
+                    stale.erase(stale.begin());
+                }
+                SessionManager::ReadGuard guard(&sessions);
+                for (const String& old : stale) {
+                    if (sessions.getSession(old)) {
+                        wrong++;
+                    }
+                }
+            }
+        });
+    }
+
+    std::thread loop([&] {
+        while (!stop) {
+            for (int slot = 0; slot < MAX_SESSIONS; slot++) {
+                Session* session = sessions.getSessionAt(slot);
+                if (session && sessions.getSessionSlot(session) != slot) {
+                    wrong++;
+                }
+                if (session && session->gameActive) {
+                    session->gameActive = false;  // As a game end event does
+                }
+            }
+            sessions.getSessionByGameId("AAAAAAAAAAAA");
+            sessions.getSessionsJSON();
+            sessions.processAllSessions();
+            sessions.cleanupExpiredSessions();
+            walks++;
+        }
+    });
+
+    std::this_thread::sleep_for(std::chrono::seconds(STRESS_SECONDS));
+    stop = true;
+    for (std::thread& handler : handlers) {
+        handler.join();
+    }
+    loop.join();
+    sessions.cleanupExpiredSessions();
+
+    printf("created %ld deleted %ld lookups %ld walks %ld\n", created.load(), deleted.load(), lookups.load(), walks.load());
+    TEST_ASSERT_GREATER_THAN(0, created.load());
+    TEST_ASSERT_GREATER_THAN(0, walks.load());
+    TEST_ASSERT_EQUAL(created.load(), deleted.load());
+    TEST_ASSERT_EQUAL(0, torn.load());
+    TEST_ASSERT_EQUAL(0, wrong.load());
+    TEST_ASSERT_EQUAL(0, sessions.getActiveSessionCount());
+}
+
+// The game ID index against a plain map, through many collisions: a dozen game
+// IDs over the whole table, so deletes keep shifting entries back
+void test_game_index_matches_model() {
+    SessionManager sessions;
+    std::mt19937 rng(1);
+    std::map<String, String> gameOf;  // Session ID -> game ID
+    long mismatches = 0;
+
+    for (int step = 0; step < 100000; step++) {
+        int op = rng() % 4;
+        if (op == 0) {
+            String id = sessions.createSession("1.2.3.4");
+            if (id.length()) {
+                gameOf[id] = "";
+            }
+            sessions.cleanupExpiredSessions();
+        } else if (op == 1 && !gameOf.empty()) {
+            auto it = gameOf.begin();
+            std::advance(it, rng() % gameOf.size());
+            String gameId = rng() % 5 == 0 ? String("") : String("g") + String((int)(rng() % 12));
+            // One session per game, as Lichess has it
+            bool taken = false;
+            for (const auto& entry : gameOf) {
+                if (entry.first != it->first && gameId.length() && entry.second == gameId) {
+                    taken = true;
+                }
+            }
+            if (taken) {
+                continue;
+            }
+            sessions.setGameId(it->first, gameId);
+            it->second = gameId;
+        } else if (op == 2 && !gameOf.empty()) {
+            auto it = gameOf.begin();
+            std::advance(it, rng() % gameOf.size());
+            sessions.deleteSession(it->first);
+            gameOf.erase(it);
+            sessions.cleanupExpiredSessions();
+        } else {
+            for (int k = 0; k < 12; k++) {
+                String gameId = String("g") + String(k);
+                String expected = "";
+                for (const auto& entry : gameOf) {
+                    if (entry.second == gameId) {
+                        expected = entry.first;
+                    }
+                }
+                if (sessions.getSessionByGameId(gameId) != expected) {
+                    mismatches++;
+                }
+                Session* session = sessions.getSessionForGame(gameId);
+                if ((session ? String(session->sessionId) : String("")) != expected) {
+                    mismatches++;
+                }
+            }
+            if (sessions.getSessionByGameId("") != "") {
+                mismatches++;
+            }
+        }
+    }
+    TEST_ASSERT_EQUAL(0, mismatches);
+}
+
+// loop() looks games up lock-free while handlers move their sessions between games
+void test_game_index_concurrent_lookup() {
+    SessionManager sessions;
+    std::atomic<bool> stop(false);
+    std::atomic<long> hits(0), wrong(0);
+    String ids[HANDLER_THREADS];
+    for (int t = 0; t < HANDLER_THREADS; t++) {
+        ids[t] = sessions.createSession("10.0.0.1");
+        TEST_ASSERT_TRUE(ids[t].length() > 0);
+    }
+
+    std::vector<std::thread> handlers;
+    for (int t = 0; t < HANDLER_THREADS; t++) {
+        handlers.emplace_back([&, t] {
+            int flips = 0;
+            while (!stop) {
+                sessions.setGameId(ids[t], String("game") + String(t * 2 + (flips++ & 1)));
+            }
+        });
+    }
+    std::thread loop([&] {
+        while (!stop) {
+            for (int g = 0; g < HANDLER_THREADS * 2; g++) {
+                String owner = sessions.getSessionByGameId(String("game") + String(g));
+                if (owner.length() == 0) {
+                    continue;  // Between games - a miss is fine, the wrong session is not
+                }
+                hits++;
+                if (owner != ids[g / 2]) {
+                    wrong++;
+                }
+            }
+        }
+    });
+
+    std::this_thread::sleep_for(std::chrono::seconds(STRESS_SECONDS));
+    stop = true;
+    for (std::thread& handler : handlers) {
+        handler.join();
+    }
+    loop.join();
+
+    TEST_ASSERT_GREATER_THAN(0, hits.load());
+    TEST_ASSERT_EQUAL(0, wrong.load());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_concurrent_lifecycle);
+    RUN_TEST(test_game_index_matches_model);
+    RUN_TEST(test_game_index_concurrent_lookup);
+    return UNITY_END();
+}
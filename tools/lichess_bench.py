@@ -0,0 +1,309 @@
+#!/usr/bin/env python3
+"""
+Lichess Replay Benchmark - move round-trip and stream latency percentiles
+Starts lichess_stub_server.py in-process, then replays its scripted game
+through the ESP32's web API from one or more browser sessions at once:
+
+  move round-trip   POST /api/lichess/move until the device relays the
+                    position with that move on /api/lichess/stream
+  stream latency    stub writes the AI's reply to the game stream until
+                    the device relays it (same clock - the stub runs here)
+
+  SSE fanout        bytes and events every SSE client received - each
+                    session listens on its own channel (--clients per
+                    session)
+
+The firmware must be built with env:lichess_stub pointing at this machine
+and have any Lichess token set. --direct plays against the stub without a
+device, as a baseline for the network and the stub itself.
+"""
+
+import http.client
+import json
+import math
+import queue
+import ssl
+import threading
+import time
+import urllib.parse
+
+import lichess_stub_server as stub_server
+
+EVENT_TIMEOUT = 30.0
+
+
+class DeviceSession:
+    """One browser session on the ESP32 - events come from its own SSE channel.
+    Extra clients only count bytes."""
+
+    def __init__(self, device, clients=1):
+        self.device = device
+        self.session_id = self.post('/api/session/create', {})['sessionId']
+        events = DeviceEvents(device, self.session_id)
+        for _ in range(clients - 1):
+            DeviceEvents(device, self.session_id)
+        self.events = events
+        self.queue = events.subscribe(self.session_id)
+
+    def post(self, path, form):
+        conn = http.client.HTTPConnection(self.device, 80, timeout=EVENT_TIMEOUT)
+        headers = {'Content-Type': 'application/x-www-form-urlencoded'}
+        if getattr(self, 'session_id', None):
+            headers['X-Session-ID'] = self.session_id
+        conn.request('POST', path, urllib.parse.urlencode(form), headers)
+        response = conn.getresponse()
+        body = response.read().decode()
+        conn.close()
+        if response.status >= 400:
+            raise RuntimeError(f"{path}: HTTP {response.status} {body}")
+        return json.loads(body) if body else {}
+
+    def create_game(self, color):
+        self.post('/api/lichess/create-game', {'color': color, 'level': 1, 'time': 600})
+        while True:
+            kind, data, _ = self.next_event()
+            if kind == 'lichess-command' and data.get('command') == 'create':
+                if data.get('status') == 'done':
+                    return data.get('detail')
+                if data.get('status') in ('failed', 'cancelled'):
+                    raise RuntimeError(f"Game creation {data.get('status')}: {data.get('detail')}")
+
+    def move(self, uci):
+        self.post('/api/lichess/move', {'move': uci})
+
+    def resign(self):
+        self.post('/api/lichess/resign', {})
+
+    def next_event(self):
+        return self.queue.get(timeout=EVENT_TIMEOUT)
+
+
+class DeviceEvents:
+    """Reads a session's /api/lichess/stream channel and hands its events to the session."""
+
+    readers = []
+
+    def __init__(self, device, session_id):
+        self.queues = {}
+        self.lock = threading.Lock()
+        self.bytes = 0
+        self.events = 0
+        path = '/api/lichess/stream?' + urllib.parse.urlencode({'sessionId': session_id})
+        self.subscribe(session_id)
+        conn = http.client.HTTPConnection(device, 80)
+        conn.request('GET', path, headers={'Accept': 'text/event-stream'})
+        self.response = conn.getresponse()
+        if self.response.status != 200:
+            raise RuntimeError(f"{path}: HTTP {self.response.status}")
+        DeviceEvents.readers.append(self)
+        threading.Thread(target=self.read, daemon=True).start()
+
+    def subscribe(self, session_id):
+        with self.lock:
+            return self.queues.setdefault(session_id, queue.Queue())
+
+    def read(self):
+        kind, data = None, []
+        while True:
+            line = self.response.fp.readline()
+            if not line:
+                return
+            self.bytes += len(line)
+            line = line.decode().rstrip('\r\n')
+            if line.startswith('event:'):
+                kind = line[6:].strip()
+            elif line.startswith('data:'):
+                data.append(line[5:].strip())
+            elif not line and data:
+                self.events += 1
+                self.dispatch(kind, '\n'.join(data), time.monotonic())
+                kind, data = None, []
+
+    def dispatch(self, kind, payload, received):
+        try:
+            message = json.loads(payload)
+        except ValueError:
+            return
+        body = message.get('event', {}) if kind == 'lichess-event' else message
+        with self.lock:
+            target = self.queues.get(message.get('sessionId'))
+        if target:
+            target.put((kind, body, received))
+
+
+class DirectSession:
+    """Plays straight against the stub, the way the ESP32 would"""
+
+    def __init__(self, host, port):
+        self.host = host
+        self.port = port
+        self.context = ssl._create_unverified_context()
+        self.queue = queue.Queue()
+        self.game_id = None
+
+    def request(self, method, path, form=None):
+        conn = http.client.HTTPSConnection(self.host, self.port, context=self.context, timeout=EVENT_TIMEOUT)
+        conn.request(method, path, urllib.parse.urlencode(form or {}),
+                     {'Authorization': 'Bearer stub', 'Content-Type': 'application/x-www-form-urlencoded'})
+        response = conn.getresponse()
+        body = response.read().decode()
+        conn.close()
+        if response.status >= 400:
+            raise RuntimeError(f"{path}: HTTP {response.status} {body}")
+        return json.loads(body)
+
+    def create_game(self, color):
+        self.game_id = self.request('POST', '/api/challenge/ai', {'color': color, 'level': 1})['id']
+        threading.Thread(target=self.read_stream, daemon=True).start()
+        return self.game_id
+
+    def read_stream(self):
+        conn = http.client.HTTPSConnection(self.host, self.port, context=self.context)
+        conn.request('GET', f'/api/board/game/stream/{self.game_id}', headers={'Authorization': 'Bearer stub'})
+        response = conn.getresponse()
+        while True:
+            line = response.fp.readline()
+            if not line:
+                return
+            if line.strip():
+                self.queue.put(('lichess-event', json.loads(line), time.monotonic()))
+
+    def move(self, uci):
+        self.request('POST', f'/api/board/game/{self.game_id}/move/{uci}')
+
+    def resign(self):
+        self.request('POST', f'/api/board/game/{self.game_id}/resign')
+
+    def next_event(self):
+        return self.queue.get(timeout=EVENT_TIMEOUT)
+
+
+def wait_for_plies(session, plies):
+    """Receipt time of the first position with at least this many plies"""
+    while True:
+        kind, event, received = session.next_event()
+        if kind != 'lichess-event':
+            continue
+        if event.get('type') == 'gameFull':
+            event = event.get('state', {})
+        elif event.get('type') != 'gameState':
+            continue
+        if len(event.get('moves', '').split()) >= plies:
+            return received
+
+
+class Results:
+    def __init__(self):
+        self.move_rtt = []
+        self.stream_latency = []
+        self.errors = []
+        self.lock = threading.Lock()
+
+    def add(self, samples, value):
+        with self.lock:
+            samples.append(value)
+
+
+def play_games(make_session, stub, games, results):
+    try:
+        session = make_session()
+        for _ in range(games):
+            game_id = session.create_game('white')
+            game = stub.games.get(game_id)
+            wait_for_plies(session, 0)
+
+            for ply in range(0, len(stub.script), 2):
+                start = time.monotonic()
+                session.move(stub.script[ply])
+                results.add(results.move_rtt, wait_for_plies(session, ply + 1) - start)
+
+                if ply + 1 < len(stub.script):
+                    received = wait_for_plies(session, ply + 2)
+                    emitted = game.emitted.get(ply + 2) if game else None
+                    if emitted:
+                        results.add(results.stream_latency, received - emitted)
+
+            session.resign()
+    except (queue.Empty, RuntimeError, OSError) as e:
+        with results.lock:
+            results.errors.append(f"{type(e).__name__}: {e}" if str(e) else "Timed out waiting for an event")
+
+
+def report_fanout(sessions):
+    readers = DeviceEvents.readers
+    if not readers:
+        return
+    total_bytes = sum(r.bytes for r in readers)
+    total_events = sum(r.events for r in readers)
+    print(f"SSE fanout             {len(readers)} client(s) for {sessions} session(s): "
+          f"{total_events} events, {total_bytes / 1024:.1f} KB "
+          f"({total_bytes / len(readers) / 1024:.1f} KB per client)")
+
+
+def percentile(samples, p):
+    """Nearest-rank percentile"""
+    ordered = sorted(samples)
+    return ordered[max(0, math.ceil(p / 100.0 * len(ordered)) - 1)]
+
+
+def report(name, samples):
+    if not samples:
+        print(f"{name:<22} no samples")
+        return
+    ms = [s * 1000 for s in samples]
+    print(f"{name:<22} n={len(ms):<4} p50={percentile(ms, 50):7.1f}  p90={percentile(ms, 90):7.1f}  "
+          f"p99={percentile(ms, 99):7.1f}  max={max(ms):7.1f} ms")
+
+
+if __name__ == '__main__':
+    import argparse
+
+    parser = argparse.ArgumentParser(description='Replay scripted games through the ESP32 against a local Lichess stub')
+    parser.add_argument('device', nargs='?', help='ESP32 IP address (omit with --direct)')
+    parser.add_argument('--direct', action='store_true', help='Play against the stub directly, no device')
+    parser.add_argument('--port', type=int, default=8443, help='Stub port (match LICHESS_SERVER_PORT)')
+    parser.add_argument('--sessions', type=int, default=1, help='Browser sessions playing at once')
+    parser.add_argument('--games', type=int, default=1, help='Games per session')
+    parser.add_argument('--clients', type=int, default=1, help='SSE clients listening per session')
+    parser.add_argument('--latency', type=float, default=0.0, help='Stub: seconds added to every API response')
+    parser.add_argument('--jitter', type=float, default=0.0, help='Stub: random +/- seconds on top of --latency')
+    parser.add_argument('--drop', type=float, default=0.0, help='Stub: fraction of requests dropped')
+    parser.add_argument('--rate-limit', type=float, default=0.0, help='Stub: fraction of requests answered 429')
+    parser.add_argument('--retry-after', type=int, default=60, help='Stub: Retry-After seconds with a 429')
+    parser.add_argument('--ai-delay', type=float, default=0.2, help='Stub: seconds the AI takes to reply')
+    parser.add_argument('--script', help='File of UCI moves to replay (default: a Ruy Lopez)')
+    args = parser.parse_args()
+
+    if not args.direct and not args.device:
+        parser.error('give the device IP, or --direct')
+
+    stub = stub_server.StubLichess(latency=args.latency, jitter=args.jitter, drop_rate=args.drop,
+                                   rate_limit=args.rate_limit, retry_after=args.retry_after,
+                                   ai_delay=args.ai_delay,
+                                   script=stub_server.load_script(args.script) if args.script else None)
+    server = stub_server.start_in_thread(stub, port=args.port)
+
+    if args.direct:
+        make_session = lambda: DirectSession('127.0.0.1', args.port)
+    else:
+        make_session = lambda: DeviceSession(args.device, clients=args.clients)
+
+    results = Results()
+    started = time.monotonic()
+    workers = [threading.Thread(target=play_games, args=(make_session, stub, args.games, results))
+               for _ in range(args.sessions)]
+    for worker in workers:
+        worker.start()
+    for worker in workers:
+        worker.join()
+    elapsed = time.monotonic() - started
+    server.shutdown()
+
+    print(f"\n{args.sessions} session(s) x {args.games} game(s) in {elapsed:.1f}s "
+          f"({len(results.move_rtt) / elapsed:.2f} moves/s)")
+    report('Move round-trip', results.move_rtt)
+    report('Stream event latency', results.stream_latency)
+    report_fanout(args.sessions)
+    print(f"Stub: {stub.counters}")
+    for error in results.errors:
+        print(f"Error: {error}")
@@ -0,0 +1,419 @@
+#!/usr/bin/env python3
+"""
+Lichess Stub Server - local stand-in for the lichess.org board API
+Serves the subset the ESP32 uses (account, challenge/ai, game and event
+streams, move, resign, draw) over HTTPS with injectable latency, dropped
+connections and 429 rate limiting.
+
+The AI opponent replays a scripted game: every move the player makes that
+matches the script is answered with the script's next move. Off-script
+moves are answered with a random legal move if python-chess is installed,
+otherwise the opponent stops replying.
+
+Build the firmware with env:lichess_stub (set LICHESS_SERVER_HOST to this
+machine's address) and any API token - the stub accepts every token.
+"""
+
+import json
+import os
+import random
+import socket
+import ssl
+import subprocess
+import tempfile
+import threading
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+try:
+    import chess
+except ImportError:
+    chess = None
+
+# Closed Ruy Lopez, Chigorin - 22 plies, all legal
+DEFAULT_SCRIPT = ("e2e4 e7e5 g1f3 b8c6 f1b5 a7a6 b5a4 g8f6 e1g1 f8e7 f1e1 "
+                  "b7b5 a4b3 d7d6 c2c3 e8g8 h2h3 c6a5 b3c2 c7c5 d2d4 d8c7").split()
+
+HEARTBEAT_INTERVAL = 6.0  # Lichess sends an empty line about this often
+
+
+class StubGame:
+    """One game against the scripted AI, with the streams watching it"""
+
+    def __init__(self, game_id, color, clock_ms, increment_ms, script):
+        self.id = game_id
+        self.color = color
+        self.moves = []
+        self.status = 'started'
+        self.winner = None
+        self.wtime = clock_ms
+        self.btime = clock_ms
+        self.inc = increment_ms
+        self.script = script
+        self.on_script = True
+        self.board = chess.Board() if chess else None
+        self.streams = []        # queue-like lists of pending lines, one per open stream
+        self.emitted = {}        # ply count -> time.monotonic() the state first went out
+        self.lock = threading.Lock()
+
+    def player_to_move(self):
+        white_to_move = len(self.moves) % 2 == 0
+        return white_to_move == (self.color == 'white')
+
+    def state(self):
+        state = {'type': 'gameState', 'moves': ' '.join(self.moves), 'wtime': self.wtime,
+                 'btime': self.btime, 'winc': self.inc, 'binc': self.inc, 'status': self.status}
+        if self.winner:
+            state['winner'] = self.winner
+        return state
+
+    def full(self):
+        return {'type': 'gameFull', 'id': self.id, 'rated': False, 'variant': {'key': 'standard'},
+                'white': {'id': 'stubuser', 'name': 'StubUser'} if self.color == 'white' else {'aiLevel': 3},
+                'black': {'id': 'stubuser', 'name': 'StubUser'} if self.color == 'black' else {'aiLevel': 3},
+                'initialFen': 'startpos', 'state': self.state()}
+
+    def push_state(self):
+        # Caller holds self.lock
+        line = json.dumps(self.state())
+        for stream in self.streams:
+            stream.append(line)
+
+    def play(self, uci):
+        """Apply a move; returns an error message or None"""
+        if self.status != 'started':
+            return 'Game already over'
+        if self.board is not None:
+            try:
+                move = chess.Move.from_uci(uci)
+            except ValueError:
+                return 'Invalid move'
+            if move not in self.board.legal_moves:
+                return 'Illegal move'
+            self.board.push(move)
+        ply = len(self.moves)
+        if ply >= len(self.script) or self.script[ply] != uci:
+            self.on_script = False
+        self.moves.append(uci)
+        self.push_state()
+        return None
+
+    def ai_reply(self):
+        ply = len(self.moves)
+        if self.on_script and ply < len(self.script):
+            return self.script[ply]
+        if self.board is not None and not self.board.is_game_over():
+            return random.choice(list(self.board.legal_moves)).uci()
+        return None
+
+    def end(self, status, winner):
+        self.status = status
+        self.winner = winner
+        self.push_state()
+        for stream in self.streams:
+            stream.append(None)  # Close after the final state
+
+
+class StubLichess:
+    """Game table and fault injection settings shared by all handler threads"""
+
+    def __init__(self, latency=0.0, jitter=0.0, drop_rate=0.0, rate_limit=0.0, retry_after=60,
+                 ai_delay=0.5, script=None, verbose=False):
+        self.latency = latency
+        self.jitter = jitter
+        self.drop_rate = drop_rate
+        self.rate_limit = rate_limit
+        self.retry_after = retry_after
+        self.ai_delay = ai_delay
+        self.script = script or DEFAULT_SCRIPT
+        self.verbose = verbose
+        self.games = {}
+        self.event_streams = []
+        self.lock = threading.Lock()
+        self.counters = {'requests': 0, 'dropped': 0, 'rate_limited': 0, 'moves': 0}
+
+    def new_game(self, color, clock_ms, increment_ms):
+        game_id = ''.join(random.choice('abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789')
+                          for _ in range(8))
+        if color == 'random':
+            color = random.choice(['white', 'black'])
+        game = StubGame(game_id, color, clock_ms, increment_ms, self.script)
+        with self.lock:
+            self.games[game_id] = game
+            start = json.dumps({'type': 'gameStart', 'game': {
+                'gameId': game_id, 'fullId': game_id + 'xxxx', 'color': color,
+                'isMyTurn': color == 'white', 'source': 'ai', 'opponent': {'ai': 3}}})
+            for stream in self.event_streams:
+                stream.append(start)
+        if color == 'black':
+            self.schedule_ai(game)
+        return game
+
+    def schedule_ai(self, game):
+        def reply():
+            with game.lock:
+                if game.status != 'started' or game.player_to_move():
+                    return
+                uci = game.ai_reply()
+                if uci is None:
+                    if self.verbose:
+                        print(f"[{game.id}] off script - opponent not replying")
+                    return
+                game.play(uci)
+                if self.verbose:
+                    print(f"[{game.id}] AI plays {uci}")
+        threading.Timer(self.ai_delay, reply).start()
+
+    def finish(self, game, status, winner):
+        with game.lock:
+            game.end(status, winner)
+        finish = json.dumps({'type': 'gameFinish', 'game': {'gameId': game.id, 'status': {'name': status}}})
+        with self.lock:
+            for stream in self.event_streams:
+                stream.append(finish)
+
+
+class StubHandler(BaseHTTPRequestHandler):
+    protocol_version = 'HTTP/1.1'  # Keep-alive, like lichess.org
+    stub = None                    # Set by make_server()
+
+    def log_message(self, fmt, *args):
+        if self.stub.verbose:
+            super().log_message(fmt, *args)
+
+    def inject_faults(self):
+        """Latency, drops and 429s - returns False if the request was answered or dropped"""
+        stub = self.stub
+        stub.counters['requests'] += 1
+        delay = stub.latency + random.uniform(-stub.jitter, stub.jitter)
+        if delay > 0:
+            time.sleep(delay)
+        if random.random() < stub.drop_rate:
+            stub.counters['dropped'] += 1
+            self.close_connection = True
+            self.connection.shutdown(socket.SHUT_RDWR)
+            return False
+        if random.random() < stub.rate_limit:
+            stub.counters['rate_limited'] += 1
+            self.send_json(429, {'error': 'Too many requests. Try again later.'},
+                           {'Retry-After': str(stub.retry_after)})
+            return False
+        return True
+
+    def send_json(self, code, body, headers=None):
+        data = json.dumps(body).encode()
+        self.send_response(code)
+        self.send_header('Content-Type', 'application/json')
+        self.send_header('Content-Length', str(len(data)))
+        for name, value in (headers or {}).items():
+            self.send_header(name, value)
+        self.end_headers()
+        self.wfile.write(data)
+
+    def read_form(self):
+        length = int(self.headers.get('Content-Length') or 0)
+        body = self.rfile.read(length).decode() if length else ''
+        form = {}
+        for pair in body.split('&'):
+            if '=' in pair:
+                key, value = pair.split('=', 1)
+                form[key] = value
+        return form
+
+    def do_GET(self):
+        if not self.inject_faults():
+            return
+        path = self.path.split('?')[0]
+        if path == '/api/account':
+            self.send_json(200, {'id': 'stubuser', 'username': 'StubUser', 'title': 'BOT'})
+        elif path == '/api/stream/event':
+            self.stream_events()
+        elif path.startswith('/api/board/game/stream/'):
+            game = self.stub.games.get(path.rsplit('/', 1)[1])
+            if not game:
+                self.send_json(404, {'error': 'No such game'})
+                return
+            self.stream_game(game)
+        else:
+            self.send_json(404, {'error': 'Not found'})
+
+    def do_POST(self):
+        form = self.read_form()
+        if not self.inject_faults():
+            return
+        parts = self.path.split('?')[0].strip('/').split('/')
+
+        if parts[:3] == ['api', 'challenge', 'ai']:
+            clock = int(form.get('clock.limit', 600)) * 1000
+            increment = int(form.get('clock.increment', 0)) * 1000
+            game = self.stub.new_game(form.get('color', 'white'), clock, increment)
+            self.send_json(201, {'id': game.id, 'status': 'started', 'player': game.color,
+                                 'variant': {'key': 'standard'}, 'speed': 'rapid'})
+            return
+
+        # /api/board/game/{id}/move/{uci}, /resign, /draw/{yes|no}
+        if len(parts) >= 5 and parts[:3] == ['api', 'board', 'game']:
+            game = self.stub.games.get(parts[3])
+            if not game:
+                self.send_json(404, {'error': 'No such game'})
+                return
+            action = parts[4]
+            if action == 'move' and len(parts) == 6:
+                self.make_move(game, parts[5])
+            elif action == 'resign':
+                self.stub.finish(game, 'resign', 'black' if game.color == 'white' else 'white')
+                self.send_json(200, {'ok': True})
+            elif action == 'draw':
+                self.send_json(200, {'ok': True})  # The AI never accepts
+            else:
+                self.send_json(404, {'error': 'Not found'})
+            return
+
+        self.send_json(404, {'error': 'Not found'})
+
+    def make_move(self, game, uci):
+        with game.lock:
+            if not game.player_to_move():
+                error = 'Not your turn, or game already over'
+            else:
+                error = game.play(uci)
+        if error:
+            self.send_json(400, {'error': error})
+            return
+        self.stub.counters['moves'] += 1
+        self.send_json(200, {'ok': True})
+        self.stub.schedule_ai(game)
+
+    def start_stream(self):
+        # No Content-Length or chunking - the body runs until the connection closes
+        self.send_response(200)
+        self.send_header('Content-Type', 'application/x-ndjson')
+        self.send_header('Connection', 'close')
+        self.end_headers()
+        self.close_connection = True
+
+    def pump(self, pending, on_line=None):
+        """Write queued lines and heartbeats until the stream ends or the client leaves"""
+        last_write = time.monotonic()
+        try:
+            while True:
+                if pending:
+                    line = pending.pop(0)
+                    if line is None:
+                        return
+                    if on_line:
+                        on_line(line)
+                    self.wfile.write(line.encode() + b'\n')
+                    self.wfile.flush()
+                    last_write = time.monotonic()
+                elif time.monotonic() - last_write >= HEARTBEAT_INTERVAL:
+                    self.wfile.write(b'\n')
+                    self.wfile.flush()
+                    last_write = time.monotonic()
+                else:
+                    time.sleep(0.005)
+        except (BrokenPipeError, ConnectionResetError, ssl.SSLError, OSError):
+            pass
+
+    def stream_game(self, game):
+        self.start_stream()
+        pending = []
+
+        def record(line):
+            # When each position first reached a client - the benchmark's stream latency starts here
+            event = json.loads(line)
+            state = event.get('state', event)
+            plies = len(state.get('moves', '').split())
+            game.emitted.setdefault(plies, time.monotonic())
+
+        with game.lock:
+            pending.append(json.dumps(game.full()))
+            if game.status != 'started':
+                pending.append(None)
+            game.streams.append(pending)
+        try:
+            self.pump(pending, record)
+        finally:
+            with game.lock:
+                game.streams.remove(pending)
+
+    def stream_events(self):
+        self.start_stream()
+        pending = []
+        with self.stub.lock:
+            for game in self.stub.games.values():
+                if game.status == 'started':
+                    pending.append(json.dumps({'type': 'gameStart', 'game': {
+                        'gameId': game.id, 'color': game.color, 'isMyTurn': game.player_to_move()}}))
+            self.stub.event_streams.append(pending)
+        try:
+            self.pump(pending)
+        finally:
+            with self.stub.lock:
+                self.stub.event_streams.remove(pending)
+
+
+def self_signed_context(cert=None, key=None):
+    """TLS context - the ESP32 runs WiFiClientSecure insecure, so a throwaway cert will do"""
+    if not cert:
+        workdir = tempfile.mkdtemp(prefix='lichess-stub-')
+        cert = os.path.join(workdir, 'cert.pem')
+        key = os.path.join(workdir, 'key.pem')
+        subprocess.run(['openssl', 'req', '-x509', '-newkey', 'rsa:2048', '-nodes', '-days', '30',
+                        '-subj', '/CN=lichess-stub', '-keyout', key, '-out', cert],
+                       check=True, capture_output=True)
+    context = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+    context.load_cert_chain(cert, key)
+    return context
+
+
+def make_server(stub, host='0.0.0.0', port=8443, cert=None, key=None, use_tls=True):
+    handler = type('BoundStubHandler', (StubHandler,), {'stub': stub})
+    server = ThreadingHTTPServer((host, port), handler)
+    server.daemon_threads = True
+    if use_tls:
+        server.socket = self_signed_context(cert, key).wrap_socket(server.socket, server_side=True)
+    return server
+
+
+def start_in_thread(stub, **kwargs):
+    """Run the server in the background - used by lichess_bench.py"""
+    server = make_server(stub, **kwargs)
+    threading.Thread(target=server.serve_forever, daemon=True).start()
+    return server
+
+
+def load_script(path):
+    with open(path) as f:
+        return f.read().split()
+
+
+if __name__ == '__main__':
+    import argparse
+
+    parser = argparse.ArgumentParser(description='Local stand-in for the lichess.org board API')
+    parser.add_argument('--host', default='0.0.0.0', help='Address to listen on')
+    parser.add_argument('--port', type=int, default=8443, help='Port (match LICHESS_SERVER_PORT)')
+    parser.add_argument('--cert', help='TLS certificate (a self-signed one is generated if omitted)')
+    parser.add_argument('--key', help='TLS private key')
+    parser.add_argument('--no-tls', action='store_true', help='Plain HTTP (for curl, not the ESP32)')
+    parser.add_argument('--latency', type=float, default=0.0, help='Seconds added to every API response')
+    parser.add_argument('--jitter', type=float, default=0.0, help='Random +/- seconds on top of --latency')
+    parser.add_argument('--drop', type=float, default=0.0, help='Fraction of requests dropped without a response')
+    parser.add_argument('--rate-limit', type=float, default=0.0, help='Fraction of requests answered with 429')
+    parser.add_argument('--retry-after', type=int, default=60, help='Retry-After seconds sent with a 429')
+    parser.add_argument('--ai-delay', type=float, default=0.5, help='Seconds the AI takes to reply')
+    parser.add_argument('--script', help='File of UCI moves for the game to replay (default: a Ruy Lopez)')
+    parser.add_argument('-v', '--verbose', action='store_true', help='Log every request')
+    args = parser.parse_args()
+
+    stub = StubLichess(latency=args.latency, jitter=args.jitter, drop_rate=args.drop,
+                       rate_limit=args.rate_limit, retry_after=args.retry_after, ai_delay=args.ai_delay,
+                       script=load_script(args.script) if args.script else None, verbose=args.verbose)
+    server = make_server(stub, args.host, args.port, args.cert, args.key, not args.no_tls)
+    print(f"Lichess stub listening on {'http' if args.no_tls else 'https'}://{args.host}:{args.port}"
+          f" (python-chess {'found' if chess else 'not installed - scripted replies only'})")
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        print(f"\nStopped - {stub.counters}")